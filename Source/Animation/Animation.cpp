@@ -1,4 +1,5 @@
 /*
+Copyright (C) 2003, 2010 - Wolfire Games
 Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
 
 This file is part of Lugaru.
@@ -19,57 +20,100 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Animation/Animation.hpp"
 
+#include "Animation/AnimationDatabase.hpp"
 #include "Animation/Skeleton.hpp"
 #include "Game.hpp"
+#include "Utils/BinaryReader.hpp"
 #include "Utils/Folders.hpp"
 
+#include <cstring>
+#include <stdexcept>
+
 std::vector<Animation> Animation::animations;
 
-void Animation::loadAll()
-{
-#define DECLARE_ANIM(id, file, height, attack, ...) \
-    if (id < loadable_anim_end)                     \
-        animations.emplace_back(file, height, attack);
-#include "Animation.def"
-#undef DECLARE_ANIM
-}
+namespace {
 
-void AnimationFrame::loadBaseInfo(FILE* tfile)
+// Baked frames of the pack providing Animations/Animations.lad, loadAll() opens it
+AnimationDatabase database;
+// Resolved folder of the database, animations resolving elsewhere were overridden
+std::string databaseFolder;
+
+void openDatabase()
 {
-    // for each joint in the skeleton...
-    for (unsigned j = 0; j < joints.size(); j++) {
-        // read joint position
-        funpackf(tfile, "Bf Bf Bf", &joints[j].position.x, &joints[j].position.y, &joints[j].position.z);
+    database.close();
+    databaseFolder.clear();
+
+    std::string path = Folders::getResourcePath(AnimationDatabase::kFileName);
+    if (path.empty()) {
+        return;
     }
-    for (unsigned j = 0; j < joints.size(); j++) {
-        // read twist
-        funpackf(tfile, "Bf", &joints[j].twist);
+
+    // One read, or one copy out of the pack archive since animations get patched after loading
+    std::vector<unsigned char> bytes;
+    const unsigned char* archived;
+    size_t archivedSize;
+    if (Folders::getArchivedResource(path, &archived, &archivedSize)) {
+        bytes.assign(archived, archived + archivedSize);
+    } else {
+        FILE* tfile = fopen(path.c_str(), "rb");
+        if (tfile == NULL) {
+            return;
+        }
+        fseek(tfile, 0, SEEK_END);
+        long length = ftell(tfile);
+        fseek(tfile, 0, SEEK_SET);
+        if (length > 0) {
+            bytes.resize(length);
+            if (fread(bytes.data(), 1, length, tfile) != (size_t)length) {
+                bytes.clear();
+            }
+        }
+        fclose(tfile);
     }
-    for (unsigned j = 0; j < joints.size(); j++) {
-        // read onground (boolean)
-        unsigned char uch;
-        funpackf(tfile, "Bb", &uch);
-        joints[j].onground = (uch != 0);
+
+    if (!database.open(std::move(bytes))) {
+        LOG("Ignoring invalid animation database " + path);
+        return;
     }
-    // read frame speed (?)
-    funpackf(tfile, "Bf", &speed);
+    databaseFolder = path.substr(0, path.size() - strlen("Animations.lad"));
 }
 
-void AnimationFrame::loadTwist2(FILE* tfile)
+/* Frames baked from the very file an animation resolves to, nullptr otherwise */
+unsigned char* findBaked(const std::string& name, const std::string& sourcePath, unsigned& numframes, unsigned& numjoints)
 {
-    for (unsigned j = 0; j < joints.size(); j++) {
-        funpackf(tfile, "Bf", &joints[j].twist2);
+    const AnimationDatabase::Clip* clip = database.isOpen() ? database.find(name) : nullptr;
+    if (clip == nullptr || AnimationDatabase::toLower(sourcePath) != AnimationDatabase::toLower(databaseFolder + clip->name)) {
+        return nullptr;
     }
-}
 
-void AnimationFrame::loadLabel(FILE* tfile)
-{
-    funpackf(tfile, "Bf", &label);
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    if (!Folders::getResourceStamp(sourcePath, &sourceSize, &sourceTime) || sourceSize != clip->sourceSize) {
+        return nullptr;
+    }
+    // Archived animations can only change along with the database packed next to them
+    const unsigned char* archived;
+    size_t archivedSize;
+    if (!Folders::getArchivedResource(sourcePath, &archived, &archivedSize) && sourceTime != clip->sourceTime) {
+        return nullptr;
+    }
+
+    numframes = clip->numframes;
+    numjoints = clip->numjoints;
+    return database.data(*clip);
 }
 
-void AnimationFrame::loadWeaponTarget(FILE* tfile)
+} // namespace
+
+void Animation::loadAll()
 {
-    funpackf(tfile, "Bf Bf Bf", &weapontarget.x, &weapontarget.y, &weapontarget.z);
+    openDatabase();
+
+#define DECLARE_ANIM(id, file, height, attack, ...) \
+    if (id < loadable_anim_end)                     \
+        animations.emplace_back(file, height, attack);
+#include "Animation.def"
+#undef DECLARE_ANIM
 }
 
 Animation::Animation()
@@ -85,65 +129,80 @@ Animation::Animation()
 Animation::Animation(const std::string& filename, anim_height_type aheight, anim_attack_type aattack)
     : Animation()
 {
-    FILE* tfile;
-    int numframes;
-    unsigned i;
-
     LOGFUNC;
 
     // Changing the filename into something the OS can understand
     std::string filepath = Folders::getResourcePath("Animations/" + filename);
 
-    LOG(std::string("Loading animation... ") + filepath);
-
     height = aheight;
     attack = aattack;
 
-    Game::LoadingScreen();
-
-    // read file in binary mode
-    tfile = Folders::openMandatoryFile(filepath, "rb");
-
-    // read numframes, joints to know how much memory to allocate
-    funpackf(tfile, "Bi Bi", &numframes, &numjoints);
-
-    // allocate memory for everything
+    unsigned numframes = 0;
+    unsigned jointcount = 0;
+    unsigned char* baked = findBaked(filename, filepath, numframes, jointcount);
+    if (baked != nullptr) {
+        frames.bind(baked, numframes, jointcount);
+    } else {
+        LOG(std::string("Loading animation... ") + filepath);
+
+        Game::LoadingScreen();
+
+        // read the whole file at once, then decode it from memory
+        BinaryReader source;
+        Folders::openMandatoryReader(filepath, source);
+        if (!AnimationDatabase::parseSource(source, storage, numframes, jointcount)) {
+            LOG("Animation " + filepath + " is truncated");
+        }
+        if (numframes == 0) {
+            throw std::runtime_error("Invalid animation " + filepath);
+        }
+        frames.bind(storage.data(), numframes, jointcount);
+    }
+    numjoints = jointcount;
 
-    frames.resize(numframes);
+    computeOffset();
+}
 
-    // read binary data as animation
+Animation::Animation(const Animation& other)
+    : height(other.height)
+    , attack(other.attack)
+    , numjoints(other.numjoints)
+    , offset(other.offset)
+{
+    *this = other;
+}
 
-    // for each frame...
-    for (i = 0; i < frames.size(); i++) {
-        frames[i].joints.resize(numjoints);
-        frames[i].loadBaseInfo(tfile);
-    }
-    // read twist2 for whole animation
-    for (i = 0; i < frames.size(); i++) {
-        frames[i].loadTwist2(tfile);
-    }
-    // read label for each frame
-    for (i = 0; i < frames.size(); i++) {
-        frames[i].loadLabel(tfile);
+Animation& Animation::operator=(const Animation& other)
+{
+    if (this == &other) {
+        return *this;
     }
-    // read unused weapontargetnum
-    int weapontargetnum;
-    funpackf(tfile, "Bi", &weapontargetnum);
-    // read weapontarget positions for each frame
-    for (i = 0; i < frames.size(); i++) {
-        frames[i].loadWeaponTarget(tfile);
+    height = other.height;
+    attack = other.attack;
+    numjoints = other.numjoints;
+    offset = other.offset;
+
+    const size_t size = AnimationFrames::byteSize(other.frames.size(), other.frames.getJointCount());
+    std::vector<unsigned char> copy(size);
+    if (size > 0) {
+        memcpy(copy.data(), other.frames.position, size);
     }
+    storage.swap(copy);
+    frames.bind(storage.data(), other.frames.size(), other.frames.getJointCount());
+    return *this;
+}
 
-    fclose(tfile);
-
+void Animation::computeOffset()
+{
     XYZ endoffset;
     endoffset = 0;
     // find average position of certain joints on last frames
     // and save in endoffset
     // (not sure what exactly this accomplishes. the y < 1 test confuses me.)
-    for (i = 0; i < frames.back().joints.size(); i++) {
-        if (frames.back().joints[i].position.y < 1) {
-            endoffset += frames.back().joints[i].position;
+    AnimationFrame last = frames.back();
+    for (unsigned i = 0; i < last.joints.size(); i++) {
+        if (last.joints[i].position.y < 1) {
+            endoffset += last.joints[i].position;
         }
     }
     endoffset /= numjoints;
@@ -20,8 +20,10 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef _ANIMATION_HPP_
 #define _ANIMATION_HPP_
 
+#include "Animation/AnimationFrames.hpp"
 #include "Math/XYZ.hpp"
 
+#include <string>
 #include <vector>
 
 enum anim_attack_type
@@ -68,28 +70,6 @@ static const int animation_bits[animation_count] = {
 #undef DECLARE_ANIM
 };
 
-struct AnimationFrameJointInfo
-{
-    XYZ position;
-    float twist;
-    float twist2;
-    bool onground;
-};
-
-struct AnimationFrame
-{
-    void loadBaseInfo(FILE* tfile);
-    void loadTwist2(FILE* tfile);
-    void loadLabel(FILE* tfile);
-    void loadWeaponTarget(FILE* tfile);
-
-    std::vector<AnimationFrameJointInfo> joints;
-    XYZ forward;
-    int label;
-    XYZ weapontarget;
-    float speed;
-};
-
 class Animation
 {
 public:
@@ -100,11 +80,24 @@ public:
     anim_attack_type attack;
     int numjoints;
 
-    std::vector<AnimationFrame> frames;
+    AnimationFrames frames;
 
     XYZ offset;
 
     Animation();
+    /* Views the baked database when it has an up to date copy, loads the file otherwise */
     Animation(const std::string& fileName, anim_height_type aheight, anim_attack_type aattack);
+
+    /* Copies own their frames, moves keep viewing whatever they viewed */
+    Animation(const Animation& other);
+    Animation(Animation&& other) = default;
+    Animation& operator=(const Animation& other);
+    Animation& operator=(Animation&& other) = default;
+
+private:
+    /* Frames block when not viewing the database */
+    std::vector<unsigned char> storage;
+
+    void computeOffset();
 };
 #endif
@@ -0,0 +1,268 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Animation/AnimationDatabase.hpp"
+
+#include "Animation/AnimationFrames.hpp"
+#include "Utils/BinaryReader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+const char AnimationDatabase::kMagic[4] = { 'L', 'G', 'A', 'D' };
+const char* const AnimationDatabase::kFileName = "Animations/Animations.lad";
+
+static const uint32_t byteOrderMark = 0x01020304;
+static const size_t headerSize = 16;
+static const size_t clipEntrySize = AnimationDatabase::kNameLength + 32;
+static const uint32_t maxFrames = 4096;
+static const uint32_t maxJoints = 1024;
+
+template <typename T>
+static T readHost(const unsigned char* p)
+{
+    T value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <typename T>
+static void writeHost(std::ostream& out, T value)
+{
+    out.write((const char*)&value, sizeof(value));
+}
+
+static uint64_t alignUp(uint64_t value)
+{
+    return (value + AnimationDatabase::kAlignment - 1) & ~uint64_t(AnimationDatabase::kAlignment - 1);
+}
+
+AnimationDatabase::AnimationDatabase()
+{
+}
+
+std::string AnimationDatabase::toLower(const std::string& str)
+{
+    std::string lowerStr = str;
+    std::transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(), ::tolower);
+    return lowerStr;
+}
+
+bool AnimationDatabase::open(std::vector<unsigned char>&& _bytes)
+{
+    close();
+    bytes = std::move(_bytes);
+
+    const unsigned char* base = bytes.data();
+    const size_t length = bytes.size();
+    if (length < headerSize || memcmp(base, kMagic, 4) != 0 || readHost<uint32_t>(base + 4) != kVersion ||
+        readHost<uint32_t>(base + 8) != byteOrderMark) {
+        close();
+        return false;
+    }
+
+    const uint32_t count = readHost<uint32_t>(base + 12);
+    if (headerSize + uint64_t(count) * clipEntrySize > length) {
+        close();
+        return false;
+    }
+
+    clips.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const unsigned char* entry = base + headerSize + i * clipEntrySize;
+        const unsigned char* fields = entry + kNameLength;
+        Clip& clip = clips[i];
+        clip.name.assign((const char*)entry, strnlen((const char*)entry, kNameLength));
+        clip.key = toLower(clip.name);
+        clip.sourceSize = readHost<uint64_t>(fields);
+        clip.sourceTime = readHost<int64_t>(fields + 8);
+        clip.numframes = readHost<uint32_t>(fields + 16);
+        clip.numjoints = readHost<uint32_t>(fields + 20);
+        clip.offset = readHost<uint64_t>(fields + 24);
+
+        const bool valid = clip.name.size() < kNameLength && clip.numframes > 0 && clip.numframes <= maxFrames &&
+                           clip.numjoints > 0 && clip.numjoints <= maxJoints && clip.offset % kAlignment == 0 &&
+                           clip.offset <= length && AnimationFrames::byteSize(clip.numframes, clip.numjoints) <= length - clip.offset &&
+                           (i == 0 || clips[i - 1].key < clip.key);
+        if (!valid) {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void AnimationDatabase::close()
+{
+    bytes.clear();
+    clips.clear();
+}
+
+const AnimationDatabase::Clip* AnimationDatabase::find(const std::string& name) const
+{
+    std::string key = toLower(name);
+    auto it = std::lower_bound(clips.begin(), clips.end(), key,
+                               [](const Clip& clip, const std::string& k) { return clip.key < k; });
+    if (it != clips.end() && it->key == key) {
+        return &(*it);
+    }
+    return nullptr;
+}
+
+bool AnimationDatabase::parseSource(BinaryReader& reader, std::vector<unsigned char>& block, unsigned& numframes, unsigned& numjoints)
+{
+    const int frameCount = reader.read<int32_be>();
+    const int jointCount = reader.read<int32_be>();
+    if (frameCount <= 0 || frameCount > (int)maxFrames || jointCount <= 0 || jointCount > (int)maxJoints) {
+        block.clear();
+        numframes = 0;
+        numjoints = 0;
+        return false;
+    }
+    numframes = frameCount;
+    numjoints = jointCount;
+
+    block.assign(AnimationFrames::byteSize(numframes, numjoints), 0);
+    AnimationFrames frames;
+    frames.bind(block.data(), numframes, numjoints);
+
+    // Files store frames one after the other like the block does, so whole frames convert at once
+    std::vector<unsigned char> flags(numjoints);
+    for (unsigned i = 0; i < numframes; i++) {
+        AnimationFrame frame = frames[i];
+        reader.read_array<float_be>(&frames.framePositions(i)->x, numjoints * 3);
+        reader.read_array<float_be>(&frame.joints[0].twist, numjoints);
+        reader.read_array<uint8_be>(flags.data(), numjoints);
+        for (unsigned j = 0; j < numjoints; j++) {
+            frame.joints[j].onground = (flags[j] != 0);
+        }
+        frame.speed = reader.read<float_be>();
+    }
+    for (unsigned i = 0; i < numframes; i++) {
+        reader.read_array<float_be>(&frames[i].joints[0].twist2, numjoints);
+    }
+    for (unsigned i = 0; i < numframes; i++) {
+        frames[i].label = reader.read<int32_be>();
+    }
+    const bool complete = !reader.isTruncated();
+
+    // Weapon targets are left out of animations that don't need them
+    // unused weapontargetnum
+    reader.read<int32_be>();
+    reader.read_array<float_be>(&frames[0].weapontarget.x, numframes * 3);
+
+    return complete;
+}
+
+int AnimationDatabase::build(const std::string& animationDir, const std::string& outputPath)
+{
+    struct Source
+    {
+        Clip clip;
+        std::vector<unsigned char> block;
+    };
+    std::vector<Source> sources;
+
+    const std::string outputName = std::filesystem::path(outputPath).filename().string();
+    std::error_code ec;
+    for (auto it = std::filesystem::directory_iterator(animationDir, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        // Animation files have no extension, skip the database itself and anything else
+        if (!it->is_regular_file(ec) || it->path().has_extension() || name == outputName) {
+            continue;
+        }
+        if (name.size() >= kNameLength) {
+            std::cerr << "Skipping " << name << ", name too long" << std::endl;
+            continue;
+        }
+
+        std::ifstream in(it->path(), std::ios::binary);
+        if (!in.is_open()) {
+            std::cerr << "Unable to read " << it->path().string() << std::endl;
+            return -1;
+        }
+        std::vector<unsigned char> content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto time = std::filesystem::last_write_time(it->path(), ec);
+
+        Source source;
+        BinaryReader reader(content.data(), content.size());
+        if (ec || !parseSource(reader, source.block, source.clip.numframes, source.clip.numjoints)) {
+            // The game keeps loading these from their own file
+            std::cerr << "Skipping " << name << ", truncated or not an animation" << std::endl;
+            ec.clear();
+            continue;
+        }
+        source.clip.name = name;
+        source.clip.key = toLower(name);
+        source.clip.sourceSize = content.size();
+        source.clip.sourceTime = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        sources.push_back(std::move(source));
+    }
+    if (ec) {
+        std::cerr << "Unable to list " << animationDir << std::endl;
+        return -1;
+    }
+
+    std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.clip.key < b.clip.key; });
+    auto duplicate = std::adjacent_find(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.clip.key == b.clip.key; });
+    if (duplicate != sources.end()) {
+        std::cerr << "Animations only differing by case can't be baked: " << duplicate->clip.name << std::endl;
+        return -1;
+    }
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open " << outputPath << " for writing" << std::endl;
+        return -1;
+    }
+
+    out.write(kMagic, 4);
+    writeHost<uint32_t>(out, kVersion);
+    writeHost<uint32_t>(out, byteOrderMark);
+    writeHost<uint32_t>(out, sources.size());
+
+    uint64_t offset = alignUp(headerSize + sources.size() * clipEntrySize);
+    for (const Source& source : sources) {
+        char name[kNameLength] = {};
+        memcpy(name, source.clip.name.data(), source.clip.name.size());
+        out.write(name, kNameLength);
+        writeHost<uint64_t>(out, source.clip.sourceSize);
+        writeHost<int64_t>(out, source.clip.sourceTime);
+        writeHost<uint32_t>(out, source.clip.numframes);
+        writeHost<uint32_t>(out, source.clip.numjoints);
+        writeHost<uint64_t>(out, offset);
+        offset = alignUp(offset + source.block.size());
+    }
+
+    const char padding[kAlignment] = {};
+    for (const Source& source : sources) {
+        uint64_t position = out.tellp();
+        out.write(padding, alignUp(position) - position);
+        out.write((const char*)source.block.data(), source.block.size());
+    }
+
+    return out.good() ? (int)sources.size() : -1;
+}
@@ -0,0 +1,98 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ANIMATION_DATABASE_HPP_
+#define _ANIMATION_DATABASE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BinaryReader;
+
+/* Every animation of a pack baked into one file (<Pack>/Animations/Animations.lad)
+ *
+ * Integers and floats are stored in the byte order of the machine that baked
+ * the file, the header's byte order mark tells which one.
+ *
+ *   header   "LGAD", u32 version, u32 byte order mark, u32 clip count
+ *   clips    clip count * { char name[48], u64 source size, i64 source mtime,
+ *                           u32 frame count, u32 joint count, u64 data offset }
+ *   data     the frames of each clip laid out by AnimationFrames::bind,
+ *            each starting on a kAlignment boundary
+ *
+ * Clips are sorted by lowercased name so lookups can bisect them. The source
+ * size and modification time let the game notice animations edited since
+ * the database got baked, and load those from their own file instead.
+ */
+class AnimationDatabase
+{
+public:
+    static const char kMagic[4];
+    static const uint32_t kVersion = 2;
+    static const uint32_t kAlignment = 16;
+    static const size_t kNameLength = 48;
+    /* Relative to the pack folder */
+    static const char* const kFileName;
+
+    struct Clip
+    {
+        std::string name;
+        std::string key;
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint32_t numframes;
+        uint32_t numjoints;
+        uint64_t offset;
+    };
+
+    AnimationDatabase();
+
+    /* Take over the bytes of a database file, false if they aren't a valid database for this machine */
+    bool open(std::vector<unsigned char>&& bytes);
+    void close();
+    bool isOpen() const { return !bytes.empty(); }
+
+    /* Case-insensitive lookup, returns nullptr when absent */
+    const Clip* find(const std::string& name) const;
+    /* Frames block of a clip, writable so the game can patch animations after loading them */
+    unsigned char* data(const Clip& clip) { return bytes.data() + clip.offset; }
+
+    /* Decode an animation in its original big-endian format into a frames block.
+     * Data missing from a truncated file is left zeroed, and makes it return false
+     * unless only the optional weapon targets are missing. */
+    static bool parseSource(BinaryReader& reader, std::vector<unsigned char>& block, unsigned& numframes, unsigned& numjoints);
+
+    /* Bake every animation file of animationDir into outputPath, returns the clip count or -1 */
+    static int build(const std::string& animationDir, const std::string& outputPath);
+
+    static std::string toLower(const std::string& str);
+
+    /* Make sure AnimationDatabase never gets copied, animations point into its bytes */
+    AnimationDatabase(AnimationDatabase const& other) = delete;
+    AnimationDatabase& operator=(AnimationDatabase const& other) = delete;
+
+private:
+    std::vector<unsigned char> bytes;
+    std::vector<Clip> clips;
+};
+
+#endif
@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Animation/AnimationFrames.hpp"
+
+#include <stdexcept>
+
+AnimationFrames::AnimationFrames()
+    : numframes(0)
+    , numjoints(0)
+    , position(nullptr)
+    , twist(nullptr)
+    , twist2(nullptr)
+    , weapontarget(nullptr)
+    , speed(nullptr)
+    , label(nullptr)
+    , onground(nullptr)
+{
+}
+
+size_t AnimationFrames::byteSize(unsigned numframes, unsigned numjoints)
+{
+    const size_t values = size_t(numframes) * numjoints;
+    const size_t bytes = values * (sizeof(XYZ) + 2 * sizeof(float)) + numframes * (sizeof(XYZ) + sizeof(float) + sizeof(int)) + values * sizeof(bool);
+    return (bytes + 3) & ~size_t(3);
+}
+
+void AnimationFrames::bind(unsigned char* block, unsigned _numframes, unsigned _numjoints)
+{
+    numframes = _numframes;
+    numjoints = _numjoints;
+
+    const size_t values = size_t(numframes) * numjoints;
+    position = (XYZ*)block;
+    twist = (float*)(position + values);
+    twist2 = twist + values;
+    weapontarget = (XYZ*)(twist2 + values);
+    speed = (float*)(weapontarget + numframes);
+    label = (int*)(speed + numframes);
+    onground = (bool*)(label + numframes);
+}
+
+AnimationFrame AnimationFrames::at(unsigned frame) const
+{
+    if (frame >= numframes) {
+        throw std::out_of_range("Animation frame out of range");
+    }
+    return AnimationFrame(*this, frame);
+}
@@ -0,0 +1,132 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ANIMATION_FRAMES_HPP_
+#define _ANIMATION_FRAMES_HPP_
+
+#include "Math/XYZ.hpp"
+
+#include <cstddef>
+
+/* References to one joint of one frame, see AnimationFrames */
+struct AnimationFrameJointInfo
+{
+    XYZ& position;
+    float& twist;
+    float& twist2;
+    bool& onground;
+};
+
+struct AnimationFrame;
+
+/* Frames of an animation as a structure of arrays.
+ *
+ * Per joint arrays are frame major, so the joints of one frame are
+ * contiguous and a pose blends two runs of numjoints values. The arrays live
+ * in one block laid out by bind(), which is either a slice of the baked
+ * animation database or owned by the Animation.
+ */
+class AnimationFrames
+{
+public:
+    AnimationFrames();
+
+    unsigned size() const { return numframes; }
+    bool empty() const { return numframes == 0; }
+    unsigned getJointCount() const { return numjoints; }
+
+    inline AnimationFrame operator[](unsigned frame) const;
+    /* Throws std::out_of_range like std::vector::at */
+    AnimationFrame at(unsigned frame) const;
+    inline AnimationFrame back() const;
+
+    /* numjoints positions of a single frame */
+    XYZ* framePositions(unsigned frame) const { return position + frame * numjoints; }
+
+    /* Size of the block holding numframes frames of numjoints joints */
+    static size_t byteSize(unsigned numframes, unsigned numjoints);
+    /* Point the arrays into a block of byteSize() bytes */
+    void bind(unsigned char* block, unsigned numframes, unsigned numjoints);
+
+private:
+    friend class Animation;
+    friend class AnimationFrameJoints;
+    friend struct AnimationFrame;
+
+    unsigned numframes;
+    unsigned numjoints;
+
+    XYZ* position;
+    float* twist;
+    float* twist2;
+    XYZ* weapontarget;
+    float* speed;
+    int* label;
+    bool* onground;
+};
+
+class AnimationFrameJoints
+{
+public:
+    AnimationFrameJoints(const AnimationFrames& frames, unsigned frame)
+        : frames(frames)
+        , frame(frame)
+    {
+    }
+
+    unsigned size() const { return frames.numjoints; }
+    AnimationFrameJointInfo operator[](unsigned joint) const
+    {
+        const unsigned index = frame * frames.numjoints + joint;
+        return AnimationFrameJointInfo{ frames.position[index], frames.twist[index], frames.twist2[index], frames.onground[index] };
+    }
+
+private:
+    const AnimationFrames& frames;
+    unsigned frame;
+};
+
+struct AnimationFrame
+{
+    AnimationFrame(const AnimationFrames& frames, unsigned frame)
+        : joints(frames, frame)
+        , label(frames.label[frame])
+        , weapontarget(frames.weapontarget[frame])
+        , speed(frames.speed[frame])
+    {
+    }
+
+    AnimationFrameJoints joints;
+    int& label;
+    XYZ& weapontarget;
+    float& speed;
+};
+
+inline AnimationFrame AnimationFrames::operator[](unsigned frame) const
+{
+    return AnimationFrame(*this, frame);
+}
+
+inline AnimationFrame AnimationFrames::back() const
+{
+    return AnimationFrame(*this, numframes - 1);
+}
+
+#endif
@@ -20,7 +20,7 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Animation/Joint.hpp"
 
-#include "Utils/binio.h"
+#include "Utils/BinaryReader.hpp"
 
 Joint::Joint()
     : blurred(0)
@@ -39,17 +39,24 @@ Joint::Joint()
 {
 }
 
-void Joint::load(FILE* tfile, std::vector<Joint>& joints)
+void Joint::load(BinaryReader& reader, std::vector<Joint>& joints)
 {
     int parentID;
 
-    funpackf(tfile, "Bf Bf Bf Bf Bf", &position.x, &position.y, &position.z, &length, &mass);
-    funpackf(tfile, "Bb Bb", &hasparent, &locked);
-    funpackf(tfile, "Bi", &modelnum);
-    funpackf(tfile, "Bb Bb", &visible, &sametwist);
-    funpackf(tfile, "Bi Bi", &label, &hasgun);
-    funpackf(tfile, "Bb", &lower);
-    funpackf(tfile, "Bi", &parentID);
+    position.x = reader.read<float_be>();
+    position.y = reader.read<float_be>();
+    position.z = reader.read<float_be>();
+    length = reader.read<float_be>();
+    mass = reader.read<float_be>();
+    hasparent = reader.read<uint8_be>();
+    locked = reader.read<uint8_be>();
+    modelnum = reader.read<int32_be>();
+    visible = reader.read<uint8_be>();
+    sametwist = reader.read<uint8_be>();
+    label = (bodypart)reader.read<int32_be>();
+    hasgun = reader.read<int32_be>();
+    lower = reader.read<uint8_be>();
+    parentID = reader.read<int32_be>();
     if (hasparent) {
         parent = &joints[parentID];
     } else {
@@ -25,6 +25,8 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <vector>
 
+class BinaryReader;
+
 enum bodypart
 {
     head,
@@ -74,7 +76,7 @@ public:
     XYZ velchange;
 
     Joint();
-    void load(FILE* tfile, std::vector<Joint>& joints);
+    void load(BinaryReader& reader, std::vector<Joint>& joints);
 };
 
 #endif
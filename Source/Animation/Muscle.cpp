@@ -20,7 +20,7 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Animation/Muscle.hpp"
 
-#include "Utils/binio.h"
+#include "Utils/BinaryReader.hpp"
 
 extern float multiplier;
 extern bool freeze;
@@ -52,58 +52,53 @@ Muscle::Muscle()
 {
 }
 
-void Muscle::load(FILE* tfile, int vertexNum, std::vector<Joint>& joints)
+/* Read a vertex count and that many vertex indices, keeping those below vertexNum */
+static void loadVertices(BinaryReader& reader, int vertexNum, std::vector<int>& vertices)
 {
-    int numvertices, vertice, parentID;
-
-    // read info
-    funpackf(tfile, "Bf Bf Bf Bf Bf Bi Bi", &length, &targetlength, &minlength, &maxlength, &strength, &type, &numvertices);
+    int numvertices = reader.read<int32_be>();
+    if (numvertices <= 0) {
+        return;
+    }
 
-    // read vertices
-    for (int j = 0; j < numvertices; j++) {
-        funpackf(tfile, "Bi", &vertice);
+    std::vector<int> indices = reader.read_array<int32_be>(numvertices);
+    for (int vertice : indices) {
         if (vertice < vertexNum) {
             vertices.push_back(vertice);
         }
     }
-
-    // read more info
-    funpackf(tfile, "Bb Bi", &visible, &parentID);
-    parent1 = &joints[parentID];
-    funpackf(tfile, "Bi", &parentID);
-    parent2 = &joints[parentID];
 }
 
-void Muscle::loadVerticesLow(FILE* tfile, int vertexNum)
+void Muscle::load(BinaryReader& reader, int vertexNum, std::vector<Joint>& joints)
 {
-    int numvertices, vertice;
+    int parentID;
 
-    // read numvertices
-    funpackf(tfile, "Bi", &numvertices);
+    // read info
+    length = reader.read<float_be>();
+    targetlength = reader.read<float_be>();
+    minlength = reader.read<float_be>();
+    maxlength = reader.read<float_be>();
+    strength = reader.read<float_be>();
+    type = (muscle_type)reader.read<int32_be>();
 
     // read vertices
-    for (int j = 0; j < numvertices; j++) {
-        funpackf(tfile, "Bi", &vertice);
-        if (vertice < vertexNum) {
-            verticeslow.push_back(vertice);
-        }
-    }
+    loadVertices(reader, vertexNum, vertices);
+
+    // read more info
+    visible = reader.read<uint8_be>();
+    parentID = reader.read<int32_be>();
+    parent1 = &joints[parentID];
+    parentID = reader.read<int32_be>();
+    parent2 = &joints[parentID];
 }
 
-void Muscle::loadVerticesClothes(FILE* tfile, int vertexNum)
+void Muscle::loadVerticesLow(BinaryReader& reader, int vertexNum)
 {
-    int numvertices, vertice;
-
-    // read numvertices
-    funpackf(tfile, "Bi", &numvertices);
+    loadVertices(reader, vertexNum, verticeslow);
+}
 
-    // read vertices
-    for (int j = 0; j < numvertices; j++) {
-        funpackf(tfile, "Bi", &vertice);
-        if (vertice < vertexNum) {
-            verticesclothes.push_back(vertice);
-        }
-    }
+void Muscle::loadVerticesClothes(BinaryReader& reader, int vertexNum)
+{
+    loadVertices(reader, vertexNum, verticesclothes);
 }
 
 /* EFFECT
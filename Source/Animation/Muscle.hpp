@@ -35,6 +35,7 @@ enum muscle_type
 class Muscle
 {
 public:
+    // only filled in SkeletonTemplate::muscles, per-person copies leave them empty
     std::vector<int> vertices;
     std::vector<int> verticeslow;
     std::vector<int> verticesclothes;
@@ -54,9 +55,9 @@ public:
     float strength;
 
     Muscle();
-    void load(FILE* tfile, int vertexNum, std::vector<Joint>& joints);
-    void loadVerticesLow(FILE* tfile, int vertexNum);
-    void loadVerticesClothes(FILE* tfile, int vertexNum);
+    void load(BinaryReader& reader, int vertexNum, std::vector<Joint>& joints);
+    void loadVerticesLow(BinaryReader& reader, int vertexNum);
+    void loadVerticesClothes(BinaryReader& reader, int vertexNum);
     void DoConstraint(bool spinny);
 };
 
@@ -0,0 +1,49 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Animation/Pose.hpp"
+
+#include <algorithm>
+
+Pose::Pose()
+    : currentPositions(nullptr)
+    , targetPositions(nullptr)
+    , weight(0)
+{
+}
+
+void Pose::evaluate(const AnimationFrames& currentFrames, unsigned current, const AnimationFrames& targetFrames, unsigned next, float target)
+{
+    // Frames are told apart by their joints, which sit at a different place for each frame of each animation
+    XYZ* from = currentFrames.framePositions(current);
+    XYZ* to = targetFrames.framePositions(next);
+    if (from == currentPositions && to == targetPositions && target == weight) {
+        return;
+    }
+    currentPositions = from;
+    targetPositions = to;
+    weight = target;
+
+    positions.resize(std::min(currentFrames.getJointCount(), targetFrames.getJointCount()));
+    for (unsigned i = 0; i < positions.size(); i++) {
+        positions[i] = from[i] * (1 - target) + to[i] * target;
+    }
+    weapontarget = currentFrames[current].weapontarget * (1 - target) + targetFrames[next].weapontarget * target;
+}
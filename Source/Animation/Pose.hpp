@@ -0,0 +1,56 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _POSE_HPP_
+#define _POSE_HPP_
+
+#include "Animation/AnimationFrames.hpp"
+#include "Math/XYZ.hpp"
+
+#include <vector>
+
+/* Joint positions and weapon target of a person, blended between the current
+ * and target frames of their animations.
+ *
+ * evaluate() only blends again when one of the frames or the weight changed,
+ * so everything looking at the pose during a tick shares a single blend.
+ */
+class Pose
+{
+public:
+    Pose();
+
+    /* Blend frame current of currentFrames into frame next of targetFrames, target weighting the latter */
+    void evaluate(const AnimationFrames& currentFrames, unsigned current, const AnimationFrames& targetFrames, unsigned next, float target);
+
+    unsigned size() const { return positions.size(); }
+    const XYZ& getPosition(unsigned joint) const { return positions[joint]; }
+    const XYZ& getWeaponTarget() const { return weapontarget; }
+
+private:
+    const XYZ* currentPositions;
+    const XYZ* targetPositions;
+    float weight;
+
+    std::vector<XYZ> positions;
+    XYZ weapontarget;
+};
+
+#endif
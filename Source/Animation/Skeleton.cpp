@@ -23,9 +23,13 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Animation/Animation.hpp"
 #include "Audio/openal_wrapper.hpp"
 #include "Game.hpp"
+#include "Math/Matrix.hpp"
 #include "Tutorial.hpp"
+#include "Utils/BinaryReader.hpp"
 #include "Utils/Folders.hpp"
 
+#include <map>
+
 extern float multiplier;
 extern float gravity;
 extern Terrain terrain;
@@ -40,10 +44,9 @@ extern int whichjointendarray[26];
 Skeleton::Skeleton()
     : selected(0)
     , id(0)
-    , num_models(0)
+    , faceNormalsStale(false)
     , clothes(false)
     , spinny(false)
-    , skinsize(0)
     , checkdelay(0)
     , longdead(0)
     , broken(false)
@@ -55,7 +58,6 @@ Skeleton::Skeleton()
     memset(forwardjoints, 0, sizeof(forwardjoints));
     memset(lowforwardjoints, 0, sizeof(lowforwardjoints));
     memset(jointlabels, 0, sizeof(jointlabels));
-    memset(skinText, 0, sizeof(skinText));
 }
 
 /* EFFECT
@@ -630,9 +632,102 @@ void Skeleton::FindRotationMuscle(int which, int animation)
     }
 }
 
+/* EFFECT
+ * skins drawmodel on the CPU with the matrices last given to skinnedMesh,
+ * a no-op while the CPU path keeps drawmodel posed
+ */
+void Skeleton::syncDrawModel()
+{
+    if (skinnedMesh.isBuilt() && skinnedMesh.isStale()) {
+        skinnedMesh.skin(base->muscles, drawmodel);
+    } else if (faceNormalsStale) {
+        drawmodel.CalculateFaceNormals();
+    }
+    faceNormalsStale = false;
+}
+
+void NormalSeams::build(const Model& model)
+{
+    vertices.clear();
+    firstFace.clear();
+    faces.clear();
+    triangles.clear();
+
+    std::vector<bool> seam(model.vertexNum, false);
+    for (const TexturedTriangle& triangle : model.Triangles) {
+        const int owner = model.owner[triangle.vertex[0]];
+        if (owner < 0 || owner != model.owner[triangle.vertex[1]] || owner != model.owner[triangle.vertex[2]]) {
+            for (int j = 0; j < 3; j++) {
+                seam[triangle.vertex[j]] = true;
+            }
+        }
+    }
+
+    // every face touching a seam vertex is needed to rebuild its normal
+    std::vector<int> seamIndex(model.vertexNum, -1);
+    for (int i = 0; i < model.vertexNum; i++) {
+        if (seam[i]) {
+            seamIndex[i] = vertices.size();
+            vertices.push_back(i);
+        }
+    }
+    std::vector<std::vector<int>> around(vertices.size());
+    for (unsigned int i = 0; i < model.Triangles.size(); i++) {
+        const TexturedTriangle& triangle = model.Triangles[i];
+        if (!seam[triangle.vertex[0]] && !seam[triangle.vertex[1]] && !seam[triangle.vertex[2]]) {
+            continue;
+        }
+        for (int j = 0; j < 3; j++) {
+            if (seam[triangle.vertex[j]]) {
+                around[seamIndex[triangle.vertex[j]]].push_back(triangles.size());
+            }
+        }
+        triangles.push_back(i);
+    }
+    for (const std::vector<int>& list : around) {
+        firstFace.push_back(faces.size());
+        faces.insert(faces.end(), list.begin(), list.end());
+    }
+    firstFace.push_back(faces.size());
+}
+
+void NormalSeams::apply(Model& model) const
+{
+    for (int i : triangles) {
+        TexturedTriangle& triangle = model.Triangles[i];
+        CrossProduct(model.vertex[triangle.vertex[1]] - model.vertex[triangle.vertex[0]], model.vertex[triangle.vertex[2]] - model.vertex[triangle.vertex[0]], &triangle.facenormal);
+    }
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+        XYZ normal;
+        for (int j = firstFace[i]; j < firstFace[i + 1]; j++) {
+            normal += model.Triangles[triangles[faces[j]]].facenormal;
+        }
+        Normalise(&normal);
+        model.normals[vertices[i]] = normal * -1;
+    }
+}
+
+SkeletonTemplate::SkeletonTemplate()
+    : num_models(0)
+    , clothes(false)
+{
+    memset(forwardjoints, 0, sizeof(forwardjoints));
+    memset(lowforwardjoints, 0, sizeof(lowforwardjoints));
+    memset(jointlabels, 0, sizeof(jointlabels));
+}
+
+static std::map<std::string, std::shared_ptr<const SkeletonTemplate>> skeletonTemplates;
+
+void SkeletonTemplate::clearCache()
+{
+    skeletonTemplates.clear();
+}
+
 /* EFFECT
  * load skeleton
  * takes filenames for three skeleton files and various models
+ * files are only read the first time a given set is used, later
+ * skeletons copy their per-person state from the shared template
  */
 void Skeleton::Load(const std::string& filename, const std::string& lowfilename, const std::string& clothesfilename,
                     const std::string& modelfilename, const std::string& model2filename,
@@ -641,25 +736,102 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
                     const std::string& model7filename, const std::string& modellowfilename,
                     const std::string& modelclothesfilename, bool clothes)
 {
-    GLfloat M[16];
-    FILE* tfile;
-    float lSize;
+    LOGFUNC;
+
+    const std::string modelfilenames[7] = {
+        modelfilename, model2filename, model3filename, model4filename,
+        model5filename, model6filename, model7filename
+    };
+
+    std::string key = filename + '\n' + lowfilename + '\n' + clothesfilename + '\n' + modellowfilename + '\n' + modelclothesfilename + '\n' + (clothes ? '1' : '0');
+    for (int i = 0; i < 7; i++) {
+        key += '\n' + modelfilenames[i];
+    }
+
+    std::shared_ptr<const SkeletonTemplate>& cached = skeletonTemplates[key];
+    if (!cached) {
+        // the bake itself stays free of GL and game state
+        Game::LoadingScreen();
+        std::shared_ptr<SkeletonTemplate> templ(new SkeletonTemplate());
+        std::unique_ptr<Skeleton> scratch(new Skeleton());
+        scratch->buildTemplate(*templ, filename, lowfilename, clothesfilename, modelfilenames, modellowfilename, modelclothesfilename, clothes);
+        cached = templ;
+    }
+    base = cached;
+
+    // per-person state, joint and muscle pointers are rebased onto our own copies
+    joints = base->joints;
+    for (Joint& joint : joints) {
+        if (joint.parent) {
+            joint.parent = &joints[joint.parent - &base->joints[0]];
+        }
+    }
+    muscles = base->muscles;
+    for (Muscle& muscle : muscles) {
+        muscle.parent1 = &joints[muscle.parent1 - &base->joints[0]];
+        muscle.parent2 = &joints[muscle.parent2 - &base->joints[0]];
+        std::vector<int>().swap(muscle.vertices);
+        std::vector<int>().swap(muscle.verticeslow);
+        std::vector<int>().swap(muscle.verticesclothes);
+    }
+
+    memcpy(forwardjoints, base->forwardjoints, sizeof(forwardjoints));
+    memcpy(lowforwardjoints, base->lowforwardjoints, sizeof(lowforwardjoints));
+    memcpy(jointlabels, base->jointlabels, sizeof(jointlabels));
+    forward = base->forward;
+    lowforward = base->lowforward;
+    for (int i = 0; i < 5; i++) {
+        specialforward[i] = base->specialforward[i];
+    }
+
+    drawmodel = base->drawmodel;
+    drawmodellow = base->drawmodellow;
+    if (clothes) {
+        drawmodelclothes = base->drawmodelclothes;
+    }
+
+    if ((Tutorial::active) && (id != 0)) {
+        drawmodel.UniformTexCoords();
+        drawmodel.ScaleTexCoords(0.1);
+        drawmodellow.UniformTexCoords();
+        drawmodellow.ScaleTexCoords(0.1);
+    }
+    // rebuilt from the new drawmodel on the next GPU skinned draw
+    skinnedMesh.release();
+    faceNormalsStale = false;
+
+    free = 0;
+}
+
+/* EFFECT
+ * reads the skeleton files and models into templ,
+ * using this skeleton as scratch space for the rest pose computations
+ */
+void Skeleton::buildTemplate(SkeletonTemplate& templ, const std::string& filename, const std::string& lowfilename, const std::string& clothesfilename,
+                             const std::string modelfilenames[7], const std::string& modellowfilename,
+                             const std::string& modelclothesfilename, bool clothes)
+{
+    BinaryReader reader;
+    size_t lSize;
     int j, num_joints, num_muscles;
 
-    LOGFUNC;
+    Model* model = templ.model;
+    Model& modellow = templ.modellow;
+    Model& modelclothes = templ.modelclothes;
+    Model& drawmodel = templ.drawmodel;
+    Model& drawmodellow = templ.drawmodellow;
+    Model& drawmodelclothes = templ.drawmodelclothes;
+    const int num_models = templ.num_models = 7;
 
-    num_models = 7;
+    templ.clothes = clothes;
+    free = 0;
 
     // load various models
     // rotate, scale, do normals, do texcoords for each as needed
 
-    model[0].loadnotex(modelfilename);
-    model[1].loadnotex(model2filename);
-    model[2].loadnotex(model3filename);
-    model[3].loadnotex(model4filename);
-    model[4].loadnotex(model5filename);
-    model[5].loadnotex(model6filename);
-    model[6].loadnotex(model7filename);
+    for (int i = 0; i < num_models; i++) {
+        model[i].loadnotex(modelfilenames[i]);
+    }
 
     for (int i = 0; i < num_models; i++) {
         model[i].Rotate(180, 0, 0);
@@ -667,14 +839,10 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
         model[i].CalculateNormals(0);
     }
 
-    drawmodel.load(modelfilename);
+    drawmodel.load(modelfilenames[0]);
     drawmodel.Rotate(180, 0, 0);
     drawmodel.Scale(.04, .04, .04);
     drawmodel.FlipTexCoords();
-    if ((Tutorial::active) && (id != 0)) {
-        drawmodel.UniformTexCoords();
-        drawmodel.ScaleTexCoords(0.1);
-    }
     drawmodel.CalculateNormals(0);
 
     modellow.loadnotex(modellowfilename);
@@ -686,12 +854,6 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
     drawmodellow.Rotate(180, 0, 0);
     drawmodellow.Scale(.04, .04, .04);
     drawmodellow.FlipTexCoords();
-    if (Tutorial::active && id != 0) {
-        drawmodellow.UniformTexCoords();
-    }
-    if (Tutorial::active && id != 0) {
-        drawmodellow.ScaleTexCoords(0.1);
-    }
     drawmodellow.CalculateNormals(0);
 
     if (clothes) {
@@ -712,21 +874,21 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
 
     // load skeleton
 
-    tfile = Folders::openMandatoryFile(Folders::getResourcePath(filename), "rb");
+    Folders::openMandatoryReader(Folders::getResourcePath(filename), reader);
 
     // read num_joints
-    funpackf(tfile, "Bi", &num_joints);
+    num_joints = reader.read<int32_be>();
 
     joints.clear();
     joints.resize(num_joints);
 
     // read info for each joint
     for (int i = 0; i < num_joints; i++) {
-        joints[i].load(tfile, joints);
+        joints[i].load(reader, joints);
     }
 
     // read num_muscles
-    funpackf(tfile, "Bi", &num_muscles);
+    num_muscles = reader.read<int32_be>();
 
     // allocate memory
     muscles.clear();
@@ -734,16 +896,16 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
 
     // for each muscle...
     for (int i = 0; i < num_muscles; i++) {
-        muscles[i].load(tfile, model[0].vertexNum, joints);
+        muscles[i].load(reader, model[0].vertexNum, joints);
     }
 
     // read forwardjoints (?)
     for (j = 0; j < 3; j++) {
-        funpackf(tfile, "Bi", &forwardjoints[j]);
+        forwardjoints[j] = reader.read<int32_be>();
     }
     // read lowforwardjoints (?)
     for (j = 0; j < 3; j++) {
-        funpackf(tfile, "Bi", &lowforwardjoints[j]);
+        lowforwardjoints[j] = reader.read<int32_be>();
     }
 
     // ???
@@ -762,34 +924,30 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
     for (int i = 0; i < num_muscles; i++) {
         FindRotationMuscle(i, -1);
     }
-    // this seems to use opengl purely for matrix calculations
+    // rest pose rotation of each muscle, DrawSkeleton applies the inverse when posing
+    std::vector<Matrix4> restRotations(num_muscles);
+    for (int i = 0; i < num_muscles; i++) {
+        restRotations[i].rotate(muscles[i].rotate3, 0, 1, 0);
+        restRotations[i].rotate(muscles[i].rotate2 - 90, 0, 0, 1);
+        restRotations[i].rotate(muscles[i].rotate1 - 90, 0, 1, 0);
+    }
+    // move the vertices into the space of their muscle, normals follow so
+    // skinning can rotate them and SkinnedMesh gets smooth bind normals
     for (int k = 0; k < num_models; k++) {
         for (int i = 0; i < model[k].vertexNum; i++) {
             model[k].vertex[i] = model[k].vertex[i] - (muscles[model[k].owner[i]].parent1->position + muscles[model[k].owner[i]].parent2->position) / 2;
-            glMatrixMode(GL_MODELVIEW);
-            glPushMatrix();
-            glLoadIdentity();
-            glRotatef(muscles[model[k].owner[i]].rotate3, 0, 1, 0);
-            glRotatef(muscles[model[k].owner[i]].rotate2 - 90, 0, 0, 1);
-            glRotatef(muscles[model[k].owner[i]].rotate1 - 90, 0, 1, 0);
-            glTranslatef(model[k].vertex[i].x, model[k].vertex[i].y, model[k].vertex[i].z);
-            glGetFloatv(GL_MODELVIEW_MATRIX, M);
-            model[k].vertex[i].x = M[12] * 1;
-            model[k].vertex[i].y = M[13] * 1;
-            model[k].vertex[i].z = M[14] * 1;
-            glPopMatrix();
+            model[k].vertex[i] = restRotations[model[k].owner[i]].transformPoint(model[k].vertex[i]);
+            model[k].normals[i] = restRotations[model[k].owner[i]].transformVector(model[k].normals[i]);
         }
-        model[k].CalculateNormals(0);
     }
-    fclose(tfile);
 
     // load ???
 
-    tfile = Folders::openMandatoryFile(Folders::getResourcePath(lowfilename), "rb");
+    Folders::openMandatoryReader(Folders::getResourcePath(lowfilename), reader);
 
     // skip joints section
 
-    fseek(tfile, sizeof(num_joints), SEEK_CUR);
+    reader.skip(sizeof(num_joints));
     for (int i = 0; i < num_joints; i++) {
         // skip joint info
         lSize = sizeof(XYZ) + sizeof(float) + sizeof(float) + 1 //sizeof(bool)
@@ -798,25 +956,25 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
                 + 1                                             //sizeof(bool)
                 + sizeof(int) + sizeof(int) + 1                 //sizeof(bool)
                 + sizeof(int);
-        fseek(tfile, lSize, SEEK_CUR);
+        reader.skip(lSize);
     }
 
     // skip num_muscles
-    fseek(tfile, sizeof(num_muscles), SEEK_CUR);
+    reader.skip(sizeof(num_muscles));
 
     for (int i = 0; i < num_muscles; i++) {
         // skip muscle info
         lSize = sizeof(float) + sizeof(float) + sizeof(float) + sizeof(float) + sizeof(float) + sizeof(int);
-        fseek(tfile, lSize, SEEK_CUR);
+        reader.skip(lSize);
 
-        muscles[i].loadVerticesLow(tfile, modellow.vertexNum);
+        muscles[i].loadVerticesLow(reader, modellow.vertexNum);
 
         // skip more stuff
         lSize = 1; //sizeof(bool);
-        fseek(tfile, lSize, SEEK_CUR);
+        reader.skip(lSize);
         lSize = sizeof(int);
-        fseek(tfile, lSize, SEEK_CUR);
-        fseek(tfile, lSize, SEEK_CUR);
+        reader.skip(lSize);
+        reader.skip(lSize);
     }
 
     for (j = 0; j < num_muscles; j++) {
@@ -827,32 +985,20 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
         }
     }
 
-    // use opengl for its matrix math
+    // move the vertices into the space of their muscle
     for (int i = 0; i < modellow.vertexNum; i++) {
         modellow.vertex[i] = modellow.vertex[i] - (muscles[modellow.owner[i]].parent1->position + muscles[modellow.owner[i]].parent2->position) / 2;
-        glMatrixMode(GL_MODELVIEW);
-        glPushMatrix();
-        glLoadIdentity();
-        glRotatef(muscles[modellow.owner[i]].rotate3, 0, 1, 0);
-        glRotatef(muscles[modellow.owner[i]].rotate2 - 90, 0, 0, 1);
-        glRotatef(muscles[modellow.owner[i]].rotate1 - 90, 0, 1, 0);
-        glTranslatef(modellow.vertex[i].x, modellow.vertex[i].y, modellow.vertex[i].z);
-        glGetFloatv(GL_MODELVIEW_MATRIX, M);
-        modellow.vertex[i].x = M[12];
-        modellow.vertex[i].y = M[13];
-        modellow.vertex[i].z = M[14];
-        glPopMatrix();
+        modellow.vertex[i] = restRotations[modellow.owner[i]].transformPoint(modellow.vertex[i]);
+        modellow.normals[i] = restRotations[modellow.owner[i]].transformVector(modellow.normals[i]);
     }
 
-    modellow.CalculateNormals(0);
-
     // load clothes
 
     if (clothes) {
-        tfile = Folders::openMandatoryFile(Folders::getResourcePath(clothesfilename), "rb");
+        Folders::openMandatoryReader(Folders::getResourcePath(clothesfilename), reader);
 
         // skip num_joints
-        fseek(tfile, sizeof(num_joints), SEEK_CUR);
+        reader.skip(sizeof(num_joints));
 
         for (int i = 0; i < num_joints; i++) {
             // skip joint info
@@ -862,25 +1008,25 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
                     + 1                                             //sizeof(bool)
                     + sizeof(int) + sizeof(int) + 1                 //sizeof(bool)
                     + sizeof(int);
-            fseek(tfile, lSize, SEEK_CUR);
+            reader.skip(lSize);
         }
 
         // skip num_muscles
-        fseek(tfile, sizeof(num_muscles), SEEK_CUR);
+        reader.skip(sizeof(num_muscles));
 
         for (int i = 0; i < num_muscles; i++) {
             // skip muscle info
             lSize = sizeof(float) + sizeof(float) + sizeof(float) + sizeof(float) + sizeof(float) + sizeof(int);
-            fseek(tfile, lSize, SEEK_CUR);
+            reader.skip(lSize);
 
-            muscles[i].loadVerticesClothes(tfile, modelclothes.vertexNum);
+            muscles[i].loadVerticesClothes(reader, modelclothes.vertexNum);
 
             // skip more stuff
             lSize = 1; //sizeof(bool);
-            fseek(tfile, lSize, SEEK_CUR);
+            reader.skip(lSize);
             lSize = sizeof(int);
-            fseek(tfile, lSize, SEEK_CUR);
-            fseek(tfile, lSize, SEEK_CUR);
+            reader.skip(lSize);
+            reader.skip(lSize);
         }
 
         // ???
@@ -893,26 +1039,13 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
             }
         }
 
-        // use opengl for its matrix math
+        // move the vertices into the space of their muscle
         for (int i = 0; i < modelclothes.vertexNum; i++) {
             modelclothes.vertex[i] = modelclothes.vertex[i] - (muscles[modelclothes.owner[i]].parent1->position + muscles[modelclothes.owner[i]].parent2->position) / 2;
-            glMatrixMode(GL_MODELVIEW);
-            glPushMatrix();
-            glLoadIdentity();
-            glRotatef(muscles[modelclothes.owner[i]].rotate3, 0, 1, 0);
-            glRotatef(muscles[modelclothes.owner[i]].rotate2 - 90, 0, 0, 1);
-            glRotatef(muscles[modelclothes.owner[i]].rotate1 - 90, 0, 1, 0);
-            glTranslatef(modelclothes.vertex[i].x, modelclothes.vertex[i].y, modelclothes.vertex[i].z);
-            glGetFloatv(GL_MODELVIEW_MATRIX, M);
-            modelclothes.vertex[i].x = M[12];
-            modelclothes.vertex[i].y = M[13];
-            modelclothes.vertex[i].z = M[14];
-            glPopMatrix();
+            modelclothes.vertex[i] = restRotations[modelclothes.owner[i]].transformPoint(modelclothes.vertex[i]);
+            modelclothes.normals[i] = restRotations[modelclothes.owner[i]].transformVector(modelclothes.normals[i]);
         }
-
-        modelclothes.CalculateNormals(0);
     }
-    fclose(tfile);
 
     for (int i = 0; i < num_joints; i++) {
         for (j = 0; j < num_joints; j++) {
@@ -922,5 +1055,30 @@ void Skeleton::Load(const std::string& filename, const std::string& lowfilename,
         }
     }
 
-    free = 0;
+    templ.joints = joints;
+    for (Joint& joint : templ.joints) {
+        if (joint.parent) {
+            joint.parent = &templ.joints[joint.parent - &joints[0]];
+        }
+    }
+    templ.muscles = muscles;
+    for (Muscle& muscle : templ.muscles) {
+        muscle.parent1 = &templ.joints[muscle.parent1 - &joints[0]];
+        muscle.parent2 = &templ.joints[muscle.parent2 - &joints[0]];
+    }
+
+    memcpy(templ.forwardjoints, forwardjoints, sizeof(forwardjoints));
+    memcpy(templ.lowforwardjoints, lowforwardjoints, sizeof(lowforwardjoints));
+    memcpy(templ.jointlabels, jointlabels, sizeof(jointlabels));
+    templ.forward = forward;
+    templ.lowforward = lowforward;
+    for (int i = 0; i < 5; i++) {
+        templ.specialforward[i] = specialforward[i];
+    }
+
+    templ.seams.build(model[0]);
+    templ.seamslow.build(modellow);
+    if (clothes) {
+        templ.seamsclothes.build(modelclothes);
+    }
 }
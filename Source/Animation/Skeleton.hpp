@@ -25,14 +25,80 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Animation/Joint.hpp"
 #include "Animation/Muscle.hpp"
 #include "Graphic/Models.hpp"
+#include "Graphic/SkinTexture.hpp"
+#include "Graphic/SkinnedMesh.hpp"
 #include "Graphic/Sprite.hpp"
 #include "Graphic/gamegl.hpp"
 #include "Math/XYZ.hpp"
 #include "Objects/Object.hpp"
 #include "Utils/binio.h"
 
+#include <memory>
+#include <vector>
+
 const int max_joints = 50;
 
+/* Vertices of a skinned model that don't move rigidly with one muscle,
+ * because a triangle around them spans several muscles or they belong to
+ * none. Every other normal just follows its muscle's rotation, these get
+ * rebuilt from the skinned faces in triangles.
+ */
+class NormalSeams
+{
+public:
+    std::vector<int> vertices;
+    /* Faces around vertices[i] are triangles[faces[firstFace[i]]] up to
+     * triangles[faces[firstFace[i + 1]]] */
+    std::vector<int> firstFace;
+    std::vector<int> faces;
+    std::vector<int> triangles;
+
+    /* Find the seams from the muscle owners of a model in muscle space */
+    void build(const Model& model);
+    /* Recompute the seam normals and their face normals on a skinned model */
+    void apply(Model& model) const;
+};
+
+/* Immutable data shared by every skeleton built from the same set of files
+ * (one per PersonType and clothes flag): rest pose joints and muscles, the
+ * muscle vertex lists, the models baked into muscle space and the
+ * untransformed draw models that each person clones. */
+class SkeletonTemplate
+{
+public:
+    std::vector<Joint> joints;
+    std::vector<Muscle> muscles;
+
+    int forwardjoints[3];
+    XYZ forward;
+
+    int lowforwardjoints[3];
+    XYZ lowforward;
+
+    XYZ specialforward[5];
+    int jointlabels[max_joints];
+
+    Model model[7];
+    Model modellow;
+    Model modelclothes;
+    int num_models;
+
+    Model drawmodel;
+    Model drawmodellow;
+    Model drawmodelclothes;
+
+    NormalSeams seams;
+    NormalSeams seamslow;
+    NormalSeams seamsclothes;
+
+    bool clothes;
+
+    SkeletonTemplate();
+
+    /* Drop cached templates, e.g. when the enabled packs change */
+    static void clearCache();
+};
+
 class Skeleton
 {
 public:
@@ -53,20 +119,22 @@ public:
     XYZ specialforward[5];
     int jointlabels[max_joints];
 
-    Model model[7];
-    Model modellow;
-    Model modelclothes;
-    int num_models;
+    /* Shared rest pose data, the muscle vertex lists live in base->muscles */
+    std::shared_ptr<const SkeletonTemplate> base;
 
     Model drawmodel;
     Model drawmodellow;
     Model drawmodelclothes;
+    /* drawmodel posed by the GPU, its vertices only get skinned by syncDrawModel() */
+    SkinnedMesh skinnedMesh;
+    /* drawmodel's normals got skinned, its face normals are only rebuilt
+     * on the seams until syncDrawModel() */
+    bool faceNormalsStale;
 
     bool clothes;
     bool spinny;
 
-    GLubyte skinText[512 * 512 * 3];
-    int skinsize;
+    SkinTexture skin;
 
     float checkdelay;
 
@@ -84,11 +152,15 @@ public:
     void FindRotationJoint(int which);
     void FindRotationJointSameTwist(int which);
     void FindRotationMuscle(int which, int animation);
+    /* Bring drawmodel's vertices and face normals up to date for ray tests */
+    void syncDrawModel();
     void Load(const std::string& fileName, const std::string& lowfileName, const std::string& clothesfileName, const std::string& modelfileName, const std::string& model2fileName, const std::string& model3fileName, const std::string& model4fileName, const std::string& model5fileNamee, const std::string& model6fileName, const std::string& model7fileName, const std::string& modellowfileName, const std::string& modelclothesfileName, bool aclothes);
 
     Skeleton();
 
 private:
+    void buildTemplate(SkeletonTemplate& templ, const std::string& fileName, const std::string& lowfileName, const std::string& clothesfileName, const std::string modelfileNames[7], const std::string& modellowfileName, const std::string& modelclothesfileName, bool aclothes);
+
     // convenience functions
     // only for Skeleton.cpp
     inline Joint& joint(int bodypart) { return joints[jointlabels[bodypart]]; }
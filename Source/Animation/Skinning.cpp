@@ -0,0 +1,155 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Animation/Skinning.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define SKINNING_SSE 1
+#endif
+
+SkinMatrix::SkinMatrix()
+{
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++) {
+            rows[row][col] = (row == col) ? 1 : 0;
+        }
+    }
+}
+
+SkinMatrix::SkinMatrix(const Matrix4& muscle, const XYZ& proportion, float scale)
+{
+    const float scales[3] = { proportion.x, proportion.y, proportion.z };
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            rows[row][col] = muscle.m[col * 4 + row] * scales[col] * scale;
+        }
+        rows[row][3] = muscle.m[12 + row] * scale;
+    }
+}
+
+SkinMatrix SkinMatrix::forNormals(const Matrix4& muscle, const XYZ& proportion)
+{
+    // muscle is a pure rotation, so only the proportions need inverting
+    XYZ inverse;
+    inverse.x = proportion.x != 0 ? 1 / proportion.x : 0;
+    inverse.y = proportion.y != 0 ? 1 / proportion.y : 0;
+    inverse.z = proportion.z != 0 ? 1 / proportion.z : 0;
+    SkinMatrix matrix(muscle, inverse, 1);
+    for (int row = 0; row < 3; row++) {
+        matrix.rows[row][3] = 0;
+    }
+    return matrix;
+}
+
+#if SKINNING_SSE
+namespace {
+
+struct SkinColumns
+{
+    __m128 x, y, z, w;
+
+    SkinColumns(const SkinMatrix& matrix)
+        : x(_mm_setr_ps(matrix.rows[0][0], matrix.rows[1][0], matrix.rows[2][0], 0))
+        , y(_mm_setr_ps(matrix.rows[0][1], matrix.rows[1][1], matrix.rows[2][1], 0))
+        , z(_mm_setr_ps(matrix.rows[0][2], matrix.rows[1][2], matrix.rows[2][2], 0))
+        , w(_mm_setr_ps(matrix.rows[0][3], matrix.rows[1][3], matrix.rows[2][3], 0))
+    {
+    }
+
+    inline void store(__m128 vx, __m128 vy, __m128 vz, XYZ& out) const
+    {
+        __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, vx), _mm_mul_ps(y, vy)), _mm_add_ps(_mm_mul_ps(z, vz), w));
+        // XYZ is 12 bytes, a 16 byte store would spill into the next vertex
+        _mm_storel_pi((__m64*)&out.x, result);
+        _mm_store_ss(&out.z, _mm_movehl_ps(result, result));
+    }
+};
+
+} // namespace
+#endif
+
+void Skinning::transform(const SkinMatrix& matrix, const XYZ* rest, const int* indices, size_t count, XYZ* out)
+{
+#if SKINNING_SSE
+    const SkinColumns columns(matrix);
+    for (size_t i = 0; i < count; i++) {
+        const XYZ& v = rest[indices[i]];
+        columns.store(_mm_set1_ps(v.x), _mm_set1_ps(v.y), _mm_set1_ps(v.z), out[indices[i]]);
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        out[indices[i]] = matrix.transform(rest[indices[i]]);
+    }
+#endif
+}
+
+void Skinning::transform(const SkinMatrix& matrix, const XYZ* rest, const XYZ* morphTarget, float morphness, const int* indices, size_t count, XYZ* out)
+{
+    const float restWeight = 1 - morphness;
+#if SKINNING_SSE
+    const SkinColumns columns(matrix);
+    const __m128 a = _mm_set1_ps(restWeight);
+    const __m128 b = _mm_set1_ps(morphness);
+    for (size_t i = 0; i < count; i++) {
+        const XYZ& v0 = rest[indices[i]];
+        const XYZ& v1 = morphTarget[indices[i]];
+        const __m128 vx = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v0.x), a), _mm_mul_ps(_mm_set1_ps(v1.x), b));
+        const __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v0.y), a), _mm_mul_ps(_mm_set1_ps(v1.y), b));
+        const __m128 vz = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(v0.z), a), _mm_mul_ps(_mm_set1_ps(v1.z), b));
+        columns.store(vx, vy, vz, out[indices[i]]);
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        const XYZ& v0 = rest[indices[i]];
+        const XYZ& v1 = morphTarget[indices[i]];
+        XYZ v;
+        v.x = v0.x * restWeight + v1.x * morphness;
+        v.y = v0.y * restWeight + v1.y * morphness;
+        v.z = v0.z * restWeight + v1.z * morphness;
+        out[indices[i]] = matrix.transform(v);
+    }
+#endif
+}
+
+void Skinning::transformNormals(const SkinMatrix& matrix, const XYZ* rest, const int* indices, size_t count, XYZ* out)
+{
+    for (size_t i = 0; i < count; i++) {
+        XYZ& normal = out[indices[i]];
+        normal = matrix.transform(rest[indices[i]]);
+        Normalise(&normal);
+    }
+}
+
+void Skinning::transformNormals(const SkinMatrix& matrix, const XYZ* rest, const XYZ* morphTarget, float morphness, const int* indices, size_t count, XYZ* out)
+{
+    const float restWeight = 1 - morphness;
+    for (size_t i = 0; i < count; i++) {
+        const XYZ& n0 = rest[indices[i]];
+        const XYZ& n1 = morphTarget[indices[i]];
+        XYZ n;
+        n.x = n0.x * restWeight + n1.x * morphness;
+        n.y = n0.y * restWeight + n1.y * morphness;
+        n.z = n0.z * restWeight + n1.z * morphness;
+        XYZ& normal = out[indices[i]];
+        normal = matrix.transform(n);
+        Normalise(&normal);
+    }
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SKINNING_HPP_
+#define _SKINNING_HPP_
+
+#include "Math/Matrix.hpp"
+#include "Math/XYZ.hpp"
+
+#include <cstddef>
+
+/* Rest pose to model space transform of one muscle, as three rows of
+ * (x, y, z, translation). The person's proportions scale rest pose vertices
+ * before the muscle matrix applies, and its scale applies to the result.
+ */
+class SkinMatrix
+{
+public:
+    float rows[3][4];
+
+    SkinMatrix();
+    SkinMatrix(const Matrix4& muscle, const XYZ& proportion, float scale);
+
+    /* Inverse transpose of the rest to model space transform, without the
+     * translation, for normals. The person's scale doesn't matter there. */
+    static SkinMatrix forNormals(const Matrix4& muscle, const XYZ& proportion);
+
+    inline XYZ transform(const XYZ& point) const;
+};
+
+/* Skins vertex arrays on the CPU, one SkinMatrix per muscle.
+ *
+ * Vertices are picked from the rest pose by index and written at the same
+ * index of the destination, which is how muscles own model vertices.
+ */
+class Skinning
+{
+public:
+    static void transform(const SkinMatrix& matrix, const XYZ* rest, const int* indices, size_t count, XYZ* out);
+    /* Same on rest * (1 - morphness) + morphTarget * morphness */
+    static void transform(const SkinMatrix& matrix, const XYZ* rest, const XYZ* morphTarget, float morphness, const int* indices, size_t count, XYZ* out);
+
+    /* Rotate rest pose normals by a SkinMatrix::forNormals() and renormalise them */
+    static void transformNormals(const SkinMatrix& matrix, const XYZ* rest, const int* indices, size_t count, XYZ* out);
+    static void transformNormals(const SkinMatrix& matrix, const XYZ* rest, const XYZ* morphTarget, float morphness, const int* indices, size_t count, XYZ* out);
+};
+
+inline XYZ SkinMatrix::transform(const XYZ& point) const
+{
+    XYZ result;
+    result.x = rows[0][0] * point.x + rows[0][1] * point.y + rows[0][2] * point.z + rows[0][3];
+    result.y = rows[1][0] * point.x + rows[1][1] * point.y + rows[1][2] * point.z + rows[1][3];
+    result.z = rows[2][0] * point.x + rows[2][1] * point.y + rows[2][2] * point.z + rows[2][3];
+    return result;
+}
+
+#endif
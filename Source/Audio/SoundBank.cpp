@@ -0,0 +1,260 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Audio/SoundBank.hpp"
+
+#include "Audio/openal_wrapper.hpp"
+#include "Utils/Folders.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#if PLATFORM_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char bankMagic[4] = { 'L', 'G', 'S', 'B' };
+
+struct BankHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+uint64_t alignUp(uint64_t value)
+{
+    return (value + SoundBank::kAlignment - 1) & ~uint64_t(SoundBank::kAlignment - 1);
+}
+
+} // namespace
+
+SoundBank::SoundBank()
+    : base(nullptr)
+    , length(0)
+{
+}
+
+SoundBank::~SoundBank()
+{
+    closeCache();
+}
+
+void SoundBank::load(const std::vector<std::string>& paths)
+{
+    clear();
+    sounds.assign(paths.size(), Sound{ 0, 0, nullptr, 0 });
+    decoded.resize(paths.size());
+
+    std::string cachePath = Folders::getUserDataPath() + "/Cache";
+    Folders::makeDirectory(cachePath);
+    cachePath += "/Sounds.bank";
+    openCache(cachePath);
+
+    // Zero marks sounds that can't be cached, their file couldn't be hashed
+    std::vector<uint64_t> keys(paths.size(), 0);
+    std::atomic<size_t> next(0);
+    std::atomic<bool> missed(false);
+
+    auto work = [&]() {
+        for (size_t i = next++; i < paths.size(); i = next++) {
+            if (paths[i].empty()) {
+                continue;
+            }
+            uint64_t key;
+            if (Folders::getResourceHash(paths[i], &key)) {
+                keys[i] = key;
+                const Entry* entry = findEntry(key);
+                if (entry != nullptr) {
+                    sounds[i] = Sound{ (int)entry->channels, (int)entry->rate, base + entry->offset, (size_t)entry->size };
+                    continue;
+                }
+                missed = true;
+            }
+
+            int channels, rate;
+            size_t size;
+            unsigned char* data = (unsigned char*)OPENAL_Sample_Decode(paths[i].c_str(), &channels, &rate, &size);
+            if (data == NULL) {
+                keys[i] = 0;
+                continue;
+            }
+            decoded[i].assign(data, data + size);
+            free(data);
+            sounds[i] = Sound{ channels, rate, decoded[i].data(), size };
+        }
+    };
+
+    unsigned count = std::thread::hardware_concurrency();
+    count = std::max(1u, std::min(8u, count));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < count; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    if (missed) {
+        saveCache(cachePath, keys);
+    }
+}
+
+void SoundBank::clear()
+{
+    sounds.clear();
+    decoded.clear();
+    closeCache();
+}
+
+bool SoundBank::openCache(const std::string& path)
+{
+    closeCache();
+
+#if PLATFORM_UNIX
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BankHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    base = (const unsigned char*)mapping;
+    length = st.st_size;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (buffer.size() < sizeof(BankHeader)) {
+        buffer.clear();
+        return false;
+    }
+    base = buffer.data();
+    length = buffer.size();
+#endif
+
+    BankHeader header;
+    memcpy(&header, base, sizeof(header));
+    bool valid = memcmp(header.magic, bankMagic, 4) == 0 && header.version == kVersion &&
+                 sizeof(header) + uint64_t(header.count) * sizeof(Entry) <= length;
+    if (valid) {
+        entries.resize(header.count);
+        memcpy(entries.data(), base + sizeof(header), header.count * sizeof(Entry));
+        for (const Entry& entry : entries) {
+            valid = valid && (entry.channels == 1 || entry.channels == 2) && entry.offset <= length && entry.size <= length - entry.offset;
+        }
+    }
+    if (!valid) {
+        fprintf(stderr, "Ignoring invalid sound cache %s\n", path.c_str());
+        closeCache();
+    }
+    return valid;
+}
+
+void SoundBank::closeCache()
+{
+#if PLATFORM_UNIX
+    if (base != nullptr) {
+        munmap((void*)base, length);
+    }
+#else
+    buffer.clear();
+#endif
+    base = nullptr;
+    length = 0;
+    entries.clear();
+}
+
+const SoundBank::Entry* SoundBank::findEntry(uint64_t key) const
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                               [](const Entry& entry, uint64_t k) { return entry.key < k; });
+    if (it != entries.end() && it->key == key) {
+        return &(*it);
+    }
+    return nullptr;
+}
+
+void SoundBank::saveCache(const std::string& path, const std::vector<uint64_t>& keys) const
+{
+    // One entry per distinct source, the same file can back several sounds
+    std::vector<std::pair<uint64_t, size_t>> sources;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] != 0 && sounds[i].data != nullptr) {
+            sources.emplace_back(keys[i], i);
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+    sources.erase(std::unique(sources.begin(), sources.end(), [](const std::pair<uint64_t, size_t>& a, const std::pair<uint64_t, size_t>& b) { return a.first == b.first; }), sources.end());
+
+    BankHeader header;
+    memcpy(header.magic, bankMagic, 4);
+    header.version = kVersion;
+    header.count = sources.size();
+    header.reserved = 0;
+
+    std::vector<Entry> table;
+    uint64_t offset = alignUp(sizeof(header) + sources.size() * sizeof(Entry));
+    for (const auto& source : sources) {
+        const Sound& sound = sounds[source.second];
+        table.push_back(Entry{ source.first, (uint32_t)sound.channels, (uint32_t)sound.rate, offset, sound.size });
+        offset = alignUp(offset + sound.size);
+    }
+
+    std::string tempPath = path + ".tmp";
+    FILE* tfile = fopen(tempPath.c_str(), "wb");
+    if (tfile == NULL) {
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, tfile) == 1 &&
+                   fwrite(table.data(), sizeof(Entry), table.size(), tfile) == table.size();
+    const char padding[kAlignment] = {};
+    for (size_t i = 0; written && i < table.size(); i++) {
+        long position = ftell(tfile);
+        written = fwrite(padding, 1, table[i].offset - position, tfile) == table[i].offset - position &&
+                  fwrite(sounds[sources[i].second].data, 1, table[i].size, tfile) == table[i].size;
+    }
+    written = (fclose(tfile) == 0) && written;
+    if (!written || rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+    }
+}
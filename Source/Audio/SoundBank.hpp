@@ -0,0 +1,97 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SOUND_BANK_HPP_
+#define _SOUND_BANK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Decoded PCM of the sound effects, cached in <userdata>/Cache/Sounds.bank
+ *
+ *   header   "LGSB", u32 version, u32 entry count, u32 reserved
+ *   entries  entry count * { u64 source key, u32 channels, u32 rate, u64 data offset, u64 data size }
+ *   data     16 bit host order samples, each blob starting on a kAlignment boundary
+ *
+ * Entries are keyed by Folders::getResourceHash and sorted by key. The bank is
+ * written in host order as it only ever gets read back on the same machine.
+ */
+class SoundBank
+{
+public:
+    static const uint32_t kVersion = 1;
+    static const uint32_t kAlignment = 16;
+
+    struct Sound
+    {
+        int channels;
+        int rate;
+        const unsigned char* data;
+        size_t size;
+    };
+
+    SoundBank();
+    ~SoundBank();
+
+    /* Fill one sound per path, looking them up in the cache or decoding them
+     * on worker threads. Empty paths and undecodable files give no data. */
+    void load(const std::vector<std::string>& paths);
+
+    size_t size() const { return sounds.size(); }
+    const Sound& operator[](size_t i) const { return sounds[i]; }
+
+    /* Drop the samples once they are uploaded */
+    void clear();
+
+    /* Make sure SoundBank never gets copied, sounds point into its mapping */
+    SoundBank(SoundBank const& other) = delete;
+    SoundBank& operator=(SoundBank const& other) = delete;
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t channels;
+        uint32_t rate;
+        uint64_t offset;
+        uint64_t size;
+    };
+    static_assert(sizeof(Entry) == 32, "bank entries are written as is");
+
+    bool openCache(const std::string& path);
+    void closeCache();
+    void saveCache(const std::string& path, const std::vector<uint64_t>& keys) const;
+    const Entry* findEntry(uint64_t key) const;
+
+    std::vector<Sound> sounds;
+    // Samples decoded this run, the others point into the cache
+    std::vector<std::vector<unsigned char>> decoded;
+
+    std::vector<Entry> entries;
+    const unsigned char* base;
+    size_t length;
+#if !PLATFORM_UNIX
+    std::vector<unsigned char> buffer;
+#endif
+};
+
+#endif
@@ -19,6 +19,7 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Audio/Sounds.hpp"
 
+#include "Audio/SoundBank.hpp"
 #include "Audio/openal_wrapper.hpp"
 #include "Utils/Folders.hpp"
 #include <filesystem>
@@ -57,22 +58,40 @@ static int snd_mode(int snd)
 }
 
 void loadAllSounds() {
+    std::vector<std::string> soundPaths(sounds_count);
+    std::vector<std::string> effectPaths(sounds_count);
     for (int i = 0; i < sounds_count; i++) {
         std::string soundFilename = sound_data[i];
 
         // Use getResourcePath to find the sound
-        std::string soundPath = Folders::getResourcePath("Sounds/" + soundFilename);
+        soundPaths[i] = Folders::getResourcePath("Sounds/" + soundFilename);
 
-        if (soundPath.empty()) {
+        if (soundPaths[i].empty()) {
             std::cerr << "Sound not found in resource paths: " << soundFilename << std::endl;
+        } else if (i < stream_firesound || i > stream_menutheme) {
+            effectPaths[i] = soundPaths[i];
+        }
+    }
+
+    // Effects are decoded all at once, or come straight from the cache of a previous run
+    SoundBank bank;
+    bank.load(effectPaths);
+
+    for (int i = 0; i < sounds_count; i++) {
+        const std::string& soundPath = soundPaths[i];
+        if (soundPath.empty()) {
             continue; // Skip to the next sound if the file is not found
         }
 
         //std::cout << "Loading Sound: " << soundPath << std::endl;
 
-        // Load the sound directly from its path
-        samp[i] = OPENAL_Sample_Load(OPENAL_FREE, soundPath.c_str(), snd_mode(1), 0, 0);
-        
+        // Music and ambiences get decoded while they play
+        if (i >= stream_firesound && i <= stream_menutheme) {
+            samp[i] = OPENAL_Stream_Open(soundPath.c_str(), snd_mode(1));
+        } else if (bank[i].data != nullptr) {
+            samp[i] = OPENAL_Sample_Create(soundPath.c_str(), snd_mode(1), bank[i].channels, bank[i].rate, bank[i].data, bank[i].size);
+        }
+
         // Error checking for sound loading
         if (samp[i] == nullptr) {
             std::cerr << "Failed to load sound: " << soundPath << std::endl;
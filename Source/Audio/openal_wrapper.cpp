@@ -23,10 +23,14 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Audio/Sounds.hpp"
 #include "Game.hpp"
 #include "Math/XYZ.hpp"
+#include "Utils/Folders.hpp"
 
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <thread>
 
 extern float slomofreq;
 
@@ -42,12 +46,23 @@ typedef struct
     float position[3];
 } OPENAL_Channels;
 
+// Streams keep a few buffers queued on their channel, refilled from the decoder as they get played
+#define STREAM_BUFFER_COUNT 4
+#define STREAM_BUFFER_SIZE (64 * 1024)
+
 typedef struct OPENAL_SAMPLE
 {
     char* name;
-    ALuint bid; // buffer id.
+    ALuint bid; // buffer id, 0 for streams.
     int mode;
     int is2d;
+
+    // streams only
+    OggVorbis_File* vorbis;
+    ALuint queue[STREAM_BUFFER_COUNT];
+    ALenum format;
+    ALuint freq;
+    int channel; // channel being fed, -1 when stopped.
 } OPENAL_SAMPLE;
 
 static size_t num_channels = 0;
@@ -55,6 +70,18 @@ static OPENAL_Channels* impl_channels = NULL;
 static bool initialized = false;
 static float listener_position[3];
 
+// Held by the streaming thread while it refills queues, and by anything
+// changing what a channel plays. Recursive because OPENAL_ALL recurses.
+static std::recursive_mutex stream_mutex;
+static std::thread stream_thread;
+static bool stream_stopping = false;
+
+#ifdef __POWERPC__
+static const int bigendian = 1;
+#else
+static const int bigendian = 0;
+#endif
+
 static void set_channel_position(const int channel, const float x,
                                  const float y, const float z)
 {
@@ -81,6 +108,118 @@ static void set_channel_position(const int channel, const float x,
     }
 }
 
+/* Decode up to size bytes of a stream, going back to its start when it loops */
+static long stream_decode(OPENAL_SAMPLE* sptr, char* buf, long size)
+{
+    long filled = 0;
+    bool rewound = false;
+    while (filled < size) {
+        int bitstream = 0;
+        long rc = ov_read(sptr->vorbis, buf + filled, size - filled, bigendian, 2, 1, &bitstream);
+        if (rc > 0) {
+            filled += rc;
+            rewound = false;
+        } else if (rc == OV_HOLE) {
+            // Data went missing, the next read picks up after the gap
+            continue;
+        } else if (rc < 0) {
+            // A broken link or stream never recovers, end it instead of spinning
+            break;
+        } else if (rc == 0 && sptr->mode == OPENAL_LOOP_NORMAL && !rewound) {
+            // Keep filling the same buffer from the start so the loop has no gap
+            ov_pcm_seek(sptr->vorbis, 0);
+            rewound = true;
+        } else if (rc == 0) {
+            break;
+        }
+    }
+    return filled;
+}
+
+/* Decode into buffer bid and queue it, returns false at the end of the stream */
+static bool stream_queue(OPENAL_SAMPLE* sptr, ALuint sid, ALuint bid)
+{
+    static char buf[STREAM_BUFFER_SIZE];
+    long size = stream_decode(sptr, buf, sizeof(buf));
+    if (size <= 0) {
+        return false;
+    }
+    alBufferData(bid, sptr->format, buf, size, sptr->freq);
+    alSourceQueueBuffers(sid, 1, &bid);
+    return true;
+}
+
+/* Stop feeding the channel a stream plays on and drop its queued buffers */
+static void stream_detach(OPENAL_SAMPLE* sptr)
+{
+    if (sptr->channel < 0) {
+        return;
+    }
+    const ALuint sid = impl_channels[sptr->channel].sid;
+    alSourceStop(sid);
+    alSourcei(sid, AL_BUFFER, 0);
+    sptr->channel = -1;
+}
+
+/* Start a stream from the beginning on a stopped source */
+static void stream_attach(OPENAL_SAMPLE* sptr, int channel)
+{
+    const ALuint sid = impl_channels[channel].sid;
+    ov_pcm_seek(sptr->vorbis, 0);
+    for (int i = 0; i < STREAM_BUFFER_COUNT; i++) {
+        if (!stream_queue(sptr, sid, sptr->queue[i])) {
+            break;
+        }
+    }
+    sptr->channel = channel;
+}
+
+/* Requeue the buffers a stream's source is done with */
+static void stream_refill(OPENAL_SAMPLE* sptr)
+{
+    const ALuint sid = impl_channels[sptr->channel].sid;
+    ALint processed = 0;
+    alGetSourcei(sid, AL_BUFFERS_PROCESSED, &processed);
+    while (processed-- > 0) {
+        ALuint bid;
+        alSourceUnqueueBuffers(sid, 1, &bid);
+        stream_queue(sptr, sid, bid);
+    }
+
+    ALint state = 0;
+    ALint queued = 0;
+    alGetSourcei(sid, AL_SOURCE_STATE, &state);
+    alGetSourcei(sid, AL_BUFFERS_QUEUED, &queued);
+    if (state == AL_STOPPED) {
+        if (queued > 0) {
+            // Starved while the thread was late, pick up where it stopped
+            alSourcePlay(sid);
+        } else {
+            sptr->channel = -1;
+        }
+    }
+}
+
+static void stream_run()
+{
+    while (true) {
+        {
+            std::lock_guard<std::recursive_mutex> lock(stream_mutex);
+            if (stream_stopping) {
+                return;
+            }
+            for (unsigned i = 0; i < num_channels; i++) {
+                OPENAL_SAMPLE* sptr = impl_channels[i].sample;
+                if (sptr != NULL && sptr->vorbis != NULL && sptr->channel == (int)i) {
+                    stream_refill(sptr);
+                }
+            }
+        }
+        // A buffer lasts a good third of a second, waking up more often only costs a few calls
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
 AL_API void OPENAL_3D_Listener_SetAttributes(const float* pos, const float*, float fx, float fy, float fz, float tx, float ty, float tz)
 {
     if (!initialized) {
@@ -180,6 +319,9 @@ AL_API signed char OPENAL_Init(int mixrate, int maxsoftwarechannels, unsigned in
     }
 
     initialized = true;
+
+    stream_stopping = false;
+    stream_thread = std::thread(stream_run);
     return true;
 }
 
@@ -189,6 +331,12 @@ AL_API void OPENAL_Close()
         return;
     }
 
+    {
+        std::lock_guard<std::recursive_mutex> lock(stream_mutex);
+        stream_stopping = true;
+    }
+    stream_thread.join();
+
     ALCcontext* ctx = alcGetCurrentContext();
     if (ctx) {
         for (unsigned i = 0; i < num_channels; i++) {
@@ -292,10 +440,22 @@ static int OPENAL_PlaySoundEx(int channel, OPENAL_SAMPLE* sptr, OPENAL_DSPUNIT*
     if ((channel < 0) || (channel >= (int)num_channels)) {
         return -1;
     }
+    std::lock_guard<std::recursive_mutex> lock(stream_mutex);
+    OPENAL_SAMPLE* previous = impl_channels[channel].sample;
+    if ((previous != NULL) && (previous->vorbis != NULL) && (previous->channel == channel)) {
+        stream_detach(previous);
+    }
     alSourceStop(impl_channels[channel].sid);
     impl_channels[channel].sample = sptr;
     alSourcei(impl_channels[channel].sid, AL_BUFFER, sptr->bid);
-    alSourcei(impl_channels[channel].sid, AL_LOOPING, (sptr->mode == OPENAL_LOOP_OFF) ? AL_FALSE : AL_TRUE);
+    if (sptr->vorbis != NULL) {
+        // Streams loop by rewinding the decoder, looping the source would replay its queue
+        stream_detach(sptr);
+        alSourcei(impl_channels[channel].sid, AL_LOOPING, AL_FALSE);
+        stream_attach(sptr, channel);
+    } else {
+        alSourcei(impl_channels[channel].sid, AL_LOOPING, (sptr->mode == OPENAL_LOOP_OFF) ? AL_FALSE : AL_TRUE);
+    }
     set_channel_position(channel, 0.0f, 0.0f, 0.0f);
 
     impl_channels[channel].startpaused = ((startpaused) ? true : false);
@@ -305,25 +465,24 @@ static int OPENAL_PlaySoundEx(int channel, OPENAL_SAMPLE* sptr, OPENAL_DSPUNIT*
     return channel;
 }
 
-static void* decode_to_pcm(const char* _fname, ALenum& format, ALsizei& size, ALuint& freq)
+static FILE* open_ogg(const char* _fname)
 {
-#ifdef __POWERPC__
-    const int bigendian = 1;
-#else
-    const int bigendian = 0;
-#endif
-
     // !!! FIXME: if it's not Ogg, we don't have a decoder. I'm lazy.  :/
     char* fname = (char*)alloca(strlen(_fname) + 16);
     strcpy(fname, _fname);
-    char* ptr = strchr(fname, '.');
+    char* ptr = strrchr(fname, '.');
     if (ptr) {
         *ptr = '\0';
     }
     strcat(fname, ".ogg");
 
     // just in case...
-    FILE* io = fopen(fname, "rb");
+    return Folders::openFile(fname, "rb");
+}
+
+static void* decode_to_pcm(const char* _fname, ALenum& format, ALsizei& size, ALuint& freq)
+{
+    FILE* io = open_ogg(_fname);
     if (io == NULL) {
         return NULL;
     }
@@ -410,7 +569,6 @@ AL_API OPENAL_SAMPLE* OPENAL_Sample_Load(int index, const char* name_or_data, un
         return NULL; // this is all the game does...
     }
 
-    OPENAL_SAMPLE* retval = NULL;
     ALenum format = AL_NONE;
     ALsizei size = 0;
     ALuint frequency = 0;
@@ -419,31 +577,116 @@ AL_API OPENAL_SAMPLE* OPENAL_Sample_Load(int index, const char* name_or_data, un
         return NULL;
     }
 
+    OPENAL_SAMPLE* retval = OPENAL_Sample_Create(name_or_data, mode, (format == AL_FORMAT_MONO16) ? 1 : 2, frequency, data, size);
+    free(data);
+    return (retval);
+}
+
+AL_API void* OPENAL_Sample_Decode(const char* name, int* channels, int* rate, size_t* size)
+{
+    ALenum format = AL_NONE;
+    ALsizei pcmsize = 0;
+    ALuint frequency = 0;
+    void* data = decode_to_pcm(name, format, pcmsize, frequency);
+    if (data == NULL) {
+        return NULL;
+    }
+    *channels = (format == AL_FORMAT_MONO16) ? 1 : 2;
+    *rate = frequency;
+    *size = pcmsize;
+    return data;
+}
+
+AL_API OPENAL_SAMPLE* OPENAL_Sample_Create(const char* name, unsigned int mode, int channels, int rate, const void* data, size_t size)
+{
+    if (!initialized) {
+        return NULL;
+    }
+    if ((mode != OPENAL_HW3D) && (mode != OPENAL_2D)) {
+        return NULL; // this is all the game does...
+    }
+    if ((channels != 1) && (channels != 2)) {
+        return NULL;
+    }
+
+    OPENAL_SAMPLE* retval = NULL;
     ALuint bid = 0;
     alGetError();
     alGenBuffers(1, &bid);
     if (alGetError() == AL_NO_ERROR) {
-        alBufferData(bid, format, data, size, frequency);
+        alBufferData(bid, (channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, data, size, rate);
         retval = new OPENAL_SAMPLE;
         retval->bid = bid;
         retval->mode = OPENAL_LOOP_OFF;
         retval->is2d = (mode == OPENAL_2D);
-        retval->name = new char[strlen(name_or_data) + 1];
+        retval->vorbis = NULL;
+        retval->channel = -1;
+        retval->name = new char[strlen(name) + 1];
         if (retval->name) {
-            strcpy(retval->name, name_or_data);
+            strcpy(retval->name, name);
         }
     }
-
-    free(data);
     return (retval);
 }
 
+AL_API OPENAL_STREAM* OPENAL_Stream_Open(const char* name, unsigned int mode)
+{
+    if (!initialized) {
+        return NULL;
+    }
+    if ((mode != OPENAL_HW3D) && (mode != OPENAL_2D)) {
+        return NULL; // this is all the game does...
+    }
+
+    FILE* io = open_ogg(name);
+    if (io == NULL) {
+        return NULL;
+    }
+    OggVorbis_File* vf = new OggVorbis_File;
+    memset(vf, '\0', sizeof(*vf));
+    if (ov_open(io, vf, NULL, 0) != 0) {
+        fclose(io);
+        delete vf;
+        return NULL;
+    }
+    vorbis_info* info = ov_info(vf, -1);
+    if ((info->channels != 1) && (info->channels != 2)) {
+        ov_clear(vf);
+        delete vf;
+        return NULL;
+    }
+
+    OPENAL_STREAM* retval = new OPENAL_STREAM;
+    alGetError();
+    alGenBuffers(STREAM_BUFFER_COUNT, retval->queue);
+    if (alGetError() != AL_NO_ERROR) {
+        ov_clear(vf);
+        delete vf;
+        delete retval;
+        return NULL;
+    }
+    retval->bid = 0;
+    retval->mode = OPENAL_LOOP_OFF;
+    retval->is2d = (mode == OPENAL_2D);
+    retval->vorbis = vf;
+    retval->format = (info->channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+    retval->freq = info->rate;
+    retval->channel = -1;
+    retval->name = new char[strlen(name) + 1];
+    strcpy(retval->name, name);
+    return retval;
+}
+
 AL_API void OPENAL_Sample_Free(OPENAL_SAMPLE* sptr)
 {
     if (!initialized) {
         return;
     }
     if (sptr) {
+        std::lock_guard<std::recursive_mutex> lock(stream_mutex);
+        if (sptr->vorbis != NULL) {
+            stream_detach(sptr);
+        }
         for (unsigned i = 0; i < num_channels; i++) {
             if (impl_channels[i].sample == sptr) {
                 alSourceStop(impl_channels[i].sid);
@@ -451,7 +694,13 @@ AL_API void OPENAL_Sample_Free(OPENAL_SAMPLE* sptr)
                 impl_channels[i].sample = NULL;
             }
         }
-        alDeleteBuffers(1, &sptr->bid);
+        if (sptr->vorbis != NULL) {
+            alDeleteBuffers(STREAM_BUFFER_COUNT, sptr->queue);
+            ov_clear(sptr->vorbis);
+            delete sptr->vorbis;
+        } else {
+            alDeleteBuffers(1, &sptr->bid);
+        }
         delete[] sptr->name;
         delete sptr;
     }
@@ -539,6 +788,7 @@ AL_API signed char OPENAL_SetPaused(int channel, signed char paused)
         return false;
     }
 
+    std::lock_guard<std::recursive_mutex> lock(stream_mutex);
     ALint state = 0;
     if (impl_channels[channel].startpaused) {
         state = AL_PAUSED;
@@ -580,6 +830,11 @@ AL_API signed char OPENAL_StopSound(int channel)
     if ((channel < 0) || (channel >= (int)num_channels)) {
         return false;
     }
+    std::lock_guard<std::recursive_mutex> lock(stream_mutex);
+    OPENAL_SAMPLE* sptr = impl_channels[channel].sample;
+    if ((sptr != NULL) && (sptr->vorbis != NULL) && (sptr->channel == channel)) {
+        stream_detach(sptr);
+    }
     alSourceStop(impl_channels[channel].sid);
     impl_channels[channel].startpaused = false;
     return true;
@@ -603,6 +858,10 @@ static signed char OPENAL_Stream_Stop(OPENAL_STREAM* stream)
     if (!initialized) {
         return false;
     }
+    std::lock_guard<std::recursive_mutex> lock(stream_mutex);
+    if (stream->vorbis != NULL) {
+        stream_detach(stream);
+    }
     for (unsigned i = 0; i < num_channels; i++) {
         if (impl_channels[i].sample == (OPENAL_SAMPLE*)stream) {
             alSourceStop(impl_channels[i].sid);
@@ -614,6 +873,7 @@ static signed char OPENAL_Stream_Stop(OPENAL_STREAM* stream)
 
 AL_API signed char OPENAL_Stream_SetMode(OPENAL_STREAM* stream, unsigned int mode)
 {
+    std::lock_guard<std::recursive_mutex> lock(stream_mutex);
     return OPENAL_Sample_SetMode((OPENAL_SAMPLE*)stream, mode);
 }
 
@@ -92,7 +92,11 @@ AL_API signed char OPENAL_3D_SetAttributes_(int channel, const XYZ& pos);
 AL_API signed char OPENAL_Init(int mixrate, int maxsoftwarechannels, unsigned int flags);
 AL_API void OPENAL_Close();
 AL_API OPENAL_SAMPLE* OPENAL_Sample_Load(int index, const char* name_or_data, unsigned int mode, int offset, int length);
+/* Ogg to 16 bit host order PCM without touching the AL, safe on any thread. free() the result */
+AL_API void* OPENAL_Sample_Decode(const char* name, int* channels, int* rate, size_t* size);
+AL_API OPENAL_SAMPLE* OPENAL_Sample_Create(const char* name, unsigned int mode, int channels, int rate, const void* data, size_t size);
 AL_API void OPENAL_Sample_Free(OPENAL_SAMPLE* sptr);
+AL_API OPENAL_STREAM* OPENAL_Stream_Open(const char* name, unsigned int mode);
 AL_API signed char OPENAL_SetFrequency(int channel, bool slomo = false);
 AL_API signed char OPENAL_SetVolume(int channel, int vol);
 AL_API signed char OPENAL_SetPaused(int channel, signed char paused);
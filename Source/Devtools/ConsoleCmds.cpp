@@ -21,8 +21,11 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Devtools/ConsoleCmds.hpp"
 
 #include "Game.hpp"
+#include "Graphic/SkinnedMesh.hpp"
+#include "Graphic/Texture.hpp"
 #include "Level/Dialog.hpp"
 #include "Level/Hotspot.hpp"
+#include "Level/LevelSnapshot.hpp"
 #include "Tutorial.hpp"
 #include "Utils/Folders.hpp"
 
@@ -47,6 +50,7 @@ extern bool cellophane;
 extern int editoractive;
 extern int editorpathtype;
 extern int environment;
+extern bool gpuskinning;
 extern float fadestart;
 extern float slomospeed;
 extern float slomofreq;
@@ -120,9 +124,7 @@ static void set_metal(int pnum, const char* args)
 static void set_noclothes(int pnum, const char*)
 {
     Person::players[pnum]->numclothes = 0;
-    Person::players[pnum]->skeleton.drawmodel.textureptr.load(
-        PersonType::types[Person::players[pnum]->creature].skins[Person::players[pnum]->whichskin], 1,
-        &Person::players[pnum]->skeleton.skinText[0], &Person::players[pnum]->skeleton.skinsize);
+    Person::players[pnum]->loadSkin(PersonType::types[Person::players[pnum]->creature].skins[Person::players[pnum]->whichskin]);
 }
 
 static void set_clothes(int pnum, const char* args)
@@ -132,7 +134,7 @@ static void set_clothes(int pnum, const char* args)
 
     const std::string file_path = Folders::getResourcePath(buf);
     FILE* tfile;
-    tfile = fopen(file_path.c_str(), "rb");
+    tfile = Folders::openFile(file_path, "rb");
     if (tfile == NULL) {
         perror((std::string("Couldn't find file ") + file_path + " to assign as clothes").c_str());
 
@@ -319,6 +321,9 @@ void ch_save(const char* args)
     fpackf(tfile, "Bf Bf Bf Bf", mapcenter.x, mapcenter.y, mapcenter.z, mapradius);
 
     fclose(tfile);
+
+    // Restarting has to load what was just saved, even within the file's timestamp resolution
+    LevelSnapshot::clear();
 }
 
 void ch_tint(const char* args)
@@ -489,12 +494,12 @@ void ch_wolfie(const char*)
 
 void ch_lizardwolf(const char*)
 {
-    Person::players[0]->skeleton.drawmodel.textureptr.load("Textures/FurWolfLizard.jpg", 1, &Person::players[0]->skeleton.skinText[0], &Person::players[0]->skeleton.skinsize);
+    Person::players[0]->loadSkin("Textures/FurWolfLizard.jpg");
 }
 
 void ch_darko(const char*)
 {
-    Person::players[0]->skeleton.drawmodel.textureptr.load("Textures/FurDarko.jpg", 1, &Person::players[0]->skeleton.skinText[0], &Person::players[0]->skeleton.skinsize);
+    Person::players[0]->loadSkin("Textures/FurDarko.jpg");
 }
 
 void ch_sizemin(const char*)
@@ -659,9 +664,7 @@ void ch_default(const char*)
     Person::players[0]->setProportions(1, 1, 1, 1);
 
     Person::players[0]->numclothes = 0;
-    Person::players[0]->skeleton.drawmodel.textureptr.load(
-        PersonType::types[Person::players[0]->creature].skins[Person::players[0]->whichskin], 1,
-        &Person::players[0]->skeleton.skinText[0], &Person::players[0]->skeleton.skinsize);
+    Person::players[0]->loadSkin(PersonType::types[Person::players[0]->creature].skins[Person::players[0]->whichskin]);
 
     editoractive = typeactive;
     Person::players[0]->immobile = 0;
@@ -755,3 +758,29 @@ void ch_skybox(const char*)
     terrain.DoShadows();
     Object::DoShadows();
 }
+
+void ch_texstats(const char*)
+{
+    Texture::RegistryStats stats = Texture::getRegistryStats();
+    printf("Textures: %u shared, %u registry hits, %u misses, %.1f MB resident\n",
+           stats.sharedTextures, stats.hits, stats.misses, stats.residentBytes / (1024.f * 1024.f));
+}
+
+void ch_gpuskinning(const char*)
+{
+    gpuskinning = !gpuskinning;
+    if (gpuskinning && !SkinnedMesh::isSupported()) {
+        printf("GPU skinning isn't supported by this driver, staying on CPU skinning\n");
+    }
+    // repose everyone right away on the newly selected path
+    for (unsigned i = 0; i < Person::players.size(); i++) {
+        Person::players[i]->updatedelay = 0;
+        Person::players[i]->normalsupdatedelay = 0;
+    }
+}
+
+void ch_skinbudget(const char* args)
+{
+    // microseconds of skinning per frame, 0 lifts the limit
+    LodScheduler::budget = atof(args);
+}
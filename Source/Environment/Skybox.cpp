@@ -33,12 +33,12 @@ extern float skyboxb;
 void SkyBox::load(const std::string& ffront, const std::string& fleft, const std::string& fback,
                   const std::string& fright, const std::string& fup, const std::string& fdown)
 {
-    front.load(ffront, true);
-    left.load(fleft, true);
-    back.load(fback, true);
-    right.load(fright, true);
-    up.load(fup, true);
-    down.load(fdown, true);
+    front.loadAsync(ffront, true);
+    left.loadAsync(fleft, true);
+    back.loadAsync(fback, true);
+    right.loadAsync(fright, true);
+    up.loadAsync(fup, true);
+    down.loadAsync(fdown, true);
 }
 
 void SkyBox::draw()
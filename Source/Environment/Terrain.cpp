@@ -40,6 +40,38 @@ extern float blurness;
 extern float targetblurness;
 extern bool skyboxtexture;
 
+namespace {
+
+const char terrainBakeMagic[4] = { 'L', 'G', 'T', 'B' };
+const uint32_t terrainBakeVersion = 1;
+
+struct TerrainBakeHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    int32_t size;
+    int32_t lighting;
+};
+
+/* FNV-1a, keys only have to tell inputs apart */
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+uint64_t hashValue(uint64_t hash, const T& value)
+{
+    return hashBytes(hash, &value, sizeof(value));
+}
+
+} // namespace
+
 //Functions
 
 int Terrain::lineTerrain(XYZ p1, XYZ p2, XYZ* p)
@@ -415,26 +447,31 @@ bool Terrain::load(const std::string& fileName)
 
     float temptexdetail = texdetail;
 
+    // Same heightmap bytes, environment and scale always give the same terrain
+    const std::string path = Folders::getResourcePath(fileName);
+    uint64_t sourceKey;
+    bakeKey = 0;
+    if (Folders::getResourceHash(path, &sourceKey)) {
+        bakeKey = hashValue(hashValue(hashValue(14695981039346656037ull, sourceKey), environment), scale);
+        if (loadBake(bakePath(bakeKey, "height"), bakeKey, false)) {
+            patch_elements = (size / subdivision) * (size / subdivision) * 54;
+            return true;
+        }
+    }
+
     ImageRec texture;
+    texture.dropAlpha = true;
 
     //Load Image
-    if (!load_image(Folders::getResourcePath(fileName).c_str(), texture)) {
+    if (!load_image(path.c_str(), texture)) {
+        bakeKey = 0;
         return false;
     }
-
-    //Is it valid?
-    if (texture.bpp > 24) {
-        int bytesPerPixel = texture.bpp / 8;
-
-        int tempnum = 0;
-        for (i = 0; i < (long)(texture.sizeY * texture.sizeX * bytesPerPixel); i++) {
-            if ((i + 1) % 4) {
-                texture.data[tempnum] = texture.data[i];
-                tempnum++;
-            }
-        }
+    if (texture.sizeX > max_terrain_size || texture.sizeY != texture.sizeX) {
+        std::cerr << "Heightmap " << fileName << " must be square and at most " << max_terrain_size << " pixels wide" << std::endl;
+        bakeKey = 0;
+        return false;
     }
-    texture.bpp = 24;
     Game::LoadingScreen();
 
     texdetail = temptexdetail;
@@ -686,6 +723,9 @@ bool Terrain::load(const std::string& fileName)
     patch_elements = patch_size * patch_size * 54;
     CalculateNormals();
 
+    if (bakeKey) {
+        saveBake(bakePath(bakeKey, "height"), bakeKey, false);
+    }
     return true;
 }
 
@@ -1369,6 +1409,26 @@ void Terrain::DoShadows()
     int patchx, patchz;
     float shadowed;
     Normalise(&lightloc);
+
+    // Lighting only depends on the terrain, the light and where the objects casting shadows are
+    uint64_t lightKey = 0;
+    if (bakeKey) {
+        lightKey = hashValue(hashValue(hashValue(bakeKey, lightloc), light.color), light.ambient);
+        for (const std::unique_ptr<Object>& object : Object::objects) {
+            lightKey = hashValue(lightKey, object->type);
+            lightKey = hashValue(lightKey, object->position);
+            lightKey = hashValue(hashValue(hashValue(lightKey, object->yaw), object->pitch), object->scale);
+        }
+        if (loadBake(bakePath(lightKey, "light"), lightKey, true)) {
+            for (unsigned int i = 0; i < subdivision; i++) {
+                for (unsigned int j = 0; j < subdivision; j++) {
+                    UpdateVertexArray(i, j);
+                }
+            }
+            return;
+        }
+    }
+
     //Calculate shadows
     for (short int i = 0; i < size; i++) {
         for (short int j = 0; j < size; j++) {
@@ -1477,6 +1537,10 @@ void Terrain::DoShadows()
         }
     }
 
+    if (lightKey) {
+        saveBake(bakePath(lightKey, "light"), lightKey, true);
+    }
+
     for (unsigned int i = 0; i < subdivision; i++) {
         for (unsigned int j = 0; j < subdivision; j++) {
             UpdateVertexArray(i, j);
@@ -1484,9 +1548,100 @@ void Terrain::DoShadows()
     }
 }
 
+std::vector<Terrain::BakedRows> Terrain::heightRows()
+{
+    return {
+        { (unsigned char*)heightmap, sizeof(heightmap[0]), size * sizeof(heightmap[0][0]), size },
+        { (unsigned char*)texoffsetx, sizeof(texoffsetx[0]), size * sizeof(texoffsetx[0][0]), size },
+        { (unsigned char*)texoffsety, sizeof(texoffsety[0]), size * sizeof(texoffsety[0][0]), size },
+        { (unsigned char*)opacityother, sizeof(opacityother[0]), size * sizeof(opacityother[0][0]), size },
+        { (unsigned char*)normals, sizeof(normals[0]), size * sizeof(normals[0][0]), size },
+        { (unsigned char*)facenormals, sizeof(facenormals[0]), size * sizeof(facenormals[0][0]), size },
+        { (unsigned char*)textureness, sizeof(textureness[0]), sizeof(textureness[0]), subdivision },
+    };
+}
+
+std::vector<Terrain::BakedRows> Terrain::lightRows()
+{
+    return {
+        { (unsigned char*)colors, sizeof(colors[0]), size * sizeof(colors[0][0]), size },
+    };
+}
+
+std::string Terrain::bakePath(uint64_t key, const char* extension)
+{
+    std::string cacheDir = Folders::getUserDataPath() + "/Cache";
+    Folders::makeDirectory(cacheDir);
+    cacheDir += "/Terrain";
+    Folders::makeDirectory(cacheDir);
+
+    char name[48];
+    snprintf(name, sizeof(name), "/%016llx.%s", (unsigned long long)key, extension);
+    return cacheDir + name;
+}
+
+bool Terrain::loadBake(const std::string& path, uint64_t key, bool lighting)
+{
+    FILE* tfile = fopen(path.c_str(), "rb");
+    if (tfile == NULL) {
+        return false;
+    }
+
+    TerrainBakeHeader header;
+    bool valid = fread(&header, sizeof(header), 1, tfile) == 1 &&
+                 memcmp(header.magic, terrainBakeMagic, 4) == 0 && header.version == terrainBakeVersion &&
+                 header.key == key && header.lighting == (lighting ? 1 : 0) &&
+                 header.size > 0 && header.size <= max_terrain_size;
+    // Lighting is baked for the terrain load() left, which has to be that size already
+    valid = valid && (!lighting || header.size == size);
+    if (valid) {
+        const short oldSize = size;
+        size = header.size;
+        for (const BakedRows& array : (lighting ? lightRows() : heightRows())) {
+            for (int row = 0; valid && row < array.rows; row++) {
+                valid = fread(array.base + row * array.rowStride, 1, array.rowBytes, tfile) == array.rowBytes;
+            }
+        }
+        valid = valid && fgetc(tfile) == EOF;
+        if (!valid) {
+            size = oldSize;
+        }
+    }
+    fclose(tfile);
+    // A partial read leaves garbage behind, the caller recomputes everything it covers
+    return valid;
+}
+
+void Terrain::saveBake(const std::string& path, uint64_t key, bool lighting)
+{
+    TerrainBakeHeader header;
+    memcpy(header.magic, terrainBakeMagic, 4);
+    header.version = terrainBakeVersion;
+    header.key = key;
+    header.size = size;
+    header.lighting = lighting ? 1 : 0;
+
+    std::string tempPath = path + ".tmp";
+    FILE* tfile = fopen(tempPath.c_str(), "wb");
+    if (tfile == NULL) {
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, tfile) == 1;
+    for (const BakedRows& array : (lighting ? lightRows() : heightRows())) {
+        for (int row = 0; written && row < array.rows; row++) {
+            written = fwrite(array.base + row * array.rowStride, 1, array.rowBytes, tfile) == array.rowBytes;
+        }
+    }
+    written = (fclose(tfile) == 0) && written;
+    if (!written || rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+    }
+}
+
 Terrain::Terrain()
 {
     size = 0;
+    bakeKey = 0;
 
     scale = 1.0f;
     type = 0;
@@ -29,6 +29,10 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Math/XYZ.hpp"
 #include "Utils/ImageIO.hpp"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #define max_terrain_size 256
 #define curr_terrain_size size
 #define subdivision 64
@@ -107,6 +111,25 @@ public:
     Terrain();
 
 private:
+    /* Heightmap, environment and scale load() worked from, 0 when nothing can be cached */
+    uint64_t bakeKey;
+
+    /* size rows of an array derived from the heightmap, as stored in a bake file */
+    struct BakedRows
+    {
+        unsigned char* base;
+        size_t rowStride;
+        size_t rowBytes;
+        int rows;
+    };
+
+    /* What load() computes from the heightmap, then what DoShadows() lights */
+    std::vector<BakedRows> heightRows();
+    std::vector<BakedRows> lightRows();
+    bool loadBake(const std::string& path, uint64_t key, bool lighting);
+    void saveBake(const std::string& path, uint64_t key, bool lighting);
+    static std::string bakePath(uint64_t key, const char* extension);
+
     void drawpatch(int whichx, int whichy, float opacity);
     void drawpatchother(int whichx, int whichy, float opacity);
     void drawpatchotherother(int whichx, int whichy);
@@ -146,6 +146,7 @@ void playdialoguescenesound();
 int findClosestPlayer();
 bool LoadLevel(int which);
 bool LoadLevel(const std::string& name, bool tutorial = false);
+bool PrefetchLevel(const std::string& name);
 void reloadGameAssets();
 
 void RestartLevel();
@@ -423,17 +423,12 @@ int Game::DrawGLScene(StereoSide side)
             glEnable(GL_CULL_FACE);
             glCullFace(GL_FRONT);
             glDepthMask(1);
+            // Occlusion tests draw random numbers, keep them in player order before skinning in parallel
+            std::vector<Person*> drawnPlayers;
             for (unsigned k = 0; k < Person::players.size(); k++) {
                 if (k == 0 || !Tutorial::active) {
-                    glEnable(GL_BLEND);
-                    glEnable(GL_LIGHTING);
-                    terrainlight = terrain.getLighting(Person::players[k]->coords.x, Person::players[k]->coords.z);
                     distance = distsq(&viewer, &Person::players[k]->coords);
                     distance = (viewdistance * viewdistance - (distance - (viewdistance * viewdistance * fadestart)) * (1 / (1 - fadestart))) / viewdistance / viewdistance;
-                    glColor4f(terrainlight.x, terrainlight.y, terrainlight.z, distance);
-                    if (distance >= 1) {
-                        glDisable(GL_BLEND);
-                    }
                     if (distance >= .5) {
                         checkpoint = DoRotation(Person::players[k]->skeleton.joints[fabs(Random() % Person::players[k]->skeleton.joints.size())].position, 0, Person::players[k]->yaw, 0) * Person::players[k]->scale + Person::players[k]->coords;
                         checkpoint.y += 1;
@@ -451,11 +446,24 @@ int Game::DrawGLScene(StereoSide side)
                             Person::players[k]->occluded = 0;
                         }
                         if (Person::players[k]->occluded < 25) {
-                            Person::players[k]->DrawSkeleton();
+                            drawnPlayers.push_back(Person::players[k].get());
                         }
                     }
                 }
             }
+            Person::prepareSkeletons(drawnPlayers);
+            for (Person* player : drawnPlayers) {
+                glEnable(GL_BLEND);
+                glEnable(GL_LIGHTING);
+                terrainlight = terrain.getLighting(player->coords.x, player->coords.z);
+                distance = distsq(&viewer, &player->coords);
+                distance = (viewdistance * viewdistance - (distance - (viewdistance * viewdistance * fadestart)) * (1 / (1 - fadestart))) / viewdistance / viewdistance;
+                glColor4f(terrainlight.x, terrainlight.y, terrainlight.z, distance);
+                if (distance >= 1) {
+                    glDisable(GL_BLEND);
+                }
+                player->DrawSkeleton();
+            }
         }
 
         if (!cameramode && musictype == stream_fighttheme) {
@@ -944,6 +952,15 @@ int Game::DrawGLScene(StereoSide side)
                 text->glPrint(10, 210, string, 0, .8, 1024, 768);
                 string = "Fade: " + to_string(fadestart);
                 text->glPrint(10, 180, string, 0, .8, 1024, 768);
+
+                const LodScheduler::Stats& lod = LodScheduler::getStats();
+                string = "Skinning tiers: " + to_string(lod.tiers[lod_full]) + " full, " + to_string(lod.tiers[lod_half]) + " half, " + to_string(lod.tiers[lod_low]) + " low, " + to_string(lod.tiers[lod_frozen]) + " frozen";
+                text->glPrint(10, 270, string, 0, .8, 1024, 768);
+                string = "Skinning time: " + to_string(int(lod.skinningTime)) + " us";
+                if (LodScheduler::budget > 0) {
+                    string += " of " + to_string(int(LodScheduler::budget)) + ", " + to_string(lod.demoted) + " demoted";
+                }
+                text->glPrint(10, 300, string, 0, .8, 1024, 768);
             }
         }
 
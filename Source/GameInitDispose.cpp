@@ -23,6 +23,7 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Animation/Animation.hpp"
 #include "Audio/openal_wrapper.hpp"
 #include "Graphic/Texture.hpp"
+#include "Graphic/TextureLoader.hpp"
 #include "Menu/Menu.hpp"
 #include "Utils/Folders.hpp"
 
@@ -130,7 +131,7 @@ void Game::deleteGame()
     Dispose();
 }
 
-void LoadSave(const std::string& fileName, GLubyte* array)
+void LoadSave(const std::string& fileName, GLubyte* array, size_t capacity)
 {
     LOGFUNC;
 
@@ -140,23 +141,14 @@ void LoadSave(const std::string& fileName, GLubyte* array)
     float temptexdetail = texdetail;
     texdetail = 1;
 
-    //Load Image
-    ImageRec texture;
+    //Load Image straight into array, without its alpha channel
+    ImageRec texture(array, capacity);
+    texture.dropAlpha = true;
     if (!load_image(Folders::getResourcePath(fileName).c_str(), texture)) {
         texdetail = temptexdetail;
         return;
     }
     texdetail = temptexdetail;
-
-    int bytesPerPixel = texture.bpp / 8;
-
-    int tempnum = 0;
-    for (int i = 0; i < (int)(texture.sizeY * texture.sizeX * bytesPerPixel); i++) {
-        if ((i + 1) % 4 || bytesPerPixel == 3) {
-            array[tempnum] = texture.data[i];
-            tempnum++;
-        }
-    }
 }
 
 //***************> ResizeGLScene() <******/
@@ -578,26 +570,28 @@ void Game::InitGame()
         emit_stream_np(stream_menutheme);
     }
 
-    cursortexture.load("Textures/Cursor.png", 0);
+    cursortexture.loadAsync("Textures/Cursor.png", 0);
 
-    Mapcircletexture.load("Textures/MapCircle.png", 0);
-    Mapboxtexture.load("Textures/MapBox.png", 0);
-    Maparrowtexture.load("Textures/MapArrow.png", 0);
+    Mapcircletexture.loadAsync("Textures/MapCircle.png", 0);
+    Mapboxtexture.loadAsync("Textures/MapBox.png", 0);
+    Maparrowtexture.loadAsync("Textures/MapArrow.png", 0);
 
     temptexdetail = texdetail;
     if (texdetail > 2) {
         texdetail = 2;
     }
-    Mainmenuitems[0].load("Textures/Lugaru.png", 0);
-    Mainmenuitems[1].load("Textures/NewGame.png", 0);
-    Mainmenuitems[2].load("Textures/Options.png", 0);
-    Mainmenuitems[3].load("Textures/Quit.png", 0);
-    Mainmenuitems[4].load("Textures/Eyelid.png", 0);
-    Mainmenuitems[5].load("Textures/Resume.png", 0);
-    Mainmenuitems[6].load("Textures/EndGame.png", 0);
-    Mainmenuitems[8].load("Textures/Mods.png", 0);
-    Mainmenuitems[9].load("Textures/Restart.png", 0);
-    Mainmenuitems[10].load("Textures/MapArrow.png", 0);
+    Mainmenuitems[0].loadAsync("Textures/Lugaru.png", 0);
+    Mainmenuitems[1].loadAsync("Textures/NewGame.png", 0);
+    Mainmenuitems[2].loadAsync("Textures/Options.png", 0);
+    Mainmenuitems[3].loadAsync("Textures/Quit.png", 0);
+    Mainmenuitems[4].loadAsync("Textures/Eyelid.png", 0);
+    Mainmenuitems[5].loadAsync("Textures/Resume.png", 0);
+    Mainmenuitems[6].loadAsync("Textures/EndGame.png", 0);
+    Mainmenuitems[8].loadAsync("Textures/Mods.png", 0);
+    Mainmenuitems[9].loadAsync("Textures/Restart.png", 0);
+    Mainmenuitems[10].loadAsync("Textures/MapArrow.png", 0);
+
+    TextureLoader::finishPending();
 
     texdetail = temptexdetail;
 
@@ -664,30 +658,35 @@ void Game::reloadGameAssets()
     textmono->BuildFont();
     texdetail = temptexdetail;
 
+    // Skeletons and images decoded from the previous packs must be read again
+    SkeletonTemplate::clearCache();
+    TextureLoader::clear();
+
     // Reloading textures and other assets
     Weapon::Load();
-    terrain.shadowtexture.load("Textures/Shadow.png", 0);
-    terrain.bloodtexture.load("Textures/Blood.png", 0);
-    terrain.footprinttexture.load("Textures/Footprint.png", 0);
-    hawktexture.load("Textures/Hawk.png", 0);
-    Sprite::cloudtexture.load("Textures/Cloud.png", 1);
-    cursortexture.load("Textures/Cursor.png", 0);
-
-    Mapcircletexture.load("Textures/MapCircle.png", 0);
-    Mapboxtexture.load("Textures/MapBox.png", 0);
-    Maparrowtexture.load("Textures/MapArrow.png", 0);
-
-    Mainmenuitems[0].load("Textures/Lugaru.png", 0);
-    Mainmenuitems[1].load("Textures/NewGame.png", 0);
-    Mainmenuitems[2].load("Textures/Options.png", 0);
-    Mainmenuitems[3].load("Textures/Quit.png", 0);
-    Mainmenuitems[4].load("Textures/Eyelid.png", 0);
-    Mainmenuitems[5].load("Textures/Resume.png", 0);
-    Mainmenuitems[6].load("Textures/EndGame.png", 0);
-    Mainmenuitems[8].load("Textures/Mods.png", 0);
-    Mainmenuitems[9].load("Textures/Restart.png", 0);
-    Mainmenuitems[10].load("Textures/MapArrow.png", 0);
-
+    terrain.shadowtexture.loadAsync("Textures/Shadow.png", 0);
+    terrain.bloodtexture.loadAsync("Textures/Blood.png", 0);
+    terrain.footprinttexture.loadAsync("Textures/Footprint.png", 0);
+    hawktexture.loadAsync("Textures/Hawk.png", 0);
+    Sprite::cloudtexture.loadAsync("Textures/Cloud.png", 1);
+    cursortexture.loadAsync("Textures/Cursor.png", 0);
+
+    Mapcircletexture.loadAsync("Textures/MapCircle.png", 0);
+    Mapboxtexture.loadAsync("Textures/MapBox.png", 0);
+    Maparrowtexture.loadAsync("Textures/MapArrow.png", 0);
+
+    Mainmenuitems[0].loadAsync("Textures/Lugaru.png", 0);
+    Mainmenuitems[1].loadAsync("Textures/NewGame.png", 0);
+    Mainmenuitems[2].loadAsync("Textures/Options.png", 0);
+    Mainmenuitems[3].loadAsync("Textures/Quit.png", 0);
+    Mainmenuitems[4].loadAsync("Textures/Eyelid.png", 0);
+    Mainmenuitems[5].loadAsync("Textures/Resume.png", 0);
+    Mainmenuitems[6].loadAsync("Textures/EndGame.png", 0);
+    Mainmenuitems[8].loadAsync("Textures/Mods.png", 0);
+    Mainmenuitems[9].loadAsync("Textures/Restart.png", 0);
+    Mainmenuitems[10].loadAsync("Textures/MapArrow.png", 0);
+
+    TextureLoader::finishPending();
 
     LOG("Initializing sound system...");
 
@@ -749,26 +748,26 @@ void Game::LoadStuff()
 
     Weapon::Load();
 
-    terrain.shadowtexture.load("Textures/Shadow.png", 0);
-    terrain.bloodtexture.load("Textures/Blood.png", 0);
-    terrain.breaktexture.load("Textures/Break.png", 0);
-    terrain.bloodtexture2.load("Textures/Blood.png", 0);
-
-    terrain.footprinttexture.load("Textures/Footprint.png", 0);
-    terrain.bodyprinttexture.load("Textures/Bodyprint.png", 0);
-    hawktexture.load("Textures/Hawk.png", 0);
-
-    Sprite::cloudtexture.load("Textures/Cloud.png", 1);
-    Sprite::cloudimpacttexture.load("Textures/CloudImpact.png", 1);
-    Sprite::bloodtexture.load("Textures/BloodParticle.png", 1);
-    Sprite::snowflaketexture.load("Textures/SnowFlake.png", 1);
-    Sprite::flametexture.load("Textures/Flame.png", 1);
-    Sprite::bloodflametexture.load("Textures/BloodFlame.png", 1);
-    Sprite::smoketexture.load("Textures/Smoke.png", 1);
-    Sprite::shinetexture.load("Textures/Shine.png", 1);
-    Sprite::splintertexture.load("Textures/Splinter.png", 1);
-    Sprite::leaftexture.load("Textures/Leaf.png", 1);
-    Sprite::toothtexture.load("Textures/Tooth.png", 1);
+    terrain.shadowtexture.loadAsync("Textures/Shadow.png", 0);
+    terrain.bloodtexture.loadAsync("Textures/Blood.png", 0);
+    terrain.breaktexture.loadAsync("Textures/Break.png", 0);
+    terrain.bloodtexture2.loadAsync("Textures/Blood.png", 0);
+
+    terrain.footprinttexture.loadAsync("Textures/Footprint.png", 0);
+    terrain.bodyprinttexture.loadAsync("Textures/Bodyprint.png", 0);
+    hawktexture.loadAsync("Textures/Hawk.png", 0);
+
+    Sprite::cloudtexture.loadAsync("Textures/Cloud.png", 1);
+    Sprite::cloudimpacttexture.loadAsync("Textures/CloudImpact.png", 1);
+    Sprite::bloodtexture.loadAsync("Textures/BloodParticle.png", 1);
+    Sprite::snowflaketexture.loadAsync("Textures/SnowFlake.png", 1);
+    Sprite::flametexture.loadAsync("Textures/Flame.png", 1);
+    Sprite::bloodflametexture.loadAsync("Textures/BloodFlame.png", 1);
+    Sprite::smoketexture.loadAsync("Textures/Smoke.png", 1);
+    Sprite::shinetexture.loadAsync("Textures/Shine.png", 1);
+    Sprite::splintertexture.loadAsync("Textures/Splinter.png", 1);
+    Sprite::leaftexture.loadAsync("Textures/Leaf.png", 1);
+    Sprite::toothtexture.loadAsync("Textures/Tooth.png", 1);
 
     yaw = 0;
     pitch = 0;
@@ -801,6 +800,7 @@ void Game::LoadStuff()
     viewer.x = terrain.size / 2 * terrain.scale;
     viewer.z = terrain.size / 2 * terrain.scale;
 
+    LoadingScreen();
     hawk.load("Models/Hawk.solid");
     hawk.Scale(.03, .03, .03);
     hawk.Rotate(90, 1, 1);
@@ -810,20 +810,23 @@ void Game::LoadStuff()
     hawkcoords.z = terrain.size / 2 * terrain.scale - 5 - 7;
     hawkcoords.y = terrain.getHeight(hawkcoords.x, hawkcoords.z) + 25;
 
+    LoadingScreen();
     eye.load("Models/Eye.solid");
     eye.Scale(.03, .03, .03);
     eye.CalculateNormals(0);
 
+    LoadingScreen();
     cornea.load("Models/Cornea.solid");
     cornea.Scale(.03, .03, .03);
     cornea.CalculateNormals(0);
 
+    LoadingScreen();
     iris.load("Models/Iris.solid");
     iris.Scale(.03, .03, .03);
     iris.CalculateNormals(0);
 
-    LoadSave("Textures/WolfBloodFur.png", &PersonType::types[wolftype].bloodText[0]);
-    LoadSave("Textures/BloodFur.png", &PersonType::types[rabbittype].bloodText[0]);
+    LoadSave("Textures/WolfBloodFur.png", &PersonType::types[wolftype].bloodText[0], sizeof(PersonType::types[wolftype].bloodText));
+    LoadSave("Textures/BloodFur.png", &PersonType::types[rabbittype].bloodText[0], sizeof(PersonType::types[rabbittype].bloodText));
 
     oldenvironment = -4;
 
@@ -892,6 +895,9 @@ void Game::LoadStuff()
         LoadScreenTexture();
     }
 
+    // Upload whatever the texture workers decoded in the meantime
+    TextureLoader::finishPending();
+
     if (targetlevel != 7) {
         emit_sound_at(fireendsound);
     }
@@ -26,13 +26,16 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Animation/Animation.hpp"
 #include "Audio/openal_wrapper.hpp"
 #include "Devtools/ConsoleCmds.hpp"
+#include "Graphic/TextureLoader.hpp"
 #include "Level/Awards.hpp"
 #include "Level/Campaign.hpp"
 #include "Level/Dialog.hpp"
 #include "Level/Hotspot.hpp"
+#include "Level/LevelSnapshot.hpp"
 #include "Menu/Menu.hpp"
 #include "Tutorial.hpp"
 #include "User/Settings.hpp"
+#include "Utils/BinaryReader.hpp"
 #include "Utils/Folders.hpp"
 #include "Utils/Input.hpp"
 
@@ -46,9 +49,13 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
 #include <cmath>
+#include <chrono>
 #include <ctime>
 #include <dirent.h>
 #include <limits>
+#include <future>
+#include <map>
+#include <memory>
 #include <set>
 
 using namespace std;
@@ -356,6 +363,48 @@ void Game::SetUpLighting()
     light.ambient[2] *= (skyboxlightb + average) / 2;
 }
 
+/* Textures swapped in by Setenvironment, indexed by environment */
+struct EnvironmentTextures
+{
+    const char* tree;
+    const char* bush;
+    const char* rock;
+    const char* box;
+    const char* terrain;
+    const char* terrain2;
+    const char* skybox;
+};
+
+static const EnvironmentTextures environmentTextures[] = {
+    { "Textures/SnowTree.png", "Textures/BushSnow.png", "Textures/BoulderSnow.jpg", "Textures/SnowBox.jpg",
+      "Textures/Snow.jpg", "Textures/Rock.jpg", "Textures/Skybox(snow)/" },
+    { "Textures/Tree.png", "Textures/Bush.png", "Textures/Boulder.jpg", "Textures/GrassBox.jpg",
+      "Textures/GrassDirt.jpg", "Textures/MossRock.jpg", "Textures/Skybox(grass)/" },
+    { "Textures/DesertTree.png", "Textures/BushDesert.png", "Textures/BoulderDesert.jpg", "Textures/DesertBox.jpg",
+      "Textures/Sand.jpg", "Textures/SandSlope.jpg", "Textures/Skybox(sand)/" },
+};
+
+static const char* skyboxFaces[6] = { "Front.jpg", "Left.jpg", "Back.jpg", "Right.jpg", "Up.jpg", "Down.jpg" };
+
+static bool validEnvironment(int which)
+{
+    return which >= 0 && which < (int)(sizeof(environmentTextures) / sizeof(environmentTextures[0]));
+}
+
+/* Start decoding the textures of an environment so Setenvironment only has to upload them */
+void PrefetchEnvironment(int which)
+{
+    if (!validEnvironment(which)) {
+        return;
+    }
+    const EnvironmentTextures& textures = environmentTextures[which];
+    TextureLoader::prefetch(std::vector<std::string>{ textures.tree, textures.bush }, false);
+    TextureLoader::prefetch(std::vector<std::string>{ textures.rock, textures.box, textures.terrain, textures.terrain2 }, true);
+    for (const char* face : skyboxFaces) {
+        TextureLoader::prefetch(std::string(textures.skybox) + face, true);
+    }
+}
+
 void Setenvironment(int which)
 {
     LOGFUNC;
@@ -378,38 +427,13 @@ void Setenvironment(int which)
             emit_stream_np(stream_wind);
         }
 
-        Object::treetextureptr.load("Textures/SnowTree.png", 0);
-        Object::bushtextureptr.load("Textures/BushSnow.png", 0);
-        Object::rocktextureptr.load("Textures/BoulderSnow.jpg", 1);
-        Object::boxtextureptr.load("Textures/SnowBox.jpg", 1);
-
         footstepsound = footstepsn1;
         footstepsound2 = footstepsn2;
         footstepsound3 = footstepst1;
         footstepsound4 = footstepst2;
-
-        terraintexture.load("Textures/Snow.jpg", 1);
-        terraintexture2.load("Textures/Rock.jpg", 1);
-
-        temptexdetail = texdetail;
-        if (texdetail > 1) {
-            texdetail = 4;
-        }
-        skybox->load("Textures/Skybox(snow)/Front.jpg",
-                     "Textures/Skybox(snow)/Left.jpg",
-                     "Textures/Skybox(snow)/Back.jpg",
-                     "Textures/Skybox(snow)/Right.jpg",
-                     "Textures/Skybox(snow)/Up.jpg",
-                     "Textures/Skybox(snow)/Down.jpg");
-
-        texdetail = temptexdetail;
     } else if (environment == desertenvironment) {
         windvector = 0;
         windvector.z = 2;
-        Object::treetextureptr.load("Textures/DesertTree.png", 0);
-        Object::bushtextureptr.load("Textures/BushDesert.png", 0);
-        Object::rocktextureptr.load("Textures/BoulderDesert.jpg", 1);
-        Object::boxtextureptr.load("Textures/DesertBox.jpg", 1);
 
         if (ambientsound) {
             emit_stream_np(stream_desertambient);
@@ -419,29 +443,9 @@ void Setenvironment(int which)
         footstepsound2 = footstepsn2;
         footstepsound3 = footstepsn1;
         footstepsound4 = footstepsn2;
-
-        terraintexture.load("Textures/Sand.jpg", 1);
-        terraintexture2.load("Textures/SandSlope.jpg", 1);
-
-        temptexdetail = texdetail;
-        if (texdetail > 1) {
-            texdetail = 4;
-        }
-        skybox->load("Textures/Skybox(sand)/Front.jpg",
-                     "Textures/Skybox(sand)/Left.jpg",
-                     "Textures/Skybox(sand)/Back.jpg",
-                     "Textures/Skybox(sand)/Right.jpg",
-                     "Textures/Skybox(sand)/Up.jpg",
-                     "Textures/Skybox(sand)/Down.jpg");
-
-        texdetail = temptexdetail;
     } else if (environment == grassyenvironment) {
         windvector = 0;
         windvector.z = 2;
-        Object::treetextureptr.load("Textures/Tree.png", 0);
-        Object::bushtextureptr.load("Textures/Bush.png", 0);
-        Object::rocktextureptr.load("Textures/Boulder.jpg", 1);
-        Object::boxtextureptr.load("Textures/GrassBox.jpg", 1);
 
         if (ambientsound) {
             emit_stream_np(stream_wind, 100.);
@@ -451,20 +455,31 @@ void Setenvironment(int which)
         footstepsound2 = footstepgr2;
         footstepsound3 = footstepst1;
         footstepsound4 = footstepst2;
+    }
+
+    // Decoded on the texture workers, uploaded by LoadLevel or over the next frames
+    if (validEnvironment(environment)) {
+        const EnvironmentTextures& textures = environmentTextures[environment];
+        const std::string skyboxPath = textures.skybox;
+
+        Object::treetextureptr.loadAsync(textures.tree, 0);
+        Object::bushtextureptr.loadAsync(textures.bush, 0);
+        Object::rocktextureptr.loadAsync(textures.rock, 1);
+        Object::boxtextureptr.loadAsync(textures.box, 1);
 
-        terraintexture.load("Textures/GrassDirt.jpg", 1);
-        terraintexture2.load("Textures/MossRock.jpg", 1);
+        terraintexture.loadAsync(textures.terrain, 1);
+        terraintexture2.loadAsync(textures.terrain2, 1);
 
         temptexdetail = texdetail;
         if (texdetail > 1) {
             texdetail = 4;
         }
-        skybox->load("Textures/Skybox(grass)/Front.jpg",
-                     "Textures/Skybox(grass)/Left.jpg",
-                     "Textures/Skybox(grass)/Back.jpg",
-                     "Textures/Skybox(grass)/Right.jpg",
-                     "Textures/Skybox(grass)/Up.jpg",
-                     "Textures/Skybox(grass)/Down.jpg");
+        skybox->load(skyboxPath + skyboxFaces[0],
+                     skyboxPath + skyboxFaces[1],
+                     skyboxPath + skyboxFaces[2],
+                     skyboxPath + skyboxFaces[3],
+                     skyboxPath + skyboxFaces[4],
+                     skyboxPath + skyboxFaces[5]);
 
         texdetail = temptexdetail;
     }
@@ -475,6 +490,240 @@ void Setenvironment(int which)
     texdetail = temptexdetail;
 }
 
+/* Map read ahead by PrefetchLevel on the texture workers, handed over to LoadLevel
+ * unless the file changed since */
+struct StagedLevel
+{
+    uint64_t size;
+    int64_t mtime;
+    BinaryReader reader;
+    /* What the level needs decoded, filled in by the worker */
+    int environment;
+    std::set<std::string> skins;
+    std::set<std::string> clothes;
+    /* Whether the map could be read, ready once the worker is done with it */
+    std::future<bool> parsed;
+    /* The textures went to the workers, parsed was read then */
+    bool queued;
+};
+
+static std::map<std::string, std::shared_ptr<StagedLevel>> stagedLevels;
+// Campaign level whose next levels were prefetched, -1 once LoadLevel dropped them
+static int prefetchedCampaignLevel = -1;
+// Map of that level, loading it again keeps what was prefetched
+static std::string prefetchedFrom;
+
+static bool takeStagedLevel(const std::string& path, BinaryReader& reader)
+{
+    auto found = stagedLevels.find(path);
+    if (found == stagedLevels.end()) {
+        return false;
+    }
+    std::shared_ptr<StagedLevel> staged = found->second;
+    stagedLevels.erase(found);
+
+    // Still being read, waiting beats reading it a second time
+    if (!staged->queued && !staged->parsed.get()) {
+        return false;
+    }
+
+    uint64_t size;
+    int64_t mtime;
+    if (!Folders::getResourceStamp(path, &size, &mtime) || size != staged->size || mtime != staged->mtime) {
+        return false;
+    }
+    staged->reader.rewind();
+    reader.swap(staged->reader);
+    return true;
+}
+
+/* Skin of a person as stored in a map, nullptr when the map is wrong about it */
+static const std::string* personSkin(int creature, int whichskin)
+{
+    if (creature < 0 || creature >= (int)PersonType::types.size()) {
+        return nullptr;
+    }
+    const std::vector<std::string>& skins = PersonType::types[creature].skins;
+    if (whichskin < 0 || whichskin >= (int)skins.size()) {
+        return nullptr;
+    }
+    return &skins[whichskin];
+}
+
+/* Clothes of a person, same layout for the player and the others */
+static void readClothes(BinaryReader& reader, int numclothes, std::set<std::string>& clothes)
+{
+    for (int k = 0; k < numclothes && !reader.isTruncated(); k++) {
+        int templength = reader.read<int32_be>();
+        if (templength < 0 || templength > 255) {
+            reader.skip(reader.getSize());
+            return;
+        }
+        std::vector<unsigned char> name = reader.read_array<uint8_be>(templength);
+        clothes.insert(std::string(name.begin(), name.end()));
+        reader.skip(3 * sizeof(float));
+    }
+}
+
+/* Worker side of PrefetchLevel, only reads the map and the person types */
+static bool parseStagedLevel(const std::string& level_path, StagedLevel& staged)
+{
+    if (!Folders::getResourceStamp(level_path, &staged.size, &staged.mtime) || !Folders::openReader(level_path, staged.reader)) {
+        return false;
+    }
+    BinaryReader& reader = staged.reader;
+
+    int mapvers, numweapons, numclothes;
+    int whichskin = 0, creature = rabbittype;
+    std::set<std::string>& skins = staged.skins;
+    std::set<std::string>& clothes = staged.clothes;
+
+    mapvers = reader.read<int32_be>();
+    if (mapvers >= 15) {
+        reader.skip(sizeof(int));
+    }
+    if (mapvers >= 5) {
+        reader.skip(sizeof(int));
+    }
+    if (mapvers >= 6) {
+        reader.skip(sizeof(int));
+    }
+    if (mapvers >= 4) {
+        reader.skip(2 * sizeof(float));
+    }
+    if (mapvers >= 2) {
+        reader.skip(1 + 3 * sizeof(float));
+    }
+    if (mapvers >= 10) {
+        reader.skip(3 * sizeof(float));
+    }
+    reader.skip(5 * sizeof(float));
+    numweapons = reader.read<int32_be>();
+    if (numweapons > 0 && numweapons < 5) {
+        reader.skip(numweapons * sizeof(int));
+    }
+    reader.skip(11 * sizeof(float));
+    numclothes = reader.read<int32_be>();
+    if (mapvers >= 9) {
+        whichskin = reader.read<int32_be>();
+        creature = reader.read<int32_be>();
+    }
+    if (personSkin(creature, whichskin)) {
+        skins.insert(*personSkin(creature, whichskin));
+    }
+    if (mapvers >= 8) {
+        int numdialogues = reader.read<int32_be>();
+        for (int k = 0; k < numdialogues && !reader.isTruncated(); k++) {
+            Dialog dialog(reader);
+        }
+    }
+    readClothes(reader, numclothes, clothes);
+    staged.environment = reader.read<int32_be>();
+    if (reader.isTruncated()) {
+        return false;
+    }
+
+    Object::LoadObjectsFromFile(reader, true);
+    if (mapvers >= 7) {
+        int numhotspots = reader.read<int32_be>();
+        for (int i = 0; i < numhotspots && !reader.isTruncated(); i++) {
+            reader.skip(5 * sizeof(float));
+            int templength = reader.read<int32_be>();
+            reader.skip(std::max(templength, 0));
+        }
+    }
+
+    // Same fields as the Person constructor, stopping where it would throw
+    int numplayers = reader.read<int32_be>();
+    for (int i = 1; i < numplayers && !reader.isTruncated(); i++) {
+        whichskin = reader.read<int32_be>();
+        creature = reader.read<int32_be>();
+        reader.skip(3 * sizeof(float));
+        int num_weapons = reader.read<int32_be>();
+        if (mapvers >= 5) {
+            reader.skip(sizeof(int));
+        }
+        if (mapvers >= 3) {
+            reader.skip(sizeof(float));
+        }
+        if (mapvers >= 11) {
+            reader.skip(1);
+        }
+        if (mapvers >= 12) {
+            reader.skip(sizeof(float));
+        }
+        if (num_weapons < 0 || num_weapons > 5) {
+            break;
+        }
+        if (personSkin(creature, whichskin)) {
+            skins.insert(*personSkin(creature, whichskin));
+        }
+        if (num_weapons > 0 && num_weapons < 5) {
+            reader.skip(num_weapons * sizeof(int));
+        }
+        int numwaypoints = reader.read<int32_be>();
+        reader.skip(std::max(numwaypoints, 0) * (mapvers >= 5 ? 4 : 3) * sizeof(int));
+        reader.skip(sizeof(int) + 11 * sizeof(float));
+        if (mapvers >= 4) {
+            reader.skip(4 * sizeof(float));
+        }
+        readClothes(reader, reader.read<int32_be>(), clothes);
+    }
+
+    return true;
+}
+
+/* Start decoding the textures of levels the workers finished reading */
+static void queueStagedTextures()
+{
+    for (auto it = stagedLevels.begin(); it != stagedLevels.end();) {
+        StagedLevel& staged = *it->second;
+        if (staged.queued || staged.parsed.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        if (!staged.parsed.get()) {
+            it = stagedLevels.erase(it);
+            continue;
+        }
+        staged.queued = true;
+
+        // LoadLevel keeps the current textures when the environment doesn't change
+        if (staged.environment != oldenvironment) {
+            PrefetchEnvironment(staged.environment);
+        }
+        // Persons draw blood into their own RGB copy of the skin and blend clothes over it
+        for (const std::string& skin : staged.skins) {
+            TextureLoader::prefetchShared(skin, true);
+        }
+        for (const std::string& item : staged.clothes) {
+            TextureLoader::prefetchShared(item, false);
+        }
+        ++it;
+    }
+}
+
+/* Read a level ahead on the texture workers. Once they are done its environment
+ * textures, person skins and clothes get decoded as well, so LoadLevel takes the map
+ * from memory and only has to copy and upload images that are already decoded. */
+bool Game::PrefetchLevel(const std::string& name)
+{
+    const std::string level_path = Folders::getResourcePath("Maps/" + name);
+    if (stagedLevels.find(level_path) != stagedLevels.end()) {
+        return true;
+    }
+
+    std::shared_ptr<StagedLevel> staged(new StagedLevel());
+    staged->queued = false;
+    std::shared_ptr<std::promise<bool>> parsed(new std::promise<bool>());
+    staged->parsed = parsed->get_future();
+    TextureLoader::runTask([level_path, staged, parsed] {
+        parsed->set_value(parseStagedLevel(level_path, *staged));
+    });
+    stagedLevels[level_path] = staged;
+    return true;
+}
+
 bool Game::LoadLevel(int which)
 {
     stealthloading = 0;
@@ -502,9 +751,7 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
         return false;
     }
 
-    int indemo; // FIXME this should be removed
     int templength;
-    float lamefloat;
 
     LOGFUNC;
 
@@ -535,10 +782,17 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
     pause_sound(whooshsound);
     pause_sound(stream_firesound);
 
+    // Restarting the level that was loaded last restores most of it from memory
+    LevelSnapshot* snapshot = stealthloading ? nullptr : LevelSnapshot::find(level_path, tutorial);
+
     int mapvers;
-    FILE* tfile;
-    errno = 0;
-    tfile = Folders::openMandatoryFile(level_path, "rb");
+    BinaryReader reader;
+    if (snapshot) {
+        snapshot->map.rewind();
+        reader.swap(snapshot->map);
+    } else if (!takeStagedLevel(level_path, reader)) {
+        Folders::openMandatoryReader(level_path, reader);
+    }
 
     pause_sound(stream_firesound);
     scoreadded = 0;
@@ -619,33 +873,36 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
     Person::clearVictims();
     Person::players.resize(1);
 
-    funpackf(tfile, "Bi", &mapvers);
+    mapvers = reader.read<int32_be>();
     if (mapvers < 12) {
         cerr << name << " has obsolete map version " << mapvers << endl;
     }
     if (mapvers >= 15) {
-        funpackf(tfile, "Bi", &indemo);
-    } else {
-        indemo = 0;
+        // Demo flag, unused
+        reader.skip(sizeof(int));
     }
     if (mapvers >= 5) {
-        funpackf(tfile, "Bi", &maptype);
+        maptype = reader.read<int32_be>();
     } else {
         maptype = mapkilleveryone;
     }
     if (mapvers >= 6) {
-        funpackf(tfile, "Bi", &hostile);
+        hostile = reader.read<int32_be>();
     } else {
         hostile = 1;
     }
     if (mapvers >= 4) {
-        funpackf(tfile, "Bf Bf", &viewdistance, &fadestart);
+        viewdistance = reader.read<float_be>();
+        fadestart = reader.read<float_be>();
     } else {
         viewdistance = 100;
         fadestart = .6;
     }
     if (mapvers >= 2) {
-        funpackf(tfile, "Bb Bf Bf Bf", &skyboxtexture, &skyboxr, &skyboxg, &skyboxb);
+        skyboxtexture = reader.read<uint8_be>();
+        skyboxr = reader.read<float_be>();
+        skyboxg = reader.read<float_be>();
+        skyboxb = reader.read<float_be>();
     } else {
         skyboxtexture = 1;
         skyboxr = 1;
@@ -653,7 +910,9 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
         skyboxb = 1;
     }
     if (mapvers >= 10) {
-        funpackf(tfile, "Bf Bf Bf", &skyboxlightr, &skyboxlightg, &skyboxlightb);
+        skyboxlightr = reader.read<float_be>();
+        skyboxlightg = reader.read<float_be>();
+        skyboxlightb = reader.read<float_be>();
     } else {
         skyboxlightr = skyboxr;
         skyboxlightg = skyboxg;
@@ -661,30 +920,41 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
     }
     /* TODO - This should be done in an other way so that we can rebuild main player as well (so coords would need to be copied from old ones after rebuilding) */
     if (stealthloading) {
-        funpackf(tfile, "Bf Bf Bf Bf Bf Bi", &lamefloat, &lamefloat, &lamefloat, &lamefloat, &lamefloat, &Person::players[0]->num_weapons);
+        reader.skip(5 * sizeof(float));
+        Person::players[0]->num_weapons = reader.read<int32_be>();
     } else {
-        funpackf(tfile, "Bf Bf Bf Bf Bf Bi", &Person::players[0]->coords.x, &Person::players[0]->coords.y, &Person::players[0]->coords.z, &Person::players[0]->yaw, &Person::players[0]->targetyaw, &Person::players[0]->num_weapons);
+        reader.read_array<float_be>(&Person::players[0]->coords.x, 3);
+        Person::players[0]->yaw = reader.read<float_be>();
+        Person::players[0]->targetyaw = reader.read<float_be>();
+        Person::players[0]->num_weapons = reader.read<int32_be>();
     }
     if (Person::players[0]->num_weapons > 0 && Person::players[0]->num_weapons < 5) {
         for (int j = 0; j < Person::players[0]->num_weapons; j++) {
             Person::players[0]->weaponids[j] = weapons.size();
-            int type;
-            funpackf(tfile, "Bi", &type);
+            int type = reader.read<int32_be>();
             weapons.push_back(Weapon(type, 0));
         }
     }
 
     Game::LoadingScreen();
 
-    funpackf(tfile, "Bf Bf Bf", &Person::players[0]->armorhead, &Person::players[0]->armorhigh, &Person::players[0]->armorlow);
-    funpackf(tfile, "Bf Bf Bf", &Person::players[0]->protectionhead, &Person::players[0]->protectionhigh, &Person::players[0]->protectionlow);
-    funpackf(tfile, "Bf Bf Bf", &Person::players[0]->metalhead, &Person::players[0]->metalhigh, &Person::players[0]->metallow);
-    funpackf(tfile, "Bf Bf", &Person::players[0]->power, &Person::players[0]->speedmult);
+    Person::players[0]->armorhead = reader.read<float_be>();
+    Person::players[0]->armorhigh = reader.read<float_be>();
+    Person::players[0]->armorlow = reader.read<float_be>();
+    Person::players[0]->protectionhead = reader.read<float_be>();
+    Person::players[0]->protectionhigh = reader.read<float_be>();
+    Person::players[0]->protectionlow = reader.read<float_be>();
+    Person::players[0]->metalhead = reader.read<float_be>();
+    Person::players[0]->metalhigh = reader.read<float_be>();
+    Person::players[0]->metallow = reader.read<float_be>();
+    Person::players[0]->power = reader.read<float_be>();
+    Person::players[0]->speedmult = reader.read<float_be>();
 
-    funpackf(tfile, "Bi", &Person::players[0]->numclothes);
+    Person::players[0]->numclothes = reader.read<int32_be>();
 
     if (mapvers >= 9) {
-        funpackf(tfile, "Bi Bi", &Person::players[0]->whichskin, &Person::players[0]->creature);
+        Person::players[0]->whichskin = reader.read<int32_be>();
+        Person::players[0]->creature = reader.read<int32_be>();
     } else {
         Person::players[0]->whichskin = 0;
         Person::players[0]->creature = rabbittype;
@@ -696,47 +966,49 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
 
     //dialogues
     if (mapvers >= 8) {
-        Dialog::loadDialogs(tfile);
+        Dialog::loadDialogs(reader);
     }
 
     for (int k = 0; k < Person::players[0]->numclothes; k++) {
-        funpackf(tfile, "Bi", &templength);
-        for (int l = 0; l < templength; l++) {
-            funpackf(tfile, "Bb", &Person::players[0]->clothes[k][l]);
+        templength = reader.read<int32_be>();
+        if (templength > 0) {
+            reader.read_array<uint8_be>((unsigned char*)Person::players[0]->clothes[k], templength);
         }
         Person::players[0]->clothes[k][templength] = '\0';
-        funpackf(tfile, "Bf Bf Bf", &Person::players[0]->clothestintr[k], &Person::players[0]->clothestintg[k], &Person::players[0]->clothestintb[k]);
+        Person::players[0]->clothestintr[k] = reader.read<float_be>();
+        Person::players[0]->clothestintg[k] = reader.read<float_be>();
+        Person::players[0]->clothestintb[k] = reader.read<float_be>();
     }
 
-    funpackf(tfile, "Bi", &environment);
+    environment = reader.read<int32_be>();
 
     if (environment != oldenvironment) {
         Setenvironment(environment);
     }
     oldenvironment = environment;
 
-    Object::LoadObjectsFromFile(tfile, stealthloading);
+    Object::LoadObjectsFromFile(reader, stealthloading || snapshot);
+    if (snapshot) {
+        snapshot->restoreObjects();
+    }
 
     if (mapvers >= 7) {
         int numhotspots;
-        funpackf(tfile, "Bi", &numhotspots);
+        numhotspots = reader.read<int32_be>();
         if (numhotspots < 0) {
             cerr << "Map " << name << " have an invalid number of hotspots" << endl;
             numhotspots = 0;
         }
         Hotspot::hotspots.resize(numhotspots);
         for (unsigned i = 0; i < Hotspot::hotspots.size(); i++) {
-            funpackf(tfile, "Bi Bf Bf Bf Bf", &Hotspot::hotspots[i].type, &Hotspot::hotspots[i].size, &Hotspot::hotspots[i].position.x, &Hotspot::hotspots[i].position.y, &Hotspot::hotspots[i].position.z);
-            funpackf(tfile, "Bi", &templength);
-            if (templength) {
-                for (int l = 0; l < templength; l++) {
-                    funpackf(tfile, "Bb", &Hotspot::hotspots[i].text[l]);
-                }
+            Hotspot::hotspots[i].type = reader.read<int32_be>();
+            Hotspot::hotspots[i].size = reader.read<float_be>();
+            reader.read_array<float_be>(&Hotspot::hotspots[i].position.x, 3);
+            templength = reader.read<int32_be>();
+            if (templength > 0) {
+                reader.read_array<uint8_be>((unsigned char*)Hotspot::hotspots[i].text, templength);
             }
             Hotspot::hotspots[i].text[templength] = '\0';
-            if (Hotspot::hotspots[i].type == -111) {
-                indemo = 1;
-            }
         }
     } else {
         Hotspot::hotspots.clear();
@@ -752,14 +1024,14 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
     Game::LoadingScreen();
 
     int numplayers;
-    funpackf(tfile, "Bi", &numplayers);
+    numplayers = reader.read<int32_be>();
     if (numplayers > maxplayers) {
         cout << "Warning: this level contains more players than allowed" << endl;
     }
     unsigned j = 1;
     for (int i = 1; i < numplayers; i++) {
         try {
-            Person::players.push_back(shared_ptr<Person>(new Person(tfile, mapvers, j)));
+            Person::players.push_back(shared_ptr<Person>(new Person(reader, mapvers, j)));
             j++;
         } catch (InvalidPersonException e) {
             cerr << "Invalid Person found in " << name << endl;
@@ -767,31 +1039,39 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
     }
     Game::LoadingScreen();
 
-    funpackf(tfile, "Bi", &numpathpoints);
+    numpathpoints = reader.read<int32_be>();
     if (numpathpoints > 30 || numpathpoints < 0) {
         numpathpoints = 0;
     }
     for (int j = 0; j < numpathpoints; j++) {
-        funpackf(tfile, "Bf Bf Bf Bi", &pathpoint[j].x, &pathpoint[j].y, &pathpoint[j].z, &numpathpointconnect[j]);
-        for (int k = 0; k < numpathpointconnect[j]; k++) {
-            funpackf(tfile, "Bi", &pathpointconnect[j][k]);
+        reader.read_array<float_be>(&pathpoint[j].x, 3);
+        numpathpointconnect[j] = reader.read<int32_be>();
+        if (numpathpointconnect[j] > 0) {
+            reader.read_array<int32_be>(pathpointconnect[j], numpathpointconnect[j]);
         }
     }
     Game::LoadingScreen();
 
-    funpackf(tfile, "Bf Bf Bf Bf", &mapcenter.x, &mapcenter.y, &mapcenter.z, &mapradius);
+    reader.read_array<float_be>(&mapcenter.x, 3);
+    mapradius = reader.read<float_be>();
 
     SetUpLighting();
 
     if (!stealthloading) {
         Object::AddObjectsToTerrain();
-        terrain.DoShadows();
-        Game::LoadingScreen();
-        Object::DoShadows();
+        if (snapshot) {
+            snapshot->restoreTerrain();
+        } else {
+            terrain.DoShadows();
+            Game::LoadingScreen();
+            Object::DoShadows();
+        }
         Game::LoadingScreen();
     }
 
-    fclose(tfile);
+
+    // Every person gets its own copy to record poses into
+    const Animation tempanimBase("Tempanim", lowheight, neutral);
 
     for (unsigned i = 0; i < Person::players.size(); i++) {
         Game::LoadingScreen();
@@ -806,9 +1086,14 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
         }
         Person::players[i]->skeleton.free = 0;
 
-        Person::players[i]->skeletonLoad();
+        const bool restoreSkin = snapshot && snapshot->hasSkin(i, *Person::players[i]);
+        Person::players[i]->skeletonLoad(false, !restoreSkin);
 
-        Person::players[i]->addClothes();
+        if (restoreSkin) {
+            snapshot->restoreSkin(i, *Person::players[i]);
+        } else {
+            Person::players[i]->addClothes();
+        }
 
         if (i == 0) {
             Person::players[i]->animCurrent = bounceidleanim;
@@ -848,7 +1133,7 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
 
         Game::LoadingScreen();
 
-        Person::players[i]->tempanimation = Animation("Tempanim", lowheight, neutral);
+        Person::players[i]->tempanimation = tempanimBase;
 
         if (i == 0) {
             Person::players[i]->headmorphness = 0;
@@ -924,6 +1209,22 @@ bool Game::LoadLevel(const std::string& name, bool tutorial)
     oldmusicvolume[2] = 0;
     oldmusicvolume[3] = 0;
 
+    // Environment textures queued by Setenvironment must be there for the first frame
+    TextureLoader::finishPending();
+    // Restarting a campaign level still leads to the same next levels
+    if (level_path != prefetchedFrom) {
+        TextureLoader::clear();
+        stagedLevels.clear();
+        prefetchedCampaignLevel = -1;
+        prefetchedFrom.clear();
+    }
+
+    if (snapshot) {
+        snapshot->map.swap(reader);
+    } else if (!stealthloading) {
+        LevelSnapshot::capture(level_path, tutorial, reader);
+    }
+
     leveltime = 0;
     wonleveltime = 0;
     visibleloading = false;
@@ -1204,9 +1505,7 @@ void Game::ProcessDevInput()
                     Person::players[closest]->whichskin = 0;
                 }
 
-                Person::players[closest]->skeleton.drawmodel.textureptr.load(
-                    PersonType::types[Person::players[closest]->creature].skins[Person::players[closest]->whichskin], 1,
-                    &Person::players[closest]->skeleton.skinText[0], &Person::players[closest]->skeleton.skinsize);
+                Person::players[closest]->loadSkin(PersonType::types[Person::players[closest]->creature].skins[Person::players[closest]->whichskin]);
             }
 
             Person::players[closest]->addClothes();
@@ -1469,7 +1768,8 @@ void Game::ProcessDevInput()
 
             Person::players.back()->setProportions(1, 1, 1, 1);
 
-            Person::players.back()->tempanimation = Animation("Tempanim", lowheight, neutral);
+            const Animation tempanimBase("Tempanim", lowheight, neutral);
+            Person::players.back()->tempanimation = tempanimBase;
 
             Person::players.back()->damagetolerance = 200;
 
@@ -4492,6 +4792,8 @@ void Game::TickOnceAfter()
     static float unseendelay;
     static float cameraspeed;
 
+    queueStagedTextures();
+
     if (!mainmenu) {
         static int oldmusictype = musictype;
 
@@ -4739,6 +5041,17 @@ void Game::TickOnceAfter()
                     changedelay -= multiplier / 7; // Gradually decrease the delay, unless it's set to a special value (-999)
                 }
 
+                // Read the levels that can come next while this one is played, so moving on doesn't wait on the disk
+                if (campaign && !loading && prefetchedCampaignLevel != actuallevel && actuallevel >= 0 && actuallevel < (int)campaignlevels.size()) {
+                    prefetchedCampaignLevel = actuallevel;
+                    prefetchedFrom = Folders::getResourcePath("Maps/" + campaignlevels[actuallevel].mapname);
+                    for (int next : campaignlevels[actuallevel].nextlevel) {
+                        if (next >= 0 && next < (int)campaignlevels.size()) {
+                            PrefetchLevel(campaignlevels[next].mapname);
+                        }
+                    }
+                }
+
                 // If the player is dead, prepare to restart the current level
                 if (Person::players[0]->dead) {
                     targetlevel = whichlevel; // Restart the same level
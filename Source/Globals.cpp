@@ -34,6 +34,7 @@ bool floatjump = false;
 bool cellophane = false;
 bool autoslomo = false;
 bool decalstoggle = false;
+bool gpuskinning = false;
 bool invertmouse = false;
 bool texttoggle = false;
 float blurness = 0;
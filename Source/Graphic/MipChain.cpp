@@ -0,0 +1,323 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Graphic/MipChain.hpp"
+
+#include "Utils/Folders.hpp"
+#include "Utils/ImageIO.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+struct MipCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    int32_t channels;
+    int32_t width;
+    int32_t height;
+    int32_t levelCount;
+};
+
+static const char mipCacheMagic[4] = { 'L', 'G', 'M', 'P' };
+static const uint32_t mipCacheVersion = 1;
+static const int maxMipSize = 16384;
+
+static int fullLevelCount(int width, int height)
+{
+    int count = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        count++;
+    }
+    return count;
+}
+
+MipChain::MipChain()
+    : channels(0)
+    , ownsBase(false)
+{
+}
+
+void MipChain::clear()
+{
+    levels.clear();
+    storage.clear();
+    channels = 0;
+    ownsBase = false;
+}
+
+void MipChain::layout(int width, int height, int levelCount)
+{
+    GLubyte* base = levels.empty() ? nullptr : levels[0].pixels;
+
+    levels.resize(levelCount);
+    size_t total = 0;
+    for (int i = 0; i < levelCount; i++) {
+        levels[i].width = width;
+        levels[i].height = height;
+        if (i > 0 || ownsBase) {
+            total += size_t(width) * height * channels;
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    // An owned level 0 sits first in storage so resizing keeps its pixels
+    storage.resize(total);
+    GLubyte* cursor = storage.data();
+    for (int i = 0; i < levelCount; i++) {
+        if (i == 0 && !ownsBase) {
+            levels[i].pixels = base;
+            continue;
+        }
+        levels[i].pixels = cursor;
+        cursor += size_t(levels[i].width) * levels[i].height * channels;
+    }
+}
+
+void MipChain::assign(const GLubyte* pixels, int width, int height, int _channels)
+{
+    clear();
+    channels = _channels;
+    ownsBase = true;
+    layout(width, height, 1);
+    memcpy(levels[0].pixels, pixels, storage.size());
+}
+
+void MipChain::attach(GLubyte* pixels, int width, int height, int _channels)
+{
+    clear();
+    channels = _channels;
+    levels.push_back(Level{ width, height, pixels });
+}
+
+void MipChain::generate()
+{
+    if (levels.empty()) {
+        return;
+    }
+    layout(levels[0].width, levels[0].height, fullLevelCount(levels[0].width, levels[0].height));
+    for (unsigned i = 1; i < levels.size(); i++) {
+        downsample(i, 0, 0, levels[i].width, levels[i].height);
+    }
+}
+
+void MipChain::rebuild(int x, int y, int width, int height)
+{
+    if (levels.empty()) {
+        return;
+    }
+    int x0 = std::max(x, 0);
+    int y0 = std::max(y, 0);
+    int x1 = std::min(x + width, levels[0].width);
+    int y1 = std::min(y + height, levels[0].height);
+
+    // Each texel averages a 2x2 block of the level above, so the rectangle halves, rounded outwards
+    for (unsigned i = 1; i < levels.size(); i++) {
+        x0 = x0 / 2;
+        y0 = y0 / 2;
+        x1 = std::min((x1 + 1) / 2, levels[i].width);
+        y1 = std::min((y1 + 1) / 2, levels[i].height);
+        if (x0 >= x1 || y0 >= y1) {
+            return;
+        }
+        downsample(i, x0, y0, x1, y1);
+    }
+}
+
+/* Box filter the [x0, x1) x [y0, y1) texels of a level from the level above it.
+ * Odd sizes clamp the last row and column instead of reading past them. */
+void MipChain::downsample(int level, int x0, int y0, int x1, int y1)
+{
+    const Level& src = levels[level - 1];
+    const Level& dst = levels[level];
+    const size_t srcPitch = size_t(src.width) * channels;
+
+    for (int y = y0; y < y1; y++) {
+        const GLubyte* row0 = src.pixels + std::min(2 * y, src.height - 1) * srcPitch;
+        const GLubyte* row1 = src.pixels + std::min(2 * y + 1, src.height - 1) * srcPitch;
+        GLubyte* out = dst.pixels + (size_t(y) * dst.width + x0) * channels;
+        int x = x0;
+
+#ifdef __SSE2__
+        // Two RGBA texels per step: sum 4x2 source texels as 16 bits, then pairs of columns
+        if (channels == 4) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i rounding = _mm_set1_epi16(2);
+            for (; x + 1 < x1 && 2 * x + 3 < src.width; x += 2) {
+                __m128i top = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+                __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+                right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+                __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(left, right), rounding);
+                _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(_mm_srli_epi16(sum, 2), zero));
+                out += 8;
+            }
+        }
+#endif
+
+        for (; x < x1; x++) {
+            const size_t left = size_t(std::min(2 * x, src.width - 1)) * channels;
+            const size_t right = size_t(std::min(2 * x + 1, src.width - 1)) * channels;
+            for (int c = 0; c < channels; c++) {
+                *out++ = (row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c] + 2) >> 2;
+            }
+        }
+    }
+}
+
+void MipChain::upload() const
+{
+    if (levels.empty()) {
+        return;
+    }
+    const GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+    for (unsigned i = 0; i < levels.size(); i++) {
+        glTexImage2D(GL_TEXTURE_2D, i, format, levels[i].width, levels[i].height, 0, format, GL_UNSIGNED_BYTE, levels[i].pixels);
+    }
+}
+
+void MipChain::upload(int x, int y, int level) const
+{
+    const GLenum format = (channels == 4) ? GL_RGBA : GL_RGB;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned i = 0; i < levels.size(); i++) {
+        glTexSubImage2D(GL_TEXTURE_2D, level + i, x >> i, y >> i, levels[i].width, levels[i].height, format, GL_UNSIGNED_BYTE, levels[i].pixels);
+    }
+}
+
+size_t MipChain::getTotalBytes() const
+{
+    size_t total = 0;
+    for (const Level& level : levels) {
+        total += size_t(level.width) * level.height * channels;
+    }
+    return total;
+}
+
+bool MipChain::loadImage(const std::string& path, bool mipmaps, MipChain& chain)
+{
+    uint64_t key = 0;
+    const bool cacheable = mipmaps && Folders::getResourceHash(path, &key);
+    if (cacheable && chain.loadCache(cachePath(key), key)) {
+        return true;
+    }
+
+    ImageRec image;
+    if (!decode_image(path.c_str(), image)) {
+        return false;
+    }
+    if (image.bpp != 24 && image.bpp != 32) {
+        fprintf(stderr, "Unsupported texture format: %u bits per pixel\n", image.bpp);
+        return false;
+    }
+    chain.assign(image.data, image.sizeX, image.sizeY, image.bpp / 8);
+    if (mipmaps) {
+        chain.generate();
+    }
+    if (cacheable) {
+        chain.saveCache(cachePath(key), key);
+    }
+    return true;
+}
+
+std::string MipChain::cachePath(uint64_t key)
+{
+    std::string cacheDir = Folders::getUserDataPath() + "/Cache";
+    Folders::makeDirectory(cacheDir);
+    cacheDir += "/Mips";
+    Folders::makeDirectory(cacheDir);
+
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.mip", (unsigned long long)key);
+    return cacheDir + name;
+}
+
+bool MipChain::loadCache(const std::string& path, uint64_t key)
+{
+    FILE* tfile = fopen(path.c_str(), "rb");
+    if (tfile == NULL) {
+        return false;
+    }
+
+    MipCacheHeader header;
+    bool valid = fread(&header, sizeof(header), 1, tfile) == 1 &&
+                 memcmp(header.magic, mipCacheMagic, 4) == 0 && header.version == mipCacheVersion && header.key == key &&
+                 (header.channels == 3 || header.channels == 4) &&
+                 header.width > 0 && header.width <= maxMipSize && header.height > 0 && header.height <= maxMipSize &&
+                 header.levelCount == fullLevelCount(header.width, header.height);
+    if (valid) {
+        clear();
+        channels = header.channels;
+        ownsBase = true;
+        layout(header.width, header.height, header.levelCount);
+        valid = fread(storage.data(), 1, storage.size(), tfile) == storage.size() && fgetc(tfile) == EOF;
+    }
+    fclose(tfile);
+
+    if (!valid) {
+        clear();
+    }
+    return valid;
+}
+
+void MipChain::saveCache(const std::string& path, uint64_t key) const
+{
+    if (!ownsBase || levels.empty()) {
+        return;
+    }
+
+    MipCacheHeader header;
+    memcpy(header.magic, mipCacheMagic, 4);
+    header.version = mipCacheVersion;
+    header.key = key;
+    header.channels = channels;
+    header.width = levels[0].width;
+    header.height = levels[0].height;
+    header.levelCount = levels.size();
+
+    // Several workers may bake the same image, each writes its own temporary file
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%p.tmp", (const void*)this);
+    std::string tempPath = path + suffix;
+    FILE* tfile = fopen(tempPath.c_str(), "wb");
+    if (tfile == NULL) {
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, tfile) == 1 &&
+                   fwrite(storage.data(), 1, storage.size(), tfile) == storage.size();
+    written = (fclose(tfile) == 0) && written;
+    if (!written || rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+    }
+}
@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _MIP_CHAIN_HPP_
+#define _MIP_CHAIN_HPP_
+
+#include "Graphic/gamegl.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Mipmap levels of an 8 bits per channel RGB or RGBA image, built on the CPU.
+ *
+ * Levels are 2x2 box filtered down to 1x1 and uploaded all at once, so
+ * nothing relies on GL_GENERATE_MIPMAP. Level 0 either belongs to the chain
+ * or stays in a caller's buffer, in which case rebuild() only redoes the
+ * texels of the smaller levels that a modified rectangle covers.
+ */
+class MipChain
+{
+public:
+    MipChain();
+
+    /* Copy pixels as level 0, dropping any previous levels */
+    void assign(const GLubyte* pixels, int width, int height, int channels);
+    /* Use pixels as level 0 without copying them, they have to outlive the chain */
+    void attach(GLubyte* pixels, int width, int height, int channels);
+    void clear();
+
+    /* Build every level below level 0 */
+    void generate();
+    /* Update the smaller levels after level 0 changed inside the given rectangle */
+    void rebuild(int x, int y, int width, int height);
+
+    /* Upload all levels to the bound GL_TEXTURE_2D */
+    void upload() const;
+    /* Upload all levels into part of the bound GL_TEXTURE_2D, which already
+     * has bigger levels. Level 0 lands on the given texture level at (x, y),
+     * each next level on the next texture level at half the offset. */
+    void upload(int x, int y, int level) const;
+
+    int getLevelCount() const { return levels.size(); }
+    int getChannels() const { return channels; }
+    int getWidth(int level) const { return levels[level].width; }
+    int getHeight(int level) const { return levels[level].height; }
+    const GLubyte* getPixels(int level) const { return levels[level].pixels; }
+    size_t getTotalBytes() const;
+
+    /* Decode a resolved image with all its levels, from the mip cache when it has
+     * a chain for the same source bytes. Doesn't touch GL, safe on worker threads. */
+    static bool loadImage(const std::string& path, bool mipmaps, MipChain& chain);
+
+    /* Make sure MipChain never gets copied, levels point into its storage */
+    MipChain(MipChain const& other) = delete;
+    MipChain& operator=(MipChain const& other) = delete;
+
+private:
+    struct Level
+    {
+        int width;
+        int height;
+        GLubyte* pixels;
+    };
+
+    std::vector<Level> levels;
+    /* Levels owned by the chain, back to back */
+    std::vector<GLubyte> storage;
+    int channels;
+    bool ownsBase;
+
+    /* Size levelCount levels from a width x height level 0, keeping level 0's pixels */
+    void layout(int width, int height, int levelCount);
+    void downsample(int level, int x0, int y0, int x1, int y1);
+
+    bool loadCache(const std::string& cachePath, uint64_t key);
+    void saveCache(const std::string& cachePath, uint64_t key) const;
+
+    static std::string cachePath(uint64_t key);
+};
+
+#endif
@@ -20,9 +20,11 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Graphic/Models.hpp"
 
-#include "Game.hpp"
+#include "Utils/BinaryReader.hpp"
 #include "Utils/Folders.hpp"
 
+#include <climits>
+
 extern float multiplier;
 extern float viewdistance;
 extern XYZ viewer;
@@ -419,56 +421,42 @@ void Model::UpdateVertexArrayNoTexNoNorm()
     }
 }
 
-bool Model::loadnotex(const std::string& filename)
+/* Baked model cache (<model>.bake), written next to the .solid file on first load
+ *
+ * Host byte order (only used on little-endian hosts), in order:
+ *   BakedModelHeader
+ *   vertexNum * 3 floats    vertex positions
+ *   vertexNum * 3 floats    vertex normals
+ *   triangleNum * 3 shorts  triangle vertex indices
+ *   triangleNum * 9 floats  gx[3], gy[3], facenormal
+ *   triangleNum * 24 floats interleaved vArray
+ */
+struct BakedModelHeader
 {
-    FILE* tfile;
-    long i;
-    short triangleNum;
-
-    type = notextype;
-    color = 0;
-
-    tfile = Folders::openMandatoryFile(Folders::getResourcePath(filename), "rb");
-
-    // read model settings
-
-    fseek(tfile, 0, SEEK_SET);
-    funpackf(tfile, "Bs Bs", &vertexNum, &triangleNum);
-
-    // read the model data
-    deallocate();
-
-    possible.clear();
-
-    owner = (int*)malloc(sizeof(int) * vertexNum);
-    vertex = (XYZ*)malloc(sizeof(XYZ) * vertexNum);
-    Triangles.resize(triangleNum);
-    vArray = (GLfloat*)malloc(sizeof(GLfloat) * triangleNum * 24);
-
-    for (i = 0; i < vertexNum; i++) {
-        funpackf(tfile, "Bf Bf Bf", &vertex[i].x, &vertex[i].y, &vertex[i].z);
-    }
-
-    for (i = 0; i < triangleNum; i++) {
-        short vertex[6];
-        funpackf(tfile, "Bs Bs Bs Bs Bs Bs", &vertex[0], &vertex[1], &vertex[2], &vertex[3], &vertex[4], &vertex[5]);
-        Triangles[i].vertex[0] = vertex[0];
-        Triangles[i].vertex[1] = vertex[2];
-        Triangles[i].vertex[2] = vertex[4];
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gx[0], &Triangles[i].gx[1], &Triangles[i].gx[2]);
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gy[0], &Triangles[i].gy[1], &Triangles[i].gy[2]);
-    }
-
-    fclose(tfile);
-
-    UpdateVertexArray();
-
-    for (i = 0; i < vertexNum; i++) {
-        owner[i] = -1;
-    }
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    int32_t vertexNum;
+    int32_t triangleNum;
+    float boundingspherecenter[3];
+    float boundingsphereradius;
+};
+
+static const char bakedModelMagic[4] = { 'L', 'G', 'M', 'B' };
+static const uint32_t bakedModelVersion = 1;
+static const char* const bakedModelSuffix = ".bake";
+
+static bool hostIsLittleEndian()
+{
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
 
+void Model::computeBoundingSphere()
+{
     boundingsphereradius = 0;
-    for (i = 0; i < vertexNum; i++) {
+    for (int i = 0; i < vertexNum; i++) {
         for (int j = 0; j < vertexNum; j++) {
             if (j != i && distsq(&vertex[j], &vertex[i]) / 2 > boundingsphereradius) {
                 boundingsphereradius = distsq(&vertex[j], &vertex[i]) / 2;
@@ -477,33 +465,10 @@ bool Model::loadnotex(const std::string& filename)
         }
     }
     boundingsphereradius = fast_sqrt(boundingsphereradius);
-
-    return true;
 }
 
-bool Model::load(const std::string& filename)
+void Model::allocate(short triangleNum)
 {
-    FILE* tfile;
-    long i;
-    short triangleNum;
-
-    LOGFUNC;
-
-    LOG(std::string("Loading model...") + filename);
-
-    Game::LoadingScreen();
-
-    type = normaltype;
-    color = 0;
-
-    tfile = Folders::openMandatoryFile(Folders::getResourcePath(filename), "rb");
-
-    // read model settings
-
-    fseek(tfile, 0, SEEK_SET);
-    funpackf(tfile, "Bs Bs", &vertexNum, &triangleNum);
-
-    // read the model data
     deallocate();
 
     possible.clear();
@@ -514,166 +479,236 @@ bool Model::load(const std::string& filename)
     Triangles.resize(triangleNum);
     vArray = (GLfloat*)malloc(sizeof(GLfloat) * triangleNum * 24);
 
-    for (i = 0; i < vertexNum; i++) {
-        funpackf(tfile, "Bf Bf Bf", &vertex[i].x, &vertex[i].y, &vertex[i].z);
+    for (int i = 0; i < vertexNum; i++) {
+        owner[i] = -1;
     }
+}
 
-    for (i = 0; i < triangleNum; i++) {
-        short vertex[6];
-        funpackf(tfile, "Bs Bs Bs Bs Bs Bs", &vertex[0], &vertex[1], &vertex[2], &vertex[3], &vertex[4], &vertex[5]);
-        Triangles[i].vertex[0] = vertex[0];
-        Triangles[i].vertex[1] = vertex[2];
-        Triangles[i].vertex[2] = vertex[4];
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gx[0], &Triangles[i].gx[1], &Triangles[i].gx[2]);
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gy[0], &Triangles[i].gy[1], &Triangles[i].gy[2]);
+bool Model::loadBaked(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime)
+{
+    FILE* tfile = fopen(cachePath.c_str(), "rb");
+    if (tfile == NULL) {
+        return false;
     }
 
-    modelTexture.xsz = 0;
-
+    std::vector<char> buffer;
+    fseek(tfile, 0, SEEK_END);
+    long length = ftell(tfile);
+    fseek(tfile, 0, SEEK_SET);
+    if (length >= (long)sizeof(BakedModelHeader)) {
+        buffer.resize(length);
+        if (fread(buffer.data(), 1, length, tfile) != (size_t)length) {
+            buffer.clear();
+        }
+    }
     fclose(tfile);
+    if (buffer.empty()) {
+        return false;
+    }
+
+    BakedModelHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    const size_t vertexBytes = sizeof(float) * 3 * header.vertexNum;
+    const size_t expected = sizeof(header) + vertexBytes * 2 + header.triangleNum * (sizeof(short) * 3 + sizeof(float) * (9 + 24));
+    if (memcmp(header.magic, bakedModelMagic, 4) != 0 || header.version != bakedModelVersion ||
+        header.sourceSize != sourceSize || header.sourceTime != sourceTime ||
+        header.vertexNum < 0 || header.vertexNum > SHRT_MAX || header.triangleNum < 0 || header.triangleNum > SHRT_MAX ||
+        buffer.size() != expected) {
+        return false;
+    }
+
+    vertexNum = header.vertexNum;
+    allocate(header.triangleNum);
+
+    const char* cursor = buffer.data() + sizeof(header);
+    memcpy(vertex, cursor, vertexBytes);
+    cursor += vertexBytes;
+    memcpy(normals, cursor, vertexBytes);
+    cursor += vertexBytes;
+
+    const short* indices = (const short*)cursor;
+    cursor += sizeof(short) * 3 * header.triangleNum;
+    const float* texcoords = (const float*)cursor;
+    cursor += sizeof(float) * 9 * header.triangleNum;
+    for (int i = 0; i < header.triangleNum; i++) {
+        TexturedTriangle& triangle = Triangles[i];
+        memcpy(triangle.vertex, indices + i * 3, sizeof(triangle.vertex));
+        memcpy(triangle.gx, texcoords + i * 9, sizeof(triangle.gx));
+        memcpy(triangle.gy, texcoords + i * 9 + 3, sizeof(triangle.gy));
+        triangle.facenormal.x = texcoords[i * 9 + 6];
+        triangle.facenormal.y = texcoords[i * 9 + 7];
+        triangle.facenormal.z = texcoords[i * 9 + 8];
+    }
+    memcpy(vArray, cursor, sizeof(GLfloat) * 24 * header.triangleNum);
+
+    boundingspherecenter.x = header.boundingspherecenter[0];
+    boundingspherecenter.y = header.boundingspherecenter[1];
+    boundingspherecenter.z = header.boundingspherecenter[2];
+    boundingsphereradius = header.boundingsphereradius;
 
-    UpdateVertexArray();
+    return true;
+}
 
-    for (i = 0; i < vertexNum; i++) {
-        owner[i] = -1;
+void Model::saveBaked(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime)
+{
+    BakedModelHeader header;
+    memcpy(header.magic, bakedModelMagic, 4);
+    header.version = bakedModelVersion;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.vertexNum = vertexNum;
+    header.triangleNum = Triangles.size();
+    header.boundingspherecenter[0] = boundingspherecenter.x;
+    header.boundingspherecenter[1] = boundingspherecenter.y;
+    header.boundingspherecenter[2] = boundingspherecenter.z;
+    header.boundingsphereradius = boundingsphereradius;
+
+    std::vector<short> indices(Triangles.size() * 3);
+    std::vector<float> texcoords(Triangles.size() * 9);
+    for (unsigned int i = 0; i < Triangles.size(); i++) {
+        memcpy(&indices[i * 3], Triangles[i].vertex, sizeof(Triangles[i].vertex));
+        memcpy(&texcoords[i * 9], Triangles[i].gx, sizeof(Triangles[i].gx));
+        memcpy(&texcoords[i * 9 + 3], Triangles[i].gy, sizeof(Triangles[i].gy));
+        memcpy(&texcoords[i * 9 + 6], &Triangles[i].facenormal, sizeof(float) * 3);
     }
 
-    static int j;
-    boundingsphereradius = 0;
-    for (i = 0; i < vertexNum; i++) {
-        for (j = 0; j < vertexNum; j++) {
-            if (j != i && distsq(&vertex[j], &vertex[i]) / 2 > boundingsphereradius) {
-                boundingsphereradius = distsq(&vertex[j], &vertex[i]) / 2;
-                boundingspherecenter = (vertex[i] + vertex[j]) / 2;
-            }
-        }
+    // Write to a temporary file first so a concurrent or interrupted run never sees a partial cache
+    std::string tempPath = cachePath + ".tmp";
+    FILE* tfile = fopen(tempPath.c_str(), "wb");
+    if (tfile == NULL) {
+        return;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, tfile) == 1 &&
+                   fwrite(vertex, sizeof(XYZ), vertexNum, tfile) == (size_t)vertexNum &&
+                   fwrite(normals, sizeof(XYZ), vertexNum, tfile) == (size_t)vertexNum &&
+                   fwrite(indices.data(), sizeof(short), indices.size(), tfile) == indices.size() &&
+                   fwrite(texcoords.data(), sizeof(float), texcoords.size(), tfile) == texcoords.size() &&
+                   fwrite(vArray, sizeof(GLfloat), Triangles.size() * 24, tfile) == Triangles.size() * 24;
+    written = (fclose(tfile) == 0) && written;
+    if (!written || rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        remove(tempPath.c_str());
     }
-    boundingsphereradius = fast_sqrt(boundingsphereradius);
-
-    return true;
 }
 
-bool Model::loaddecal(const std::string& filename)
+/* Shared by all loaders: fills vertices, triangles, face and vertex normals,
+ * vArray and bounding sphere, from the baked cache when it is up to date */
+bool Model::loadSolid(const std::string& filename)
 {
-    FILE* tfile;
-    long i, j;
-    short triangleNum;
-
-    LOGFUNC;
+    const std::string path = Folders::getResourcePath(filename);
 
-    LOG(std::string("Loading decal...") + Folders::getResourcePath(filename));
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    const bool cacheable = hostIsLittleEndian() && Folders::getResourceStamp(path, &sourceSize, &sourceTime);
+    const std::string cachePath = cacheable ? Folders::getCachePath(path, bakedModelSuffix) : "";
+    if (cacheable && loadBaked(cachePath, sourceSize, sourceTime)) {
+        return true;
+    }
 
-    type = decalstype;
-    color = 0;
+    BinaryReader reader;
+    long i;
+    short triangleNum;
 
-    tfile = Folders::openMandatoryFile(Folders::getResourcePath(filename), "rb");
+    Folders::openMandatoryReader(path, reader);
 
     // read model settings
 
-    fseek(tfile, 0, SEEK_SET);
-    funpackf(tfile, "Bs Bs", &vertexNum, &triangleNum);
+    vertexNum = reader.read<int16_be>();
+    triangleNum = reader.read<int16_be>();
 
     // read the model data
+    allocate(triangleNum);
 
-    deallocate();
-
-    possible.clear();
-
-    owner = (int*)malloc(sizeof(int) * vertexNum);
-    vertex = (XYZ*)malloc(sizeof(XYZ) * vertexNum);
-    normals = (XYZ*)malloc(sizeof(XYZ) * vertexNum);
-    Triangles.resize(triangleNum);
-    vArray = (GLfloat*)malloc(sizeof(GLfloat) * triangleNum * 24);
-
-    for (i = 0; i < vertexNum; i++) {
-        funpackf(tfile, "Bf Bf Bf", &vertex[i].x, &vertex[i].y, &vertex[i].z);
+    if (vertexNum > 0) {
+        reader.read_array<float_be>(&vertex[0].x, vertexNum * 3);
     }
 
     for (i = 0; i < triangleNum; i++) {
         short vertex[6];
-        funpackf(tfile, "Bs Bs Bs Bs Bs Bs", &vertex[0], &vertex[1], &vertex[2], &vertex[3], &vertex[4], &vertex[5]);
+        reader.read_array<int16_be>(vertex, 6);
         Triangles[i].vertex[0] = vertex[0];
         Triangles[i].vertex[1] = vertex[2];
         Triangles[i].vertex[2] = vertex[4];
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gx[0], &Triangles[i].gx[1], &Triangles[i].gx[2]);
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gy[0], &Triangles[i].gy[1], &Triangles[i].gy[2]);
+        reader.read_array<float_be>(Triangles[i].gx, 3);
+        reader.read_array<float_be>(Triangles[i].gy, 3);
     }
 
-    modelTexture.xsz = 0;
-
-    fclose(tfile);
-
-    UpdateVertexArray();
-
+    // Bake with the same normals CalculateNormals(0) would give the untransformed model
+    ModelType loadtype = type;
+    bool loadflat = flat;
+    type = normaltype;
+    flat = false;
     for (i = 0; i < vertexNum; i++) {
-        owner[i] = -1;
+        normals[i] = 0;
+    }
+    for (i = 0; i < triangleNum; i++) {
+        CrossProduct(vertex[Triangles[i].vertex[1]] - vertex[Triangles[i].vertex[0]], vertex[Triangles[i].vertex[2]] - vertex[Triangles[i].vertex[0]], &Triangles[i].facenormal);
+        normals[Triangles[i].vertex[0]] += Triangles[i].facenormal;
+        normals[Triangles[i].vertex[1]] += Triangles[i].facenormal;
+        normals[Triangles[i].vertex[2]] += Triangles[i].facenormal;
     }
-
-    boundingsphereradius = 0;
     for (i = 0; i < vertexNum; i++) {
-        for (j = 0; j < vertexNum; j++) {
-            if (j != i && distsq(&vertex[j], &vertex[i]) / 2 > boundingsphereradius) {
-                boundingsphereradius = distsq(&vertex[j], &vertex[i]) / 2;
-                boundingspherecenter = (vertex[i] + vertex[j]) / 2;
-            }
-        }
+        Normalise(&normals[i]);
+        normals[i] *= -1;
+    }
+    UpdateVertexArray();
+    type = loadtype;
+    flat = loadflat;
+
+    computeBoundingSphere();
+
+    if (cacheable) {
+        saveBaked(cachePath, sourceSize, sourceTime);
     }
-    boundingsphereradius = fast_sqrt(boundingsphereradius);
 
     return true;
 }
 
-bool Model::loadraw(const std::string& filename)
+bool Model::loadnotex(const std::string& filename)
 {
-    FILE* tfile;
-    long i;
-    short triangleNum;
+    type = notextype;
+    color = 0;
+
+    return loadSolid(filename);
+}
 
+bool Model::load(const std::string& filename)
+{
     LOGFUNC;
 
-    LOG(std::string("Loading raw...") + filename);
+    LOG(std::string("Loading model...") + filename);
 
-    type = rawtype;
+    type = normaltype;
     color = 0;
 
-    tfile = Folders::openMandatoryFile(Folders::getResourcePath(filename), "rb");
+    modelTexture.xsz = 0;
 
-    // read model settings
+    return loadSolid(filename);
+}
 
-    fseek(tfile, 0, SEEK_SET);
-    funpackf(tfile, "Bs Bs", &vertexNum, &triangleNum);
+bool Model::loaddecal(const std::string& filename)
+{
+    LOGFUNC;
 
-    // read the model data
-    deallocate();
+    LOG(std::string("Loading decal...") + Folders::getResourcePath(filename));
 
-    possible.clear();
+    type = decalstype;
+    color = 0;
 
-    owner = (int*)malloc(sizeof(int) * vertexNum);
-    vertex = (XYZ*)malloc(sizeof(XYZ) * vertexNum);
-    Triangles.resize(triangleNum);
-    vArray = (GLfloat*)malloc(sizeof(GLfloat) * triangleNum * 24);
+    modelTexture.xsz = 0;
 
-    for (i = 0; i < vertexNum; i++) {
-        funpackf(tfile, "Bf Bf Bf", &vertex[i].x, &vertex[i].y, &vertex[i].z);
-    }
+    return loadSolid(filename);
+}
 
-    for (i = 0; i < triangleNum; i++) {
-        short vertex[6];
-        funpackf(tfile, "Bs Bs Bs Bs Bs Bs", &vertex[0], &vertex[1], &vertex[2], &vertex[3], &vertex[4], &vertex[5]);
-        Triangles[i].vertex[0] = vertex[0];
-        Triangles[i].vertex[1] = vertex[2];
-        Triangles[i].vertex[2] = vertex[4];
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gx[0], &Triangles[i].gx[1], &Triangles[i].gx[2]);
-        funpackf(tfile, "Bf Bf Bf", &Triangles[i].gy[0], &Triangles[i].gy[1], &Triangles[i].gy[2]);
-    }
+bool Model::loadraw(const std::string& filename)
+{
+    LOGFUNC;
 
-    fclose(tfile);
+    LOG(std::string("Loading raw...") + filename);
 
-    for (i = 0; i < vertexNum; i++) {
-        owner[i] = -1;
-    }
+    type = rawtype;
+    color = 0;
 
-    return true;
+    return loadSolid(filename);
 }
 
 void Model::UniformTexCoords()
@@ -801,8 +836,6 @@ void Model::Rotate(float xang, float yang, float zang)
 
 void Model::CalculateNormals(bool facenormalise)
 {
-    Game::LoadingScreen();
-
     if (type != normaltype && type != decalstype) {
         return;
     }
@@ -838,6 +871,13 @@ void Model::CalculateNormals(bool facenormalise)
     UpdateVertexArrayNoTex();
 }
 
+void Model::CalculateFaceNormals()
+{
+    for (unsigned int i = 0; i < Triangles.size(); i++) {
+        CrossProduct(vertex[Triangles[i].vertex[1]] - vertex[Triangles[i].vertex[0]], vertex[Triangles[i].vertex[2]] - vertex[Triangles[i].vertex[0]], &Triangles[i].facenormal);
+    }
+}
+
 void Model::drawimmediate()
 {
     textureptr.bind();
@@ -1239,6 +1279,53 @@ void Model::deallocate()
     decals.clear();
 }
 
+Model::Model(const Model& other)
+    : Model()
+{
+    *this = other;
+}
+
+/* Deep copy, so per-instance models can be cloned from a shared template without touching the disk */
+Model& Model::operator=(const Model& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+
+    deallocate();
+
+    vertexNum = other.vertexNum;
+    type = other.type;
+    if (other.owner) {
+        owner = (int*)malloc(sizeof(int) * vertexNum);
+        memcpy(owner, other.owner, sizeof(int) * vertexNum);
+    }
+    if (other.vertex) {
+        vertex = (XYZ*)malloc(sizeof(XYZ) * vertexNum);
+        memcpy((void*)vertex, other.vertex, sizeof(XYZ) * vertexNum);
+    }
+    if (other.normals) {
+        normals = (XYZ*)malloc(sizeof(XYZ) * vertexNum);
+        memcpy((void*)normals, other.normals, sizeof(XYZ) * vertexNum);
+    }
+    Triangles = other.Triangles;
+    if (other.vArray) {
+        vArray = (GLfloat*)malloc(sizeof(GLfloat) * Triangles.size() * 24);
+        memcpy(vArray, other.vArray, sizeof(GLfloat) * Triangles.size() * 24);
+    }
+
+    textureptr = other.textureptr;
+    modelTexture = other.modelTexture;
+    color = other.color;
+    boundingspherecenter = other.boundingspherecenter;
+    boundingsphereradius = other.boundingsphereradius;
+    decals = other.decals;
+    flat = other.flat;
+    possible = other.possible;
+
+    return *this;
+}
+
 Model::Model()
     : vertexNum(0)
     , type(nothing)
@@ -95,6 +95,8 @@ public:
     bool flat;
 
     Model();
+    Model(const Model& other);
+    Model& operator=(const Model& other);
     ~Model();
     void DeleteDecal(int which);
     void MakeDecal(decal_type atype, XYZ* where, float* size, float* opacity, float* rotation);
@@ -120,6 +122,8 @@ public:
     void ScaleNormals(float xscale, float yscale, float zscale);
     void Translate(float xtrans, float ytrans, float ztrans);
     void CalculateNormals(bool facenormalise);
+    /* Triangle face normals only, unnormalised like CalculateNormals(0) */
+    void CalculateFaceNormals();
     void draw();
     void drawdifftex(Texture texture);
     void drawimmediate();
@@ -127,7 +131,12 @@ public:
     void deleteDeadDecals();
 
 private:
+    void allocate(short triangleNum);
     void deallocate();
+    void computeBoundingSphere();
+    bool loadSolid(const std::string& filename);
+    bool loadBaked(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime);
+    void saveBaked(const std::string& cachePath, uint64_t sourceSize, int64_t sourceTime);
     /* indices of triangles that might collide */
     std::vector<unsigned int> possible;
 };
@@ -0,0 +1,238 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Graphic/SkinTexture.hpp"
+
+#include "Graphic/TextureLoader.hpp"
+#include "Utils/Folders.hpp"
+#include "Utils/ImageIO.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+std::map<std::string, std::weak_ptr<MipChain>> SkinTexture::cache;
+
+/* Blend count texels of tinted clothes over RGB skin pixels, starting at
+ * texel first of both images */
+static void wearClothes(const ImageRec& clothes, const float tint[3], int first, int count, GLubyte* pixels)
+{
+    const int bytesPerPixel = clothes.bpp / 8;
+    if (bytesPerPixel != 3 && bytesPerPixel != 4) {
+        return;
+    }
+    const int last = std::min(first + count, (int)(clothes.sizeX * clothes.sizeY));
+    for (int t = first; t < last; t++) {
+        // Alpha used to be read after blending its pixel, so the previous pixel's applies
+        const float alphanum = (bytesPerPixel == 4 && t > 0) ? clothes.data[t * 4 - 1] : 255;
+        for (int c = 0; c < 3; c++) {
+            // Tints go by byte index, which only lines up with channels on RGBA clothes
+            const int i = t * bytesPerPixel + c;
+            GLubyte tinted = clothes.data[i];
+            if (i % 4 < 3) {
+                tinted *= tint[i % 4];
+            }
+            GLubyte& texel = pixels[(t - first) * 3 + c];
+            texel = (float)texel * (1 - alphanum / 255) + (float)tinted * (alphanum / 255);
+        }
+    }
+}
+
+SkinTexture::SkinTexture()
+    : tilesPerRow(0)
+    , dirty(false)
+{
+}
+
+bool SkinTexture::load(const std::string& fileName)
+{
+    const std::string path = Folders::getResourcePath(fileName);
+    tiles.clear();
+    dirty = false;
+
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->second.expired()) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    std::shared_ptr<MipChain> cached = cache[path].lock();
+    if (!cached) {
+        // Blood gets drawn in RGB
+        ImageRec image;
+        image.dropAlpha = true;
+        if (!TextureLoader::copy(path, image) && !load_image(path.c_str(), image)) {
+            std::cerr << "Skin " << path << " loading failed during image loading" << std::endl;
+            return false;
+        }
+        cached.reset(new MipChain());
+        cached->assign(image.data, image.sizeX, image.sizeY, image.bpp / 8);
+        cached->generate();
+        cache[path] = cached;
+    }
+    base = cached;
+    key = path;
+    tilesPerRow = (getSize() + tileSize - 1) / tileSize;
+    return true;
+}
+
+void SkinTexture::addClothes(const std::string& path, const ImageRec& clothes, float tintr, float tintg, float tintb)
+{
+    if (!base) {
+        return;
+    }
+    const float tint[3] = { tintr, tintg, tintb };
+    const int size = getSize();
+
+    const std::string clothedKey = key + '\n' + path + ' ' + std::to_string(tintr) + ' ' + std::to_string(tintg) + ' ' + std::to_string(tintb);
+    std::shared_ptr<MipChain> clothed = cache[clothedKey].lock();
+    if (!clothed) {
+        std::vector<GLubyte> pixels(base->getPixels(0), base->getPixels(0) + size * size * 3);
+        wearClothes(clothes, tint, 0, size * size, pixels.data());
+        clothed.reset(new MipChain());
+        clothed->assign(pixels.data(), size, size, 3);
+        clothed->generate();
+        cache[clothedKey] = clothed;
+    }
+
+    for (auto& entry : tiles) {
+        const int column = entry.first % tilesPerRow;
+        const int row = entry.first / tilesPerRow;
+        const int width = getTileWidth(column);
+        for (int y = 0; y < getTileWidth(row); y++) {
+            wearClothes(clothes, tint, (row * tileSize + y) * size + column * tileSize, width, &entry.second.pixels[y * width * 3]);
+        }
+        entry.second.dirty = true;
+        dirty = true;
+    }
+
+    base = clothed;
+    key = clothedKey;
+}
+
+GLubyte* SkinTexture::paint(int row, int column)
+{
+    if (row < 0 || column < 0 || row >= getSize() || column >= getSize()) {
+        return nullptr;
+    }
+    const int tileRow = row / tileSize;
+    const int tileColumn = column / tileSize;
+    const int width = getTileWidth(tileColumn);
+    Tile& tile = tiles[tileRow * tilesPerRow + tileColumn];
+    if (tile.pixels.empty()) {
+        const int size = getSize();
+        const int height = getTileWidth(tileRow);
+        const GLubyte* source = base->getPixels(0) + (tileRow * tileSize * size + tileColumn * tileSize) * 3;
+        tile.pixels.resize(width * height * 3);
+        for (int y = 0; y < height; y++) {
+            memcpy(&tile.pixels[y * width * 3], source + y * size * 3, width * 3);
+        }
+    }
+    tile.dirty = true;
+    dirty = true;
+    return &tile.pixels[((row % tileSize) * width + column % tileSize) * 3];
+}
+
+void SkinTexture::upload(Texture& texture)
+{
+    if (!base) {
+        return;
+    }
+    dirty = false;
+    if (tiles.empty()) {
+        texture.upload(key, *base);
+        return;
+    }
+
+    const int size = getSize();
+    std::vector<GLubyte> pixels(base->getPixels(0), base->getPixels(0) + size * size * 3);
+    MipChain tile;
+    for (auto& entry : tiles) {
+        copyTile(entry.first, entry.second, pixels.data());
+        // flush() needs every tile's average, only whole tiles ever get flushed
+        if ((int)entry.second.pixels.size() == tileSize * tileSize * 3) {
+            tile.assign(entry.second.pixels.data(), tileSize, tileSize, 3);
+            tile.generate();
+            memcpy(entry.second.average, tile.getPixels(tile.getLevelCount() - 1), 3);
+        }
+        entry.second.dirty = false;
+    }
+    MipChain painted;
+    painted.assign(pixels.data(), size, size, 3);
+    painted.generate();
+    texture.upload(key, painted);
+}
+
+void SkinTexture::flush(Texture& texture)
+{
+    if (!dirty) {
+        return;
+    }
+
+    // Levels down to one texel per tile only depend on that tile's texels
+    int tileLevel = 0;
+    while ((tileSize >> tileLevel) > 1) {
+        tileLevel++;
+    }
+    const int size = getSize();
+    if (!texture.isLoaded() || size % tileSize != 0 || (size & (size - 1)) != 0 || base->getLevelCount() <= tileLevel) {
+        upload(texture);
+        return;
+    }
+    texture.bind();
+
+    MipChain tile;
+    std::vector<GLubyte> coarse(base->getPixels(tileLevel), base->getPixels(tileLevel) + tilesPerRow * tilesPerRow * 3);
+    for (auto& entry : tiles) {
+        if (entry.second.dirty) {
+            tile.assign(entry.second.pixels.data(), tileSize, tileSize, 3);
+            tile.generate();
+            tile.upload((entry.first % tilesPerRow) * tileSize, (entry.first / tilesPerRow) * tileSize, 0);
+            memcpy(entry.second.average, tile.getPixels(tile.getLevelCount() - 1), 3);
+            entry.second.dirty = false;
+        }
+        memcpy(&coarse[entry.first * 3], entry.second.average, 3);
+    }
+
+    // Coarser levels mix tiles, they are tiny enough to redo whole
+    MipChain top;
+    top.assign(coarse.data(), tilesPerRow, tilesPerRow, 3);
+    top.generate();
+    top.upload(0, 0, tileLevel);
+    dirty = false;
+}
+
+int SkinTexture::getTileWidth(int i) const
+{
+    return std::min(tileSize, getSize() - i * tileSize);
+}
+
+void SkinTexture::copyTile(int index, const Tile& tile, GLubyte* pixels) const
+{
+    const int size = getSize();
+    const int column = index % tilesPerRow;
+    const int row = index / tilesPerRow;
+    const int width = getTileWidth(column);
+    for (int y = 0; y < getTileWidth(row); y++) {
+        memcpy(pixels + ((row * tileSize + y) * size + column * tileSize) * 3, &tile.pixels[y * width * 3], width * 3);
+    }
+}
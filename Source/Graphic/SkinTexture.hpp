@@ -0,0 +1,96 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SKIN_TEXTURE_HPP_
+#define _SKIN_TEXTURE_HPP_
+
+#include "Graphic/MipChain.hpp"
+#include "Graphic/Texture.hpp"
+#include "Graphic/gamegl.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ImageRec;
+
+/* RGB skin of a person.
+ *
+ * The base image, a stock skin with clothes tinted over it, is shared by
+ * everybody wearing the same skin and clothes. Blood painted on a person goes
+ * into square tiles of its own, copied off the base on the first texel
+ * painted in them, and composited over the base when uploading.
+ */
+class SkinTexture
+{
+public:
+    static const int tileSize = 32;
+
+    SkinTexture();
+
+    /* Wear a stock skin, dropping clothes and blood */
+    bool load(const std::string& fileName);
+    /* Tint clothes over the skin, blood included, like they were painted on */
+    void addClothes(const std::string& path, const ImageRec& clothes, float tintr, float tintg, float tintb);
+
+    bool isLoaded() const { return base != nullptr; }
+    int getSize() const { return base ? base->getWidth(0) : 0; }
+
+    /* Writable RGB texel at (row, column), its tile gets uploaded on the next flush().
+     * nullptr outside of the skin. */
+    GLubyte* paint(int row, int column);
+    bool isDirty() const { return dirty; }
+
+    /* Upload every level of the skin as painted into texture */
+    void upload(Texture& texture);
+    /* Upload only the tiles painted since the last flush() or upload() */
+    void flush(Texture& texture);
+
+private:
+    struct Tile
+    {
+        std::vector<GLubyte> pixels;
+        /* The whole tile averaged, its texel on the coarsest level a tile still has alone */
+        GLubyte average[3];
+        bool dirty;
+
+        Tile()
+            : dirty(false)
+        {
+        }
+    };
+
+    std::shared_ptr<MipChain> base;
+    std::string key;
+    int tilesPerRow;
+    /* Painted tiles only, row major */
+    std::map<int, Tile> tiles;
+    bool dirty;
+
+    /* Texels across tile column (or down tile row) number i, less on the last one */
+    int getTileWidth(int i) const;
+    void copyTile(int index, const Tile& tile, GLubyte* pixels) const;
+
+    /* Bases by skin path and clothes, shared while somebody wears them */
+    static std::map<std::string, std::weak_ptr<MipChain>> cache;
+};
+
+#endif
@@ -0,0 +1,400 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Graphic/SkinnedMesh.hpp"
+
+#include <SDL.h>
+#include <iostream>
+#include <string>
+
+/* OpenGL 2.0 entry points, looked up at runtime since not every platform's
+ * GL library exports them */
+#define SKINNED_MESH_GL_FUNCTIONS(X) \
+    X(AttachShader)                  \
+    X(BindAttribLocation)            \
+    X(BindBuffer)                    \
+    X(BufferData)                    \
+    X(BufferSubData)                 \
+    X(CompileShader)                 \
+    X(CreateProgram)                 \
+    X(CreateShader)                  \
+    X(DeleteBuffers)                 \
+    X(DeleteProgram)                 \
+    X(DeleteShader)                  \
+    X(DisableVertexAttribArray)      \
+    X(EnableVertexAttribArray)       \
+    X(GenBuffers)                    \
+    X(GetProgramInfoLog)             \
+    X(GetProgramiv)                  \
+    X(GetShaderInfoLog)              \
+    X(GetShaderiv)                   \
+    X(GetUniformLocation)            \
+    X(LinkProgram)                   \
+    X(ShaderSource)                  \
+    X(Uniform1i)                     \
+    X(Uniform4fv)                    \
+    X(UseProgram)                    \
+    X(VertexAttribPointer)
+
+namespace {
+
+#define DECLARE_GL_FUNCTION(name) decltype(&::gl##name) name;
+struct
+{
+    SKINNED_MESH_GL_FUNCTIONS(DECLARE_GL_FUNCTION)
+} gl;
+#undef DECLARE_GL_FUNCTION
+
+const GLuint muscleAttribute = 1;
+const int cornerFloats = 8;
+
+// Built-in uniforms the program reads, in vec4s: the modelview projection,
+// normal and texture matrices, the light and the lighting switch
+const int reservedRows = 16;
+
+bool supported = false;
+int maxMuscles = 0;
+GLuint program = 0;
+// Muscles the program's uniform array holds
+int programMuscles = 0;
+GLint musclesLocation = -1;
+GLint lightingLocation = -1;
+
+/* Positions are skinned like Skinning::transform does. Normals go through the
+ * cofactors of the same rows, which is SkinMatrix::forNormals up to a length
+ * normalize() drops, so the proportions' non-uniform scale bends them like
+ * Skinning::transformNormals does. Lighting
+ * follows the fixed function pipeline for what the game uses: GL_LIGHT0 as a
+ * directional light, GL_COLOR_MATERIAL and no specular. Fragments still go
+ * through the fixed function pipeline. */
+const char* const vertexSource =
+    "#version 120\n"
+    "uniform vec4 muscles[MUSCLE_ROWS];\n"
+    "uniform bool lighting;\n"
+    "attribute float muscle;\n"
+    "void main()\n"
+    "{\n"
+    "    int row = int(muscle) * 3;\n"
+    "    vec4 bind = vec4(gl_Vertex.xyz, 1.0);\n"
+    "    vec3 position = vec3(dot(muscles[row], bind), dot(muscles[row + 1], bind), dot(muscles[row + 2], bind));\n"
+    "    vec3 r0 = muscles[row].xyz;\n"
+    "    vec3 r1 = muscles[row + 1].xyz;\n"
+    "    vec3 r2 = muscles[row + 2].xyz;\n"
+    "    vec3 normal = vec3(dot(cross(r1, r2), gl_Normal), dot(cross(r2, r0), gl_Normal), dot(cross(r0, r1), gl_Normal));\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(position, 1.0);\n"
+    "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+    "    if (lighting) {\n"
+    "        vec3 n = normalize(gl_NormalMatrix * normal);\n"
+    "        float diffuse = max(dot(n, normalize(gl_LightSource[0].position.xyz)), 0.0);\n"
+    "        vec3 light = gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb + gl_LightSource[0].diffuse.rgb * diffuse;\n"
+    "        gl_FrontColor = vec4(clamp(gl_Color.rgb * light, 0.0, 1.0), gl_Color.a);\n"
+    "    } else {\n"
+    "        gl_FrontColor = gl_Color;\n"
+    "    }\n"
+    "}\n";
+
+bool checkShader(GLuint shader)
+{
+    GLint status = GL_FALSE;
+    gl.GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024] = "";
+        gl.GetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "GPU skinning shader failed to compile: " << log << std::endl;
+    }
+    return status == GL_TRUE;
+}
+
+bool checkProgram(GLuint program)
+{
+    GLint status = GL_FALSE;
+    gl.GetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        char log[1024] = "";
+        gl.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "GPU skinning program failed to link: " << log << std::endl;
+    }
+    return status == GL_TRUE;
+}
+
+/* Make sure the program holds muscleNum matrices */
+bool compileProgram(int muscleNum)
+{
+    if (muscleNum <= programMuscles) {
+        return true;
+    }
+
+    const std::string rows = "MUSCLE_ROWS";
+    std::string source = vertexSource;
+    source.replace(source.find(rows), rows.size(), std::to_string(muscleNum * 3));
+    const GLchar* sourcePtr = source.c_str();
+    GLuint shader = gl.CreateShader(GL_VERTEX_SHADER);
+    gl.ShaderSource(shader, 1, &sourcePtr, nullptr);
+    gl.CompileShader(shader);
+    if (!checkShader(shader)) {
+        gl.DeleteShader(shader);
+        return false;
+    }
+
+    GLuint larger = gl.CreateProgram();
+    gl.AttachShader(larger, shader);
+    gl.BindAttribLocation(larger, muscleAttribute, "muscle");
+    gl.LinkProgram(larger);
+    // The program keeps the shader alive as long as it needs it
+    gl.DeleteShader(shader);
+    if (!checkProgram(larger)) {
+        gl.DeleteProgram(larger);
+        return false;
+    }
+
+    // Meshes built for fewer muscles upload a prefix of the larger array
+    if (program != 0) {
+        gl.DeleteProgram(program);
+    }
+    program = larger;
+    programMuscles = muscleNum;
+    musclesLocation = gl.GetUniformLocation(program, "muscles");
+    lightingLocation = gl.GetUniformLocation(program, "lighting");
+    return true;
+}
+
+} // namespace
+
+bool SkinnedMesh::init()
+{
+    return init(SDL_GL_GetProcAddress);
+}
+
+bool SkinnedMesh::init(void* (*getProcAddress)(const char*))
+{
+    if (supported) {
+        return true;
+    }
+
+    bool found = true;
+#define LOAD_GL_FUNCTION(name)                               \
+    gl.name = (decltype(gl.name))getProcAddress("gl" #name); \
+    found = found && gl.name != nullptr;
+    SKINNED_MESH_GL_FUNCTIONS(LOAD_GL_FUNCTION)
+#undef LOAD_GL_FUNCTION
+    if (!found || glGetString(GL_SHADING_LANGUAGE_VERSION) == nullptr) {
+        std::cerr << "GPU skinning needs OpenGL 2.0, using CPU skinning" << std::endl;
+        return false;
+    }
+
+    // Three vec4 rows per muscle, GL 2.0 only promises 512 components in all
+    GLint components = 0;
+    glGetIntegerv(GL_MAX_VERTEX_UNIFORM_COMPONENTS, &components);
+    maxMuscles = (components / 4 - reservedRows) / 3;
+    if (maxMuscles < 1) {
+        std::cerr << "GPU skinning doesn't fit " << components << " vertex uniform components, using CPU skinning" << std::endl;
+        maxMuscles = 0;
+        return false;
+    }
+
+    // One muscle checks the driver takes the program, the first skeleton sizes it
+    supported = compileProgram(1);
+    return supported;
+}
+
+bool SkinnedMesh::isSupported()
+{
+    return supported;
+}
+
+int SkinnedMesh::getMaxMuscles()
+{
+    return maxMuscles;
+}
+
+SkinnedMesh::SkinnedMesh()
+    : buffer(0)
+    , cornerNum(0)
+    , dirty(false)
+    , stale(false)
+{
+}
+
+SkinnedMesh::~SkinnedMesh()
+{
+    release();
+}
+
+bool SkinnedMesh::build(const Model& bind, const Model& draw, int muscleNum)
+{
+    release();
+    if (!isSupported() || muscleNum > maxMuscles || bind.vertexNum != draw.vertexNum) {
+        return false;
+    }
+    if (!compileProgram(muscleNum)) {
+        // Don't try again for every person on every frame
+        supported = false;
+        return false;
+    }
+
+    cornerNum = draw.Triangles.size() * 3;
+    data.resize(cornerNum * (cornerFloats + 1));
+    cornerStart.assign(draw.vertexNum + 1, 0);
+    for (int k = 0; k < cornerNum; k++) {
+        const TexturedTriangle& triangle = draw.Triangles[k / 3];
+        const int v = triangle.vertex[k % 3];
+        GLfloat* corner = &data[k * cornerFloats];
+        corner[0] = triangle.gx[k % 3];
+        corner[1] = triangle.gy[k % 3];
+        corner[2] = bind.normals[v].x;
+        corner[3] = bind.normals[v].y;
+        corner[4] = bind.normals[v].z;
+        corner[5] = bind.vertex[v].x;
+        corner[6] = bind.vertex[v].y;
+        corner[7] = bind.vertex[v].z;
+        data[cornerNum * cornerFloats + k] = bind.owner[v];
+        cornerStart[v + 1]++;
+    }
+    for (int v = 0; v < draw.vertexNum; v++) {
+        cornerStart[v + 1] += cornerStart[v];
+    }
+    vertexCorners.resize(cornerNum);
+    std::vector<int> filled(cornerStart.begin(), cornerStart.end() - 1);
+    for (int k = 0; k < cornerNum; k++) {
+        vertexCorners[filled[draw.Triangles[k / 3].vertex[k % 3]]++] = k;
+    }
+
+    matrices.assign(muscleNum, SkinMatrix());
+    blends.assign(muscleNum, Blend{ bind.vertex, bind.vertex, 0 });
+
+    gl.GenBuffers(1, &buffer);
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffer);
+    gl.BufferData(GL_ARRAY_BUFFER, data.size() * sizeof(GLfloat), data.data(), GL_DYNAMIC_DRAW);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    dirty = false;
+    stale = true;
+    return true;
+}
+
+void SkinnedMesh::release()
+{
+    if (buffer != 0) {
+        gl.DeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    cornerNum = 0;
+    data.clear();
+    cornerStart.clear();
+    vertexCorners.clear();
+    matrices.clear();
+    blends.clear();
+}
+
+void SkinnedMesh::setMuscle(int index, const SkinMatrix& matrix)
+{
+    matrices[index] = matrix;
+    stale = true;
+}
+
+void SkinnedMesh::morph(int index, const XYZ* rest, const XYZ* target, float morphness, const std::vector<int>& vertices)
+{
+    if (morphness == 0) {
+        target = rest;
+    }
+    Blend& blend = blends[index];
+    if (blend.rest == rest && blend.target == target && blend.morphness == morphness) {
+        return;
+    }
+    blend.rest = rest;
+    blend.target = target;
+    blend.morphness = morphness;
+
+    for (int v : vertices) {
+        XYZ position = rest[v];
+        if (target != rest) {
+            position.x = rest[v].x * (1 - morphness) + target[v].x * morphness;
+            position.y = rest[v].y * (1 - morphness) + target[v].y * morphness;
+            position.z = rest[v].z * (1 - morphness) + target[v].z * morphness;
+        }
+        for (int c = cornerStart[v]; c < cornerStart[v + 1]; c++) {
+            GLfloat* corner = &data[vertexCorners[c] * cornerFloats];
+            corner[5] = position.x;
+            corner[6] = position.y;
+            corner[7] = position.z;
+        }
+    }
+    dirty = true;
+    stale = true;
+}
+
+void SkinnedMesh::upload()
+{
+    // Muscle indices never change, only the corners go up again
+    gl.BufferSubData(GL_ARRAY_BUFFER, 0, cornerNum * cornerFloats * sizeof(GLfloat), data.data());
+    dirty = false;
+}
+
+void SkinnedMesh::draw(Texture texture, bool repeat)
+{
+    if (!isBuilt()) {
+        return;
+    }
+
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (dirty) {
+        upload();
+    }
+
+    gl.UseProgram(program);
+    gl.Uniform4fv(musclesLocation, matrices.size() * 3, &matrices[0].rows[0][0]);
+    gl.Uniform1i(lightingLocation, glIsEnabled(GL_LIGHTING));
+
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glInterleavedArrays(GL_T2F_N3F_V3F, cornerFloats * sizeof(GLfloat), nullptr);
+    gl.EnableVertexAttribArray(muscleAttribute);
+    gl.VertexAttribPointer(muscleAttribute, 1, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)(cornerNum * cornerFloats * sizeof(GLfloat)));
+
+    texture.bind();
+    if (repeat) {
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+
+    glDrawArrays(GL_TRIANGLES, 0, cornerNum);
+
+    gl.DisableVertexAttribArray(muscleAttribute);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    gl.UseProgram(0);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SkinnedMesh::skin(const std::vector<Muscle>& muscles, Model& model)
+{
+    for (unsigned i = 0; i < matrices.size() && i < muscles.size(); i++) {
+        const std::vector<int>& vertices = muscles[i].vertices;
+        const Blend& blend = blends[i];
+        if (blend.target == blend.rest) {
+            Skinning::transform(matrices[i], blend.rest, vertices.data(), vertices.size(), model.vertex);
+        } else {
+            Skinning::transform(matrices[i], blend.rest, blend.target, blend.morphness, vertices.data(), vertices.size(), model.vertex);
+        }
+    }
+    model.CalculateNormals(0);
+    stale = false;
+}
@@ -0,0 +1,105 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SKINNED_MESH_HPP_
+#define _SKINNED_MESH_HPP_
+
+#include "Animation/Muscle.hpp"
+#include "Animation/Skinning.hpp"
+#include "Graphic/Models.hpp"
+#include "Graphic/Texture.hpp"
+#include "Graphic/gamegl.hpp"
+
+#include <vector>
+
+/* Draw model skinned by a vertex program instead of on the CPU.
+ *
+ * The vertex buffer holds the triangle corners of the draw model laid out
+ * like its vArray (texture coordinates, normal, position), but with muscle
+ * space bind positions and normals, followed by the owning muscle of each
+ * corner. Posing only sets the muscle matrices, which get uploaded as
+ * uniforms on draw. Morph blends rewrite the bind positions of the vertices
+ * they move whenever a muscle's blend changes.
+ */
+class SkinnedMesh
+{
+public:
+    /* Look up the GL 2.0 entry points and the vertex uniform limit, needs a
+     * current GL context. Returns false when the driver can't run the skinning
+     * program, persons then stay on the CPU path. */
+    static bool init();
+    /* Same with another loader than SDL's, for tools running without a window */
+    static bool init(void* (*getProcAddress)(const char*));
+    static bool isSupported();
+    /* Most muscles a skeleton can have for its matrices to fit the driver's
+     * vertex uniforms, larger ones stay on the CPU path */
+    static int getMaxMuscles();
+
+    SkinnedMesh();
+    ~SkinnedMesh();
+
+    /* bind is the muscle space model with owners and bind normals
+     * (SkeletonTemplate::model[0]), draw the textured model it poses. The
+     * program gets compiled again whenever a skeleton with more muscles than
+     * it was sized for comes along. */
+    bool build(const Model& bind, const Model& draw, int muscleNum);
+    void release();
+    bool isBuilt() const { return buffer != 0; }
+
+    void setMuscle(int index, const SkinMatrix& matrix);
+    /* Bind positions of the muscle's vertices become rest * (1 - morphness) + target * morphness */
+    void morph(int index, const XYZ* rest, const XYZ* target, float morphness, const std::vector<int>& vertices);
+
+    /* Draw with the current GL state and transform, like Model::drawdifftex when repeat is set */
+    void draw(Texture texture, bool repeat);
+
+    /* Whether the muscles moved since the last skin() */
+    bool isStale() const { return stale; }
+    /* Pose model on the CPU with the current matrices and blends, for ray tests */
+    void skin(const std::vector<Muscle>& muscles, Model& model);
+
+    /* Make sure SkinnedMesh never gets copied, it owns the buffer */
+    SkinnedMesh(SkinnedMesh const& other) = delete;
+    SkinnedMesh& operator=(SkinnedMesh const& other) = delete;
+
+private:
+    struct Blend
+    {
+        const XYZ* rest;
+        const XYZ* target;
+        float morphness;
+    };
+
+    void upload();
+
+    GLuint buffer;
+    int cornerNum;
+    /* Interleaved corners as uploaded, then one muscle index per corner */
+    std::vector<GLfloat> data;
+    /* Corners of each vertex, vertexCorners[cornerStart[v]] to vertexCorners[cornerStart[v + 1]] */
+    std::vector<int> cornerStart;
+    std::vector<int> vertexCorners;
+    std::vector<SkinMatrix> matrices;
+    std::vector<Blend> blends;
+    bool dirty;
+    bool stale;
+};
+
+#endif
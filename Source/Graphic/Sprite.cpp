@@ -367,6 +367,7 @@ void Sprite::Draw()
 
                         movepoint = 0;
                         rotationpoint = 0;
+                        Person::players[j]->skeleton.syncDrawModel();
                         whichtri = Person::players[j]->skeleton.drawmodel.LineCheck(&startpoint, &endpoint, &footpoint, &movepoint, &rotationpoint);
                         if (whichtri != -1) {
                             spritehit = 1;
@@ -20,16 +20,22 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Graphic/Texture.hpp"
 
+#include "Game.hpp"
+#include "Graphic/TextureLoader.hpp"
 #include "Utils/Folders.hpp"
-#include "Utils/ImageIO.hpp"
 #include <filesystem>
 
 using namespace std;
 
 extern bool trilinear;
 
+size_t TextureRes::totalResidentBytes = 0;
+
+std::map<std::pair<std::string, bool>, std::weak_ptr<TextureRes>> Texture::registry;
+unsigned Texture::registryHits = 0;
+unsigned Texture::registryMisses = 0;
+
 void TextureRes::load() {
-    ImageRec texture;
     std::string resourceTexturePath;
 
     // Correct malformed paths by removing redundant "Data/:"
@@ -51,30 +57,24 @@ void TextureRes::load() {
     filename = resourceTexturePath;
     std::cout << "Loading Texture: " << filename << std::endl;
 
-    // Clear any previous OpenGL errors
-    while (glGetError() != GL_NO_ERROR);
-
-    // Now, try loading the image
-    if (!load_image(filename.c_str(), texture)) {
-        std::cerr << "Texture " << filename << " loading failed during image loading" << std::endl;
-        return;
+    // Use the image decoded by the workers if it was prefetched, otherwise decode it here
+    std::unique_ptr<MipChain> texture = TextureLoader::take(filename);
+    if (!texture) {
+        texture.reset(new MipChain());
+        Game::LoadingScreen();
+        if (!MipChain::loadImage(filename, hasMipmap, *texture)) {
+            std::cerr << "Texture " << filename << " loading failed during image loading" << std::endl;
+            return;
+        }
     }
 
-    // Proceed with binding and setting up the texture as usual
-    skinsize = texture.sizeX;
-    GLuint type = GL_RGBA;
-
-    // Handle different texture bit depths
-    if (texture.bpp == 24) {
-        type = GL_RGB;
-    } else if (texture.bpp == 32) {
-        type = GL_RGBA;
-    } else {
-        std::cerr << "Unsupported texture format: " << texture.bpp << " bits per pixel" << std::endl;
-        return;
-    }
+    upload(*texture);
+}
 
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+void TextureRes::upload(MipChain& texture)
+{
+    // Clear any previous OpenGL errors
+    while (glGetError() != GL_NO_ERROR);
 
     glDeleteTextures(1, &id);
     glGenTextures(1, &id);
@@ -85,26 +85,19 @@ void TextureRes::load() {
 
     if (hasMipmap) {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST));
-        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+        // Prefetched without mipmaps by someone else
+        if (texture.getLevelCount() == 1) {
+            texture.generate();
+        }
     } else {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     }
 
-    // Set texture data for skin or standard texture
-    if (isSkin) {
-        free(data);
-        const int nb = texture.sizeY * texture.sizeX * (texture.bpp / 8);
-        data = (GLubyte*)malloc(nb * sizeof(GLubyte));
-        datalen = 0;
-        for (int i = 0; i < nb; i++) {
-            if ((i + 1) % 4 || type == GL_RGB) {
-                data[datalen++] = texture.data[i];
-            }
-        }
-        glTexImage2D(GL_TEXTURE_2D, 0, type, texture.sizeX, texture.sizeY, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    } else {
-        glTexImage2D(GL_TEXTURE_2D, 0, type, texture.sizeX, texture.sizeY, 0, type, GL_UNSIGNED_BYTE, texture.data);
-    }
+    texture.upload();
+
+    totalResidentBytes -= residentBytes;
+    residentBytes = texture.getTotalBytes();
+    totalResidentBytes += residentBytes;
 
     // Check for OpenGL errors
     GLenum err;
@@ -122,44 +115,86 @@ TextureRes::TextureRes(const string& _filename, bool _hasMipmap)
     : id(0)
     , filename(_filename)
     , hasMipmap(_hasMipmap)
-    , isSkin(false)
-    , skinsize(0)
-    , data(NULL)
-    , datalen(0)
+    , residentBytes(0)
 {
     load();
 }
 
-TextureRes::TextureRes(const string& _filename, bool _hasMipmap, GLubyte* array, int* skinsizep)
+TextureRes::TextureRes(const string& _filename, bool _hasMipmap, bool)
     : id(0)
     , filename(_filename)
     , hasMipmap(_hasMipmap)
-    , isSkin(true)
-    , skinsize(0)
-    , data(NULL)
-    , datalen(0)
+    , residentBytes(0)
 {
-    load();
-    *skinsizep = skinsize;
-    for (int i = 0; i < datalen; i++) {
-        array[i] = data[i];
-    }
 }
 
 TextureRes::~TextureRes()
 {
-    free(data);
+    totalResidentBytes -= residentBytes;
     glDeleteTextures(1, &id);
 }
 
+bool Texture::findShared(const std::string& path, bool hasMipmap)
+{
+    auto found = registry.find(std::make_pair(path, hasMipmap));
+    if (found != registry.end()) {
+        std::shared_ptr<TextureRes> shared = found->second.lock();
+        if (shared) {
+            registryHits++;
+            tex = shared;
+            return true;
+        }
+    }
+    registryMisses++;
+    return false;
+}
+
 void Texture::load(const string& filename, bool hasMipmap)
 {
-    tex.reset(new TextureRes(Folders::getResourcePath(filename), hasMipmap));
+    std::string path = Folders::getResourcePath(filename);
+    if (findShared(path, hasMipmap)) {
+        return;
+    }
+    tex.reset(new TextureRes(path, hasMipmap));
+    registry[std::make_pair(path, hasMipmap)] = tex;
+}
+
+void Texture::upload(const string& name, MipChain& image)
+{
+    if (!tex) {
+        tex.reset(new TextureRes(name, image.getLevelCount() > 1, true));
+    }
+    tex->upload(image);
+}
+
+void Texture::loadAsync(const string& filename, bool hasMipmap)
+{
+    std::string path = Folders::getResourcePath(filename);
+    if (findShared(path, hasMipmap)) {
+        return;
+    }
+    TextureLoader::prefetch(path, hasMipmap);
+    tex.reset(new TextureRes(path, hasMipmap, true));
+    registry[std::make_pair(path, hasMipmap)] = tex;
+    TextureLoader::queueUpload(tex);
 }
 
-void Texture::load(const string& filename, bool hasMipmap, GLubyte* array, int* skinsizep)
+Texture::RegistryStats Texture::getRegistryStats()
 {
-    tex.reset(new TextureRes(Folders::getResourcePath(filename), hasMipmap, array, skinsizep));
+    RegistryStats stats;
+    stats.hits = registryHits;
+    stats.misses = registryMisses;
+    stats.sharedTextures = 0;
+    for (auto it = registry.begin(); it != registry.end();) {
+        if (it->second.expired()) {
+            it = registry.erase(it);
+        } else {
+            stats.sharedTextures++;
+            ++it;
+        }
+    }
+    stats.residentBytes = TextureRes::getTotalResidentBytes();
+    return stats;
 }
 
 void Texture::bind()
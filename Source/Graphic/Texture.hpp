@@ -28,24 +28,34 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <vector>
 
+class MipChain;
+
 class TextureRes
 {
 private:
     GLuint id;
     string filename;
     bool hasMipmap;
-    bool isSkin;
-    int skinsize;
-    GLubyte* data;
-    int datalen;
+    size_t residentBytes;
+
+    /* Video memory taken by all uploaded textures, mip levels included */
+    static size_t totalResidentBytes;
 
     void load();
+    void upload(MipChain& texture);
+
+    friend class Texture;
+    friend class TextureLoader;
 
 public:
     TextureRes(const string& filename, bool hasMipmap);
-    TextureRes(const string& filename, bool hasMipmap, GLubyte* array, int* skinsize);
+    /* Leaves the texture empty, TextureLoader uploads it once its image is decoded */
+    TextureRes(const string& filename, bool hasMipmap, bool deferred);
     ~TextureRes();
     void bind();
+    bool isLoaded() const { return id != 0; }
+
+    static size_t getTotalResidentBytes() { return totalResidentBytes; }
 
     /* Make sure TextureRes never gets copied */
     TextureRes(TextureRes const& other) = delete;
@@ -57,14 +67,37 @@ class Texture
 private:
     std::shared_ptr<TextureRes> tex;
 
+    /* Textures loaded by resolved path and mipmap flag, shared while any Texture still uses them.
+     * Skins are left out since each person draws its own blood on them. */
+    static std::map<std::pair<std::string, bool>, std::weak_ptr<TextureRes>> registry;
+    static unsigned registryHits;
+    static unsigned registryMisses;
+
+    bool findShared(const std::string& path, bool hasMipmap);
+
 public:
+    struct RegistryStats
+    {
+        unsigned hits;
+        unsigned misses;
+        unsigned sharedTextures;
+        size_t residentBytes;
+    };
+
     inline Texture()
         : tex(nullptr)
     {
     }
     void load(const string& filename, bool hasMipmap);
-    void load(const string& filename, bool hasMipmap, GLubyte* array, int* skinsizep);
+    /* Upload an image built on the CPU (skins) with all its levels, into this
+     * texture's own GL object once it has one. Never shared through the registry. */
+    void upload(const string& name, MipChain& image);
+    /* Returns right away, binds nothing until the decoded image got uploaded */
+    void loadAsync(const string& filename, bool hasMipmap);
     void bind();
+    bool isLoaded() const { return tex && tex->isLoaded(); }
+
+    static RegistryStats getRegistryStats();
 };
 
 #endif
@@ -0,0 +1,329 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Graphic/TextureLoader.hpp"
+
+#include "Graphic/Texture.hpp"
+#include "Utils/Folders.hpp"
+#include "Utils/ImageIO.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct DecodeJob
+{
+    std::string path;
+    bool mipmaps;
+    /* Shared images stay in the pool until clear(), copy() hands out their level 0 */
+    bool shared;
+    bool dropAlpha;
+    /* Set for a task from runTask() instead of an image */
+    std::function<void()> task;
+    std::unique_ptr<MipChain> image;
+    bool done;
+    bool ok;
+};
+
+class DecodePool
+{
+public:
+    DecodePool()
+        : stopping(false)
+    {
+    }
+
+    ~DecodePool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            queue.clear();
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void submit(const std::string& path, bool mipmaps, bool shared, bool dropAlpha)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.find(path) != jobs.end()) {
+            return;
+        }
+        std::shared_ptr<DecodeJob> job(new DecodeJob());
+        job->path = path;
+        job->mipmaps = mipmaps;
+        job->shared = shared;
+        job->dropAlpha = dropAlpha;
+        job->done = false;
+        job->ok = false;
+        jobs[path] = job;
+        queue.push_back(job);
+        start();
+        wake.notify_one();
+    }
+
+    void submit(std::function<void()> task)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<DecodeJob> job(new DecodeJob());
+        job->task = std::move(task);
+        job->done = false;
+        job->ok = false;
+        queue.push_back(job);
+        start();
+        wake.notify_one();
+    }
+
+    std::unique_ptr<MipChain> take(const std::string& path)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto found = jobs.find(path);
+        if (found == jobs.end() || found->second->shared) {
+            return nullptr;
+        }
+        std::shared_ptr<DecodeJob> job = found->second;
+        jobs.erase(found);
+
+        // Not picked up by a worker yet, decoding it right away beats waiting behind the queue
+        auto queued = std::find(queue.begin(), queue.end(), job);
+        if (queued != queue.end()) {
+            queue.erase(queued);
+            return nullptr;
+        }
+
+        finished.wait(lock, [&job] { return job->done; });
+        if (!job->ok) {
+            return nullptr;
+        }
+        return std::move(job->image);
+    }
+
+    bool copy(const std::string& path, ImageRec& image)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto found = jobs.find(path);
+        if (found == jobs.end() || !found->second->shared) {
+            return false;
+        }
+        std::shared_ptr<DecodeJob> job = found->second;
+
+        // Several persons copy the same image, so decode it here once instead of dropping it
+        auto queued = std::find(queue.begin(), queue.end(), job);
+        if (queued != queue.end()) {
+            queue.erase(queued);
+            lock.unlock();
+            std::unique_ptr<MipChain> decoded(new MipChain());
+            bool ok = decode(*job, *decoded);
+            lock.lock();
+            finish(*job, std::move(decoded), ok);
+        }
+
+        finished.wait(lock, [&job] { return job->done; });
+        if (!job->ok) {
+            return false;
+        }
+        const MipChain& decoded = *job->image;
+        if (!image.allocate(decoded.getWidth(0), decoded.getHeight(0), decoded.getChannels() * 8)) {
+            return false;
+        }
+        memcpy(image.data, decoded.getPixels(0), size_t(image.sizeX) * image.sizeY * decoded.getChannels());
+        return true;
+    }
+
+    bool isReady(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = jobs.find(path);
+        return found == jobs.end() || found->second->done;
+    }
+
+    void clear()
+    {
+        // Jobs being decoded keep running, their result is just dropped. Tasks
+        // still run, whoever queued them is waiting on their result.
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.erase(std::remove_if(queue.begin(), queue.end(), [](const std::shared_ptr<DecodeJob>& job) { return !job->task; }), queue.end());
+        jobs.clear();
+    }
+
+private:
+    /* Called with the mutex held */
+    void start()
+    {
+        if (!threads.empty()) {
+            return;
+        }
+        unsigned count = std::thread::hardware_concurrency();
+        count = std::max(1u, std::min(4u, count > 1 ? count - 1 : 1));
+        for (unsigned i = 0; i < count; i++) {
+            threads.emplace_back(&DecodePool::run, this);
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) {
+                return;
+            }
+            std::shared_ptr<DecodeJob> job = queue.front();
+            queue.pop_front();
+
+            lock.unlock();
+            if (job->task) {
+                job->task();
+                lock.lock();
+                continue;
+            }
+            std::unique_ptr<MipChain> image(new MipChain());
+            bool ok = decode(*job, *image);
+            lock.lock();
+
+            finish(*job, std::move(image), ok);
+        }
+    }
+
+    static bool decode(const DecodeJob& job, MipChain& image)
+    {
+        if (!job.shared) {
+            return MipChain::loadImage(job.path, job.mipmaps, image);
+        }
+        ImageRec decoded;
+        decoded.dropAlpha = job.dropAlpha;
+        if (!decode_image(job.path.c_str(), decoded)) {
+            return false;
+        }
+        image.assign(decoded.data, decoded.sizeX, decoded.sizeY, decoded.bpp / 8);
+        return true;
+    }
+
+    /* Called with the mutex held */
+    void finish(DecodeJob& job, std::unique_ptr<MipChain> image, bool ok)
+    {
+        job.image = std::move(image);
+        job.ok = ok;
+        job.done = true;
+        finished.notify_all();
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::deque<std::shared_ptr<DecodeJob>> queue;
+    std::map<std::string, std::shared_ptr<DecodeJob>> jobs;
+    std::vector<std::thread> threads;
+    bool stopping;
+};
+
+DecodePool pool;
+
+// Only touched from the main thread
+std::vector<std::weak_ptr<TextureRes>> pendingUploads;
+
+} // namespace
+
+void TextureLoader::prefetch(const std::string& filename, bool mipmaps)
+{
+    std::string path = Folders::getResourcePath(filename);
+    if (!path.empty()) {
+        pool.submit(path, mipmaps, false, false);
+    }
+}
+
+void TextureLoader::prefetch(const std::vector<std::string>& filenames, bool mipmaps)
+{
+    for (const std::string& filename : filenames) {
+        prefetch(filename, mipmaps);
+    }
+}
+
+void TextureLoader::prefetchShared(const std::string& filename, bool dropAlpha)
+{
+    std::string path = Folders::getResourcePath(filename);
+    if (!path.empty()) {
+        pool.submit(path, false, true, dropAlpha);
+    }
+}
+
+bool TextureLoader::copy(const std::string& path, ImageRec& image)
+{
+    return pool.copy(path, image);
+}
+
+std::unique_ptr<MipChain> TextureLoader::take(const std::string& path)
+{
+    return pool.take(path);
+}
+
+void TextureLoader::runTask(std::function<void()> task)
+{
+    pool.submit(std::move(task));
+}
+
+void TextureLoader::queueUpload(const std::shared_ptr<TextureRes>& texture)
+{
+    pendingUploads.push_back(texture);
+}
+
+void TextureLoader::uploadPending(int maxUploads)
+{
+    int uploads = 0;
+    for (auto it = pendingUploads.begin(); it != pendingUploads.end() && uploads < maxUploads;) {
+        std::shared_ptr<TextureRes> texture = it->lock();
+        if (texture && !pool.isReady(texture->filename)) {
+            ++it;
+            continue;
+        }
+        if (texture) {
+            texture->load();
+            uploads++;
+        }
+        it = pendingUploads.erase(it);
+    }
+}
+
+void TextureLoader::finishPending()
+{
+    std::vector<std::weak_ptr<TextureRes>> pending;
+    pending.swap(pendingUploads);
+    for (const std::weak_ptr<TextureRes>& weakTexture : pending) {
+        std::shared_ptr<TextureRes> texture = weakTexture.lock();
+        if (texture) {
+            texture->load();
+        }
+    }
+}
+
+void TextureLoader::clear()
+{
+    pool.clear();
+}
@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _TEXTURE_LOADER_HPP_
+#define _TEXTURE_LOADER_HPP_
+
+#include "Graphic/MipChain.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ImageRec;
+class TextureRes;
+
+/* Decodes images on a small pool of worker threads.
+ *
+ * Workers only read files and fill MipChains, from the mip cache when they
+ * can, or parse files for runTask(). Everything touching GL stays on
+ * the main thread: TextureRes::load takes an already decoded image instead of
+ * decoding it itself, and textures created with Texture::loadAsync get
+ * uploaded by uploadPending() once their image is ready.
+ */
+class TextureLoader
+{
+public:
+    /* Queue decoding of an image, main thread only since it resolves the path.
+     * With mipmaps the workers build its whole mip chain as well. */
+    static void prefetch(const std::string& filename, bool mipmaps);
+    static void prefetch(const std::vector<std::string>& filenames, bool mipmaps);
+
+    /* Decoded image of a prefetched resolved path, waits for the workers if needed.
+     * Returns nullptr if the path was never prefetched or failed to decode. */
+    static std::unique_ptr<MipChain> take(const std::string& path);
+
+    /* Queue decoding of an image that several objects copy, like person skins and
+     * clothes. It stays decoded until clear() instead of going to the first taker. */
+    static void prefetchShared(const std::string& filename, bool dropAlpha);
+    /* Copy of a resolved path queued by prefetchShared, waits for the workers if needed.
+     * Returns false if the path was never queued that way or failed to decode. */
+    static bool copy(const std::string& path, ImageRec& image);
+
+    /* Run a task on the workers once the images queued before it got picked up,
+     * for reading files ahead. It must not touch GL or game state. */
+    static void runTask(std::function<void()> task);
+
+    static void queueUpload(const std::shared_ptr<TextureRes>& texture);
+    /* Upload textures whose image is ready, at most maxUploads of them */
+    static void uploadPending(int maxUploads);
+    /* Wait for all queued textures and upload them */
+    static void finishPending();
+
+    /* Forget decoded images nobody took, queued tasks still run */
+    static void clear();
+};
+
+#endif
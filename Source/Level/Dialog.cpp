@@ -22,6 +22,7 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Game.hpp"
 #include "Objects/Person.hpp"
+#include "Utils/BinaryReader.hpp"
 #include "Utils/Folders.hpp"
 #include "Utils/Input.hpp"
 #include "Utils/binio.h"
@@ -34,41 +35,38 @@ bool Dialog::directing;
 float Dialog::dialoguetime;
 std::vector<Dialog> Dialog::dialogs;
 
-void Dialog::loadDialogs(FILE* tfile)
+void Dialog::loadDialogs(BinaryReader& reader)
 {
-    int numdialogues;
-    funpackf(tfile, "Bi", &numdialogues);
+    int numdialogues = reader.read<int32_be>();
     for (int k = 0; k < numdialogues; k++) {
-        dialogs.push_back(Dialog(tfile));
+        dialogs.push_back(Dialog(reader));
     }
 }
 
-Dialog::Dialog(FILE* tfile)
+Dialog::Dialog(BinaryReader& reader)
     : gonethrough(0)
 {
-    int numdialogscenes;
-    funpackf(tfile, "Bi", &numdialogscenes);
-    funpackf(tfile, "Bi", &type);
+    int numdialogscenes = reader.read<int32_be>();
+    type = reader.read<int32_be>();
     for (int l = 0; l < 10; l++) {
-        funpackf(tfile, "Bf Bf Bf", &participantlocation[l].x, &participantlocation[l].y, &participantlocation[l].z);
-        funpackf(tfile, "Bf", &participantyaw[l]);
+        reader.read_array<float_be>(&participantlocation[l].x, 3);
+        participantyaw[l] = reader.read<float_be>();
     }
     for (int l = 0; l < numdialogscenes; l++) {
-        scenes.push_back(DialogScene(tfile));
+        scenes.push_back(DialogScene(reader));
     }
 }
 
-std::string funpackf_string(FILE* tfile, int maxlength)
+std::string read_string(BinaryReader& reader, int maxlength)
 {
-    int templength;
-    funpackf(tfile, "Bi", &templength);
+    int templength = reader.read<int32_be>();
     if ((templength > maxlength) || (templength <= 0)) {
         templength = maxlength;
     }
     int m;
     char* text = new char[maxlength];
     for (m = 0; m < templength; m++) {
-        funpackf(tfile, "Bb", &text[m]);
+        text[m] = reader.read<uint8_be>();
         if (text[m] == '\0') {
             break;
         }
@@ -90,26 +88,25 @@ void fpackf_string(FILE* tfile, std::string text)
     }
 }
 
-DialogScene::DialogScene(FILE* tfile)
+DialogScene::DialogScene(BinaryReader& reader)
 {
-    funpackf(tfile, "Bi", &location);
-    funpackf(tfile, "Bf", &color[0]);
-    funpackf(tfile, "Bf", &color[1]);
-    funpackf(tfile, "Bf", &color[2]);
-    funpackf(tfile, "Bi", &sound);
+    location = reader.read<int32_be>();
+    reader.read_array<float_be>(color, 3);
+    sound = reader.read<int32_be>();
 
-    text = funpackf_string(tfile, 128);
-    name = funpackf_string(tfile, 64);
+    text = read_string(reader, 128);
+    name = read_string(reader, 64);
 
-    funpackf(tfile, "Bf Bf Bf", &camera.x, &camera.y, &camera.z);
-    funpackf(tfile, "Bi", &participantfocus);
-    funpackf(tfile, "Bi", &participantaction);
+    reader.read_array<float_be>(&camera.x, 3);
+    participantfocus = reader.read<int32_be>();
+    participantaction = reader.read<int32_be>();
 
     for (int m = 0; m < 10; m++) {
-        funpackf(tfile, "Bf Bf Bf", &participantfacing[m].x, &participantfacing[m].y, &participantfacing[m].z);
+        reader.read_array<float_be>(&participantfacing[m].x, 3);
     }
 
-    funpackf(tfile, "Bf Bf", &camerayaw, &camerapitch);
+    camerayaw = reader.read<float_be>();
+    camerapitch = reader.read<float_be>();
 }
 
 /* Load dialog from txt file, used by console */
@@ -26,10 +26,12 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <vector>
 
+class BinaryReader;
+
 class DialogScene
 {
 public:
-    DialogScene(FILE* tfile);
+    DialogScene(BinaryReader& reader);
     DialogScene(ifstream& ipstream);
     void save(FILE* tfile);
 
@@ -49,7 +51,7 @@ public:
 class Dialog
 {
 public:
-    Dialog(FILE* tfile);
+    Dialog(BinaryReader& reader);
     Dialog(int type, std::string filename);
     void tick(int id);
     void play();
@@ -61,7 +63,7 @@ public:
     XYZ participantlocation[10];
     float participantyaw[10];
 
-    static void loadDialogs(FILE*);
+    static void loadDialogs(BinaryReader&);
     static void saveDialogs(FILE*);
 
     static bool inDialog() { return (indialogue != -1); }
@@ -0,0 +1,119 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Level/LevelSnapshot.hpp"
+
+#include "Environment/Terrain.hpp"
+#include "Objects/Person.hpp"
+#include "Utils/Folders.hpp"
+
+#include <cstring>
+
+extern Terrain terrain;
+
+std::unique_ptr<LevelSnapshot> LevelSnapshot::current;
+
+LevelSnapshot* LevelSnapshot::find(const std::string& path, bool tutorial)
+{
+    if (!current || current->path != path || current->tutorial != tutorial || current->generation != Folders::getResourceGeneration()) {
+        return nullptr;
+    }
+    uint64_t size;
+    int64_t mtime;
+    if (!Folders::getResourceStamp(path, &size, &mtime) || size != current->size || mtime != current->mtime) {
+        clear();
+        return nullptr;
+    }
+    return current.get();
+}
+
+void LevelSnapshot::capture(const std::string& path, bool tutorial, BinaryReader& map)
+{
+    std::unique_ptr<LevelSnapshot> snapshot(new LevelSnapshot());
+    snapshot->path = path;
+    snapshot->tutorial = tutorial;
+    snapshot->generation = Folders::getResourceGeneration();
+    if (!Folders::getResourceStamp(path, &snapshot->size, &snapshot->mtime)) {
+        clear();
+        return;
+    }
+    snapshot->map.swap(map);
+
+    snapshot->objects.reserve(Object::objects.size());
+    for (const std::unique_ptr<Object>& object : Object::objects) {
+        snapshot->objects.push_back(*object);
+    }
+
+    const float* colors = &terrain.colors[0][0][0];
+    snapshot->terrainColors.assign(colors, colors + sizeof(terrain.colors) / sizeof(float));
+
+    snapshot->skins.resize(Person::players.size());
+    for (unsigned i = 0; i < Person::players.size(); i++) {
+        const Person& person = *Person::players[i];
+        Skin& skin = snapshot->skins[i];
+        skin.creature = person.creature;
+        skin.whichskin = person.whichskin;
+        skin.numclothes = person.numclothes;
+        skin.texture = person.skeleton.drawmodel.textureptr;
+        skin.image = person.skeleton.skin;
+    }
+
+    current = std::move(snapshot);
+}
+
+void LevelSnapshot::clear()
+{
+    current.reset();
+}
+
+void LevelSnapshot::restoreObjects() const
+{
+    Object::objects.clear();
+    for (const Object& object : objects) {
+        Object::objects.emplace_back(new Object(object));
+    }
+}
+
+void LevelSnapshot::restoreTerrain() const
+{
+    memcpy(&terrain.colors[0][0][0], terrainColors.data(), terrainColors.size() * sizeof(float));
+    for (int i = 0; i < subdivision; i++) {
+        for (int j = 0; j < subdivision; j++) {
+            terrain.UpdateVertexArray(i, j);
+        }
+    }
+}
+
+bool LevelSnapshot::hasSkin(unsigned index, const Person& person) const
+{
+    if (index >= skins.size()) {
+        return false;
+    }
+    const Skin& skin = skins[index];
+    return skin.creature == person.creature && skin.whichskin == person.whichskin && skin.numclothes == person.numclothes && skin.texture.isLoaded() && skin.image.isLoaded();
+}
+
+void LevelSnapshot::restoreSkin(unsigned index, Person& person) const
+{
+    const Skin& skin = skins[index];
+    person.skeleton.drawmodel.textureptr = skin.texture;
+    person.skeleton.skin = skin.image;
+    person.DoMipmaps();
+}
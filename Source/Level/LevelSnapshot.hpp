@@ -0,0 +1,87 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _LEVEL_SNAPSHOT_HPP_
+#define _LEVEL_SNAPSHOT_HPP_
+
+#include "Graphic/SkinTexture.hpp"
+#include "Graphic/Texture.hpp"
+#include "Objects/Object.hpp"
+#include "Utils/BinaryReader.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Person;
+
+/* The last loaded level as it was right after LoadLevel, so restarting it
+ * skips the slow parts.
+ *
+ * It keeps the map itself, the objects and terrain colors once shadows are
+ * cast, and every person's skin with its clothes blended in. Persons, weapons,
+ * hotspots and dialogs are parsed again from the map, which takes no time.
+ * Editing the map file or changing packs and mods invalidates it.
+ */
+class LevelSnapshot
+{
+public:
+    /* Snapshot of the level at path if it still matches the file, nullptr otherwise */
+    static LevelSnapshot* find(const std::string& path, bool tutorial);
+    /* Replace the snapshot with the level LoadLevel just finished, taking over its map */
+    static void capture(const std::string& path, bool tutorial, BinaryReader& map);
+    static void clear();
+
+    /* Map bytes, LoadLevel swaps them in and hands them back once done */
+    BinaryReader map;
+
+    void restoreObjects() const;
+    /* Terrain colors with object shadows, only after the objects were added to the terrain */
+    void restoreTerrain() const;
+    /* Whether person number index still wears the skin and clothes it had */
+    bool hasSkin(unsigned index, const Person& person) const;
+    /* Reuse the skin texture and upload the unharmed skin, after skeletonLoad without skin */
+    void restoreSkin(unsigned index, Person& person) const;
+
+private:
+    struct Skin
+    {
+        int creature;
+        int whichskin;
+        int numclothes;
+        Texture texture;
+        SkinTexture image;
+    };
+
+    std::string path;
+    bool tutorial;
+    uint64_t size;
+    int64_t mtime;
+    unsigned generation;
+
+    std::vector<Object> objects;
+    std::vector<float> terrainColors;
+    std::vector<Skin> skins;
+
+    static std::unique_ptr<LevelSnapshot> current;
+};
+
+#endif
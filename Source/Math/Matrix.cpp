@@ -0,0 +1,84 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Math/Matrix.hpp"
+
+Matrix4::Matrix4()
+{
+    identity();
+}
+
+void Matrix4::identity()
+{
+    for (int i = 0; i < 16; i++) {
+        m[i] = (i % 5 == 0) ? 1 : 0;
+    }
+}
+
+/* Same rotation matrix as glRotatef, see the OpenGL 2.1 reference */
+void Matrix4::rotate(float angle, float x, float y, float z)
+{
+    float length = sqrtf(x * x + y * y + z * z);
+    if (length == 0) {
+        return;
+    }
+    x /= length;
+    y /= length;
+    z /= length;
+
+    float radians = angle * (float)M_PI / 180;
+    float s = sinf(radians);
+    float c = cosf(radians);
+    float t = 1 - c;
+
+    Matrix4 rotation;
+    rotation.m[0] = x * x * t + c;
+    rotation.m[1] = y * x * t + z * s;
+    rotation.m[2] = x * z * t - y * s;
+    rotation.m[4] = x * y * t - z * s;
+    rotation.m[5] = y * y * t + c;
+    rotation.m[6] = y * z * t + x * s;
+    rotation.m[8] = x * z * t + y * s;
+    rotation.m[9] = y * z * t - x * s;
+    rotation.m[10] = z * z * t + c;
+
+    *this = *this * rotation;
+}
+
+void Matrix4::translate(float x, float y, float z)
+{
+    for (int i = 0; i < 4; i++) {
+        m[12 + i] += m[i] * x + m[4 + i] * y + m[8 + i] * z;
+    }
+}
+
+Matrix4 Matrix4::operator*(const Matrix4& other) const
+{
+    Matrix4 result;
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            result.m[col * 4 + row] = m[row] * other.m[col * 4] +
+                                      m[4 + row] * other.m[col * 4 + 1] +
+                                      m[8 + row] * other.m[col * 4 + 2] +
+                                      m[12 + row] * other.m[col * 4 + 3];
+        }
+    }
+    return result;
+}
@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _MATRIX_HPP_
+#define _MATRIX_HPP_
+
+#include "Math/XYZ.hpp"
+
+/* 4x4 matrix laid out column-major like OpenGL's, so m[12], m[13], m[14] hold
+ * the translation. rotate() and translate() post-multiply the way glRotatef
+ * and glTranslatef do on the current matrix, which lets code that used the
+ * fixed-function stack purely for math run without a GL context.
+ */
+class Matrix4
+{
+public:
+    float m[16];
+
+    Matrix4();
+
+    void identity();
+
+    /* angle in degrees around axis (x, y, z), which doesn't need to be normalised */
+    void rotate(float angle, float x, float y, float z);
+    void translate(float x, float y, float z);
+    void translate(const XYZ& v) { translate(v.x, v.y, v.z); }
+
+    Matrix4 operator*(const Matrix4& other) const;
+
+    /* Transform point, this is the translation part of this * translate(point) */
+    inline XYZ transformPoint(const XYZ& point) const;
+    /* Transform direction, ignoring the translation */
+    inline XYZ transformVector(const XYZ& vector) const;
+};
+
+inline XYZ Matrix4::transformPoint(const XYZ& point) const
+{
+    XYZ result;
+    result.x = m[0] * point.x + m[4] * point.y + m[8] * point.z + m[12];
+    result.y = m[1] * point.x + m[5] * point.y + m[9] * point.z + m[13];
+    result.z = m[2] * point.x + m[6] * point.y + m[10] * point.z + m[14];
+    return result;
+}
+
+inline XYZ Matrix4::transformVector(const XYZ& vector) const
+{
+    XYZ result;
+    result.x = m[0] * vector.x + m[4] * vector.y + m[8] * vector.z;
+    result.y = m[1] * vector.x + m[5] * vector.y + m[9] * vector.z;
+    result.z = m[2] * vector.x + m[6] * vector.y + m[10] * vector.z;
+    return result;
+}
+
+#endif
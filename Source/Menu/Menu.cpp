@@ -657,7 +657,7 @@ void Menu::drawModMenu() {
 
         // Draw the mod's `pack.png` on the left
         Texture modTexture;
-        modTexture.load(modInfo.folderName + "/pack.png", 0);
+        modTexture.loadAsync(modInfo.folderName + "/pack.png", 0);
         addImage(1000 + i, modTexture, leftBoxX + cardPadding, yPos + (packIconSize / 2) - (cardPadding * 2), packIconSize, packIconSize, 1.0f, 1.0f, 1.0f);
 
         // Draw the mod name next to the image
@@ -721,6 +721,7 @@ void Menu::applyModChanges() {
         packListFile << packListJson.dump(4);  // Pretty-print with 4 spaces
         packListFile.close();
         std::cout << "Mod changes saved to PackList.json." << std::endl;
+        Folders::invalidateResourceIndex();
     } else {
         std::cerr << "Unable to open PackList.json for writing." << std::endl;
     }
@@ -856,6 +857,15 @@ void Menu::Load()
                             campaignlevels[i].getStartY() - 4);
             }
         }
+
+        // Start decoding the textures of the levels that can be picked next
+        if (numLevelsCompleted > 0) {
+            for (int next : campaignlevels[numLevelsCompleted - 1].nextlevel) {
+                PrefetchLevel(campaignlevels[next].mapname);
+            }
+        } else if (!campaignlevels.empty()) {
+            PrefetchLevel(campaignlevels[0].mapname);
+        }
     } 
     break;
         case 6:
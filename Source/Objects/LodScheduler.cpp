@@ -0,0 +1,131 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Objects/LodScheduler.hpp"
+
+#include "Objects/Person.hpp"
+
+#include <algorithm>
+
+extern int detail;
+extern XYZ viewer;
+extern float screenheight;
+
+float LodScheduler::budget = 0;
+LodScheduler::Stats LodScheduler::stats = {};
+float LodScheduler::unitTime = 0;
+
+// Skinning cost per frame of each tier, a high model skinned once being 1
+static const float tierCost[lod_tier_count] = { 1, .5, .25, 0 };
+// The low model is a fraction of the high one
+static const float lowModelCost = .5;
+
+float LodScheduler::getScreenSize(const Person& person)
+{
+    // Persons stand about 6 scales tall, and the view spans 90 degrees vertically
+    XYZ coords = person.coords;
+    const float distance = std::max(findDistance(&viewer, &coords), .01f);
+    return person.scale * 6 / distance * screenheight / 2;
+}
+
+lod_tier LodScheduler::getTier(const Person& person, float size)
+{
+    if (person.id == 0 || person.skeleton.free == 3) {
+        return lod_full;
+    }
+
+    // Lower detail settings keep the low model up to larger sizes
+    float highSize = 72;
+    if (detail == 2) {
+        highSize = 24;
+    } else if (detail == 1) {
+        highSize = 48;
+    }
+    if (size < highSize) {
+        return lod_low;
+    }
+    // Ragdolls move too fast to skip frames
+    if (size < highSize * 2 && person.skeleton.free != 1) {
+        return lod_half;
+    }
+    return lod_full;
+}
+
+void LodScheduler::schedule(const std::vector<Person*>& persons)
+{
+    struct Candidate
+    {
+        Person* person;
+        float size;
+    };
+    std::vector<Candidate> candidates;
+    float cost = 0;
+    for (Person* person : persons) {
+        const float size = getScreenSize(*person);
+        const lod_tier tier = getTier(*person, size);
+        person->setLodTier(tier);
+        cost += tierCost[tier];
+        if (person->id != 0 && person->skeleton.free != 3) {
+            candidates.push_back(Candidate{ person, size });
+        }
+    }
+
+    // One tier down for everybody, smallest first, then again, until the estimate fits
+    stats.demoted = 0;
+    if (budget > 0 && unitTime > 0) {
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.size < b.size; });
+        for (int round = 0; round < lod_frozen && cost * unitTime > budget; round++) {
+            for (unsigned i = 0; i < candidates.size() && cost * unitTime > budget; i++) {
+                Person& person = *candidates[i].person;
+                if (person.lodTier == lod_frozen) {
+                    continue;
+                }
+                const lod_tier tier = lod_tier(person.lodTier + 1);
+                cost += tierCost[tier] - tierCost[person.lodTier];
+                person.setLodTier(tier);
+                stats.demoted++;
+            }
+        }
+    }
+
+    std::fill(stats.tiers, stats.tiers + lod_tier_count, 0);
+    for (Person* person : persons) {
+        stats.tiers[person->lodTier]++;
+    }
+}
+
+void LodScheduler::schedule(Person& person)
+{
+    person.setLodTier(getTier(person, getScreenSize(person)));
+}
+
+void LodScheduler::measure(const std::vector<Person*>& skinned, float microseconds)
+{
+    stats.skinningTime = microseconds;
+
+    float units = 0;
+    for (Person* person : skinned) {
+        units += (person->playerdetail || person->skeleton.free == 3) ? 1 : lowModelCost;
+    }
+    if (units > 0) {
+        const float sample = microseconds / units;
+        unitTime = (unitTime > 0) ? unitTime * .9f + sample * .1f : sample;
+    }
+}
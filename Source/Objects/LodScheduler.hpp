@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _LOD_SCHEDULER_HPP_
+#define _LOD_SCHEDULER_HPP_
+
+#include <vector>
+
+class Person;
+
+enum lod_tier
+{
+    lod_full,   // high model skinned every frame
+    lod_half,   // high model skinned every other frame
+    lod_low,    // low model skinned at a rate falling off with distance
+    lod_frozen, // last skinned pose drawn again
+    lod_tier_count
+};
+
+/* Picks how often, and which model of, every drawn person gets skinned.
+ *
+ * Tiers follow the height a person takes on screen. Persons hidden by scenery
+ * aren't drawn and never get here. With a budget, the smallest persons on
+ * screen step down further, as far as frozen, until the skinning time
+ * expected from the last frames fits in it.
+ * The player and edited ragdolls always stay at full rate.
+ */
+class LodScheduler
+{
+public:
+    struct Stats
+    {
+        unsigned tiers[lod_tier_count];
+        /* Persons stepped down a tier to fit the budget */
+        unsigned demoted;
+        /* Wall time of the last skinning pass, in microseconds */
+        float skinningTime;
+    };
+
+    /* Skinning time allowed per frame in microseconds, 0 for no limit */
+    static float budget;
+
+    /* Assign a tier to every person about to be drawn */
+    static void schedule(const std::vector<Person*>& persons);
+    /* Assign a tier to one person drawn outside the scheduled batch, the budget left alone */
+    static void schedule(Person& person);
+    /* Learn what skinning the given persons cost */
+    static void measure(const std::vector<Person*>& skinned, float microseconds);
+
+    static const Stats& getStats() { return stats; }
+
+private:
+    static Stats stats;
+    /* Running average of the time one high model takes to skin */
+    static float unitTime;
+
+    /* Height in pixels */
+    static float getScreenSize(const Person& person);
+    static lod_tier getTier(const Person& person, float size);
+};
+
+#endif
@@ -20,6 +20,9 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Objects/Object.hpp"
 
+#include "Game.hpp"
+#include "Utils/BinaryReader.hpp"
+
 extern XYZ viewer;
 extern float viewdistance;
 extern float fadestart;
@@ -551,26 +554,32 @@ void Object::ComputeRadius()
     radius = fast_sqrt(maxdistance);
 }
 
-void Object::LoadObjectsFromFile(FILE* tfile, bool skip)
+void Object::LoadObjectsFromFile(BinaryReader& reader, bool skip)
 {
     int numobjects;
     int type;
     XYZ position;
     float yaw, pitch, scale;
     float lastscale = 1.0f;
-    funpackf(tfile, "Bi", &numobjects);
-    if (!skip) {
-        objects.clear();
+    numobjects = reader.read<int32_be>();
+    if (skip) {
+        // type, yaw, pitch, position and scale
+        reader.skip(std::max(numobjects, 0) * 7 * sizeof(int));
+        return;
     }
+    objects.clear();
     for (int i = 0; i < numobjects; i++) {
-        funpackf(tfile, "Bi Bf Bf Bf Bf Bf Bf", &type, &yaw, &pitch, &position.x, &position.y, &position.z, &scale);
-        if (!skip) {
-            if (type == treeleavestype) {
-                scale = lastscale;
-            }
-            objects.emplace_back(new Object(object_type(type), position, yaw, pitch, scale));
-            lastscale = scale;
+        type = reader.read<int32_be>();
+        yaw = reader.read<float_be>();
+        pitch = reader.read<float_be>();
+        reader.read_array<float_be>(&position.x, 3);
+        scale = reader.read<float_be>();
+        if (type == treeleavestype) {
+            scale = lastscale;
         }
+        Game::LoadingScreen();
+        objects.emplace_back(new Object(object_type(type), position, yaw, pitch, scale));
+        lastscale = scale;
     }
 }
 
@@ -33,6 +33,8 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <memory>
 #include <vector>
+
+class BinaryReader;
 //
 // Model Structures
 //
@@ -93,7 +95,7 @@ public:
     static void ComputeCenter();
     static void ComputeRadius();
     static void AddObjectsToTerrain();
-    static void LoadObjectsFromFile(FILE* tfile, bool skip);
+    static void LoadObjectsFromFile(BinaryReader& reader, bool skip);
     static void SphereCheckPossible(XYZ* p1, float radius);
     static void DeleteObject(int which);
     static void MakeObject(int atype, XYZ where, float ayaw, float apitch, float ascale);
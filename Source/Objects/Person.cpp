@@ -21,13 +21,19 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Objects/Person.hpp"
 
 #include "Animation/Animation.hpp"
+#include "Animation/Skinning.hpp"
 #include "Audio/Sounds.hpp"
 #include "Audio/openal_wrapper.hpp"
 #include "Game.hpp"
+#include "Graphic/TextureLoader.hpp"
 #include "Level/Awards.hpp"
 #include "Level/Dialog.hpp"
 #include "Tutorial.hpp"
+#include "Utils/BinaryReader.hpp"
 #include "Utils/Folders.hpp"
+#include "Utils/WorkerPool.hpp"
+
+#include <chrono>
 
 extern float multiplier;
 extern Terrain terrain;
@@ -50,6 +56,7 @@ extern float viewdistance;
 extern float blackout;
 extern int difficulty;
 extern bool decalstoggle;
+extern bool gpuskinning;
 extern float fadestart;
 extern bool freeze;
 extern bool winfreeze;
@@ -179,6 +186,10 @@ Person::Person()
 
     updatedelay(0)
     , normalsupdatedelay(0)
+    , skinPending(false)
+    , skeletonPrepared(false)
+    , skeletonVisible(false)
+    , lodTier(lod_full)
     ,
 
     jumpstart(false)
@@ -356,29 +367,32 @@ Person::Person()
     setProportions(1, 1, 1, 1);
 }
 
-/* Read a person in tfile. Throws an error if it’s not valid */
-Person::Person(FILE* tfile, int mapvers, unsigned i)
+/* Read a person from a map file. Throws an error if it’s not valid */
+Person::Person(BinaryReader& reader, int mapvers, unsigned i)
     : Person()
 {
     id = i;
-    funpackf(tfile, "Bi Bi Bf Bf Bf Bi", &whichskin, &creature, &coords.x, &coords.y, &coords.z, &num_weapons);
+    whichskin = reader.read<int32_be>();
+    creature = reader.read<int32_be>();
+    reader.read_array<float_be>(&coords.x, 3);
+    num_weapons = reader.read<int32_be>();
     if (mapvers >= 5) {
-        funpackf(tfile, "Bi", &howactive);
+        howactive = reader.read<int32_be>();
     } else {
         howactive = typeactive;
     }
     if (mapvers >= 3) {
-        funpackf(tfile, "Bf", &scale);
+        scale = reader.read<float_be>();
     } else {
         scale = -1;
     }
     if (mapvers >= 11) {
-        funpackf(tfile, "Bb", &immobile);
+        immobile = reader.read<uint8_be>();
     } else {
         immobile = 0;
     }
     if (mapvers >= 12) {
-        funpackf(tfile, "Bf", &yaw);
+        yaw = reader.read<float_be>();
     } else {
         yaw = 0;
     }
@@ -389,48 +403,53 @@ Person::Person(FILE* tfile, int mapvers, unsigned i)
     if (num_weapons > 0 && num_weapons < 5) {
         for (int j = 0; j < num_weapons; j++) {
             weaponids[j] = weapons.size();
-            int type;
-            funpackf(tfile, "Bi", &type);
+            int type = reader.read<int32_be>();
             weapons.push_back(Weapon(type, id));
         }
     }
-    funpackf(tfile, "Bi", &numwaypoints);
+    numwaypoints = reader.read<int32_be>();
     for (int j = 0; j < numwaypoints; j++) {
-        funpackf(tfile, "Bf", &waypoints[j].x);
-        funpackf(tfile, "Bf", &waypoints[j].y);
-        funpackf(tfile, "Bf", &waypoints[j].z);
+        reader.read_array<float_be>(&waypoints[j].x, 3);
         if (mapvers >= 5) {
-            funpackf(tfile, "Bi", &waypointtype[j]);
+            waypointtype[j] = reader.read<int32_be>();
         } else {
             waypointtype[j] = wpkeepwalking;
         }
     }
 
-    funpackf(tfile, "Bi", &waypoint);
+    waypoint = reader.read<int32_be>();
     if (waypoint > (numwaypoints - 1)) {
         waypoint = 0;
     }
 
-    funpackf(tfile, "Bf Bf Bf", &armorhead, &armorhigh, &armorlow);
-    funpackf(tfile, "Bf Bf Bf", &protectionhead, &protectionhigh, &protectionlow);
-    funpackf(tfile, "Bf Bf Bf", &metalhead, &metalhigh, &metallow);
-    funpackf(tfile, "Bf Bf", &power, &speedmult);
+    armorhead = reader.read<float_be>();
+    armorhigh = reader.read<float_be>();
+    armorlow = reader.read<float_be>();
+    protectionhead = reader.read<float_be>();
+    protectionhigh = reader.read<float_be>();
+    protectionlow = reader.read<float_be>();
+    metalhead = reader.read<float_be>();
+    metalhigh = reader.read<float_be>();
+    metallow = reader.read<float_be>();
+    power = reader.read<float_be>();
+    speedmult = reader.read<float_be>();
 
     if (mapvers >= 4) {
-        funpackf(tfile, "Bf Bf Bf Bf", &proportions[0], &proportions[1], &proportions[2], &proportions[3]);
+        reader.read_array<float_be>(proportions, 4);
     } else {
         setProportions(1, 1, 1, 1);
     }
 
-    funpackf(tfile, "Bi", &numclothes);
+    numclothes = reader.read<int32_be>();
     for (int k = 0; k < numclothes; k++) {
-        int templength;
-        funpackf(tfile, "Bi", &templength);
-        for (int l = 0; l < templength; l++) {
-            funpackf(tfile, "Bb", &clothes[k][l]);
+        int templength = reader.read<int32_be>();
+        if (templength > 0) {
+            reader.read_array<uint8_be>((unsigned char*)clothes[k], templength);
         }
         clothes[k][templength] = '\0';
-        funpackf(tfile, "Bf Bf Bf", &clothestintr[k], &clothestintg[k], &clothestintb[k]);
+        clothestintr[k] = reader.read<float_be>();
+        clothestintg[k] = reader.read<float_be>();
+        clothestintb[k] = reader.read<float_be>();
     }
 
     loaded = true;
@@ -451,7 +470,7 @@ Person::Person(FILE* tfile, int mapvers, unsigned i)
     realoldcoords = coords;
 }
 
-void Person::skeletonLoad(bool clothes)
+void Person::skeletonLoad(bool clothes, bool skin)
 {
     skeleton.id = id;
     skeleton.Load(
@@ -469,7 +488,9 @@ void Person::skeletonLoad(bool clothes)
         PersonType::types[creature].modelClothesFileName,
         clothes);
 
-    skeleton.drawmodel.textureptr.load(PersonType::types[creature].skins[whichskin], 1, &skeleton.skinText[0], &skeleton.skinsize);
+    if (skin) {
+        loadSkin(PersonType::types[creature].skins[whichskin]);
+    }
 }
 
 void Person::setProportions(float head, float body, float arms, float legs)
@@ -937,22 +958,21 @@ void Person::DoBloodBig(float howmuch, int which)
         endy /= realtexdetail;
 
         int texdetailint = realtexdetail;
-        int where;
         for (i = startx; i < endx; i++) {
             for (j = starty; j < endy; j++) {
                 if (PersonType::types[creature].bloodText[(i * texdetailint - offsetx) * 512 * 3 + (j * texdetailint - offsety) * 3 + 0] <= which + 4 && PersonType::types[creature].bloodText[(i * texdetailint - offsetx) * 512 * 3 + (j * texdetailint - offsety) * 3 + 0] >= which - 4) {
                     color = Random() % 85 + 170;
-                    where = i * skeleton.skinsize * 3 + j * 3;
-                    if (skeleton.skinText[where + 0] > color / 2) {
-                        skeleton.skinText[where + 0] = color / 2;
+                    GLubyte* texel = skeleton.skin.paint(i, j);
+                    if (texel != nullptr) {
+                        if (texel[0] > color / 2) {
+                            texel[0] = color / 2;
+                        }
+                        texel[1] = 0;
+                        texel[2] = 0;
                     }
-                    skeleton.skinText[where + 1] = 0;
-                    skeleton.skinText[where + 2] = 0;
                 }
             }
         }
-        skeleton.drawmodel.textureptr.bind();
-        DoMipmaps();
 
         bleedxint = 0;
         bleedyint = 0;
@@ -970,11 +990,11 @@ void Person::DoBloodBig(float howmuch, int which)
         if (bleedy < 0) {
             bleedy = 0;
         }
-        if (bleedx > skeleton.skinsize - 1) {
-            bleedx = skeleton.skinsize - 1;
+        if (bleedx > skeleton.skin.getSize() - 1) {
+            bleedx = skeleton.skin.getSize() - 1;
         }
-        if (bleedy > skeleton.skinsize - 1) {
-            bleedy = skeleton.skinsize - 1;
+        if (bleedy > skeleton.skin.getSize() - 1) {
+            bleedy = skeleton.skin.getSize() - 1;
         }
         direction = abs(Random() % 2) * 2 - 1;
     }
@@ -1025,6 +1045,7 @@ bool Person::DoBloodBigWhere(float howmuch, int which, XYZ where)
         movepoint = 0;
         rotationpoint = 0;
         // ray testing for a tri in the character model
+        skeleton.syncDrawModel();
         whichtri = skeleton.drawmodel.LineCheck(&startpoint, &endpoint, &colpoint, &movepoint, &rotationpoint);
         if (whichtri != -1) {
             // low level geometry math
@@ -1140,30 +1161,31 @@ bool Person::DoBloodBigWhere(float howmuch, int which, XYZ where)
             endy /= realtexdetail;
 
             int texdetailint = realtexdetail;
-            int where;
             for (i = startx; i < endx; i++) {
                 for (j = starty; j < endy; j++) {
                     if (PersonType::types[creature].bloodText[(i * texdetailint - offsetx) * 512 * 3 + (j * texdetailint - offsety) * 3 + 0] <= which + 4 && PersonType::types[creature].bloodText[(i * texdetailint - offsetx) * 512 * 3 + (j * texdetailint - offsety) * 3 + 0] >= which - 4) {
                         color = Random() % 85 + 170;
-                        where = i * skeleton.skinsize * 3 + j * 3;
-                        if (skeleton.skinText[where + 0] > color / 2) {
-                            skeleton.skinText[where + 0] = color / 2;
+                        GLubyte* texel = skeleton.skin.paint(i, j);
+                        if (texel != nullptr) {
+                            if (texel[0] > color / 2) {
+                                texel[0] = color / 2;
+                            }
+                            texel[1] = 0;
+                            texel[2] = 0;
                         }
-                        skeleton.skinText[where + 1] = 0;
-                        skeleton.skinText[where + 2] = 0;
                     } else if (PersonType::types[creature].bloodText[(i * texdetailint - offsetx) * 512 * 3 + (j * texdetailint - offsety) * 3 + 0] <= 160 + 4 && PersonType::types[creature].bloodText[(i * texdetailint - offsetx) * 512 * 3 + (j * texdetailint - offsety) * 3 + 0] >= 160 - 4) {
                         color = Random() % 85 + 170;
-                        where = i * skeleton.skinsize * 3 + j * 3;
-                        if (skeleton.skinText[where + 0] > color / 2) {
-                            skeleton.skinText[where + 0] = color / 2;
+                        GLubyte* texel = skeleton.skin.paint(i, j);
+                        if (texel != nullptr) {
+                            if (texel[0] > color / 2) {
+                                texel[0] = color / 2;
+                            }
+                            texel[1] = 0;
+                            texel[2] = 0;
                         }
-                        skeleton.skinText[where + 1] = 0;
-                        skeleton.skinText[where + 2] = 0;
                     }
                 }
             }
-            skeleton.drawmodel.textureptr.bind();
-            DoMipmaps();
 
             bleedy = (1 + coordsy) * 512;
             bleedx = coordsx * 512;
@@ -1175,11 +1197,11 @@ bool Person::DoBloodBigWhere(float howmuch, int which, XYZ where)
             if (bleedy < 0) {
                 bleedy = 0;
             }
-            if (bleedx > skeleton.skinsize - 1) {
-                bleedx = skeleton.skinsize - 1;
+            if (bleedx > skeleton.skin.getSize() - 1) {
+                bleedx = skeleton.skin.getSize() - 1;
             }
-            if (bleedy > skeleton.skinsize - 1) {
-                bleedy = skeleton.skinsize - 1;
+            if (bleedy > skeleton.skin.getSize() - 1) {
+                bleedy = skeleton.skin.getSize() - 1;
             }
             direction = abs(Random() % 2) * 2 - 1;
         }
@@ -2795,6 +2817,7 @@ void Person::DoAnimations()
                             }
                             movepoint = 0;
                             rotationpoint = 0;
+                            victim->skeleton.syncDrawModel();
                             whichtri = victim->skeleton.drawmodel.LineCheck(&startpoint, &endpoint, &colpoint, &movepoint, &rotationpoint);
 
                             if (whichtri != -1) {
@@ -2864,6 +2887,7 @@ void Person::DoAnimations()
 
                             movepoint = 0;
                             rotationpoint = 0;
+                            victim->skeleton.syncDrawModel();
                             whichtri = victim->skeleton.drawmodel.LineCheck(&startpoint, &endpoint, &footpoint, &movepoint, &rotationpoint);
                             footpoint += victim->coords;
 
@@ -2891,6 +2915,7 @@ void Person::DoAnimations()
 
                             movepoint = 0;
                             rotationpoint = 0;
+                            victim->skeleton.syncDrawModel();
                             whichtri = victim->skeleton.drawmodel.LineCheck(&startpoint, &endpoint, &footpoint, &movepoint, &rotationpoint);
                             footpoint += victim->coords;
 
@@ -4412,8 +4437,9 @@ void Person::DoAnimations()
 
             if (animCurrent != oldanimCurrent || animTarget != oldanimTarget || ((frameCurrent != oldframeCurrent || frameTarget != oldframeTarget) && !calcrot)) {
                 //Old rotates
+                AnimationFrame current = currentFrame();
                 for (unsigned i = 0; i < skeleton.joints.size(); i++) {
-                    skeleton.joints[i].position = currentFrame().joints[i].position;
+                    skeleton.joints[i].position = current.joints[i].position;
                 }
 
                 skeleton.FindForwards();
@@ -4438,8 +4464,9 @@ void Person::DoAnimations()
                 }
 
                 //New rotates
+                AnimationFrame next = targetFrame();
                 for (unsigned i = 0; i < skeleton.joints.size(); i++) {
-                    skeleton.joints[i].position = targetFrame().joints[i].position;
+                    skeleton.joints[i].position = next.joints[i].position;
                 }
 
                 skeleton.FindForwards();
@@ -4487,9 +4514,11 @@ void Person::DoAnimations()
             oldframeTarget = frameTarget;
             oldframeCurrent = frameCurrent;
 
+            const Pose& blended = getPose();
             for (unsigned i = 0; i < skeleton.joints.size(); i++) {
-                skeleton.joints[i].velocity = (currentFrame().joints[i].position * (1 - target) + targetFrame().joints[i].position * target - skeleton.joints[i].position) / multiplier;
-                skeleton.joints[i].position = currentFrame().joints[i].position * (1 - target) + targetFrame().joints[i].position * target;
+                XYZ position = blended.getPosition(i);
+                skeleton.joints[i].velocity = (position - skeleton.joints[i].position) / multiplier;
+                skeleton.joints[i].position = position;
             }
             offset = currentoffset * (1 - target) + targetoffset * target;
             for (unsigned i = 0; i < skeleton.muscles.size(); i++) {
@@ -4655,12 +4684,6 @@ void Person::DoStuff()
 
     if (bleeding > 0) {
         bleeding -= multiplier * .3;
-        if (bloodtoggle == 2) {
-            skeleton.drawmodel.textureptr.bind();
-            if ((bleeding <= 0) && (detail != 2)) {
-                DoMipmaps();
-            }
-        }
     }
 
     if (neckspurtamount > 0) {
@@ -4758,8 +4781,8 @@ void Person::DoStuff()
 
         startx = 0;
         starty = 0;
-        startx = bleedy; //abs(Random()%(skeleton.skinsize-bloodsize-1));
-        starty = bleedx; //abs(Random()%(skeleton.skinsize-bloodsize-1));
+        startx = bleedy; //abs(Random()%(skeleton.skin.getSize()-bloodsize-1));
+        starty = bleedx; //abs(Random()%(skeleton.skin.getSize()-bloodsize-1));
         endx = startx + bloodsize;
         endy = starty + bloodsize;
 
@@ -4771,12 +4794,12 @@ void Person::DoStuff()
             starty = 0;
             bleeding = 0;
         }
-        if (endx > skeleton.skinsize - 1) {
-            endx = skeleton.skinsize - 1;
+        if (endx > skeleton.skin.getSize() - 1) {
+            endx = skeleton.skin.getSize() - 1;
             bleeding = 0;
         }
-        if (endy > skeleton.skinsize - 1) {
-            endy = skeleton.skinsize - 1;
+        if (endy > skeleton.skin.getSize() - 1) {
+            endy = skeleton.skin.getSize() - 1;
             bleeding = 0;
         }
         if (endx < startx) {
@@ -4790,18 +4813,17 @@ void Person::DoStuff()
             for (int j = starty; j < endy; j++) {
                 if (Random() % 2 == 0) {
                     color = Random() % 85 + 170;
-                    if (skeleton.skinText[i * skeleton.skinsize * 3 + j * 3 + 0] > color / 2) {
-                        skeleton.skinText[i * skeleton.skinsize * 3 + j * 3 + 0] = color / 2;
+                    GLubyte* texel = skeleton.skin.paint(i, j);
+                    if (texel != nullptr) {
+                        if (texel[0] > color / 2) {
+                            texel[0] = color / 2;
+                        }
+                        texel[1] = 0;
+                        texel[2] = 0;
                     }
-                    skeleton.skinText[i * skeleton.skinsize * 3 + j * 3 + 1] = 0;
-                    skeleton.skinText[i * skeleton.skinsize * 3 + j * 3 + 2] = 0;
                 }
             }
         }
-        if (detail > 1) {
-            skeleton.drawmodel.textureptr.bind();
-            DoMipmaps();
-        }
 
         if (skeleton.free) {
             bleedx += 4 * direction / realtexdetail;
@@ -6351,339 +6373,340 @@ void IKHelper(Person* p, float interp)
  * MONSTER
  * TODO: ???
  */
-int Person::DrawSkeleton()
+bool Person::poseSkeleton()
 {
-    int oldplayerdetail;
-    if ((frustum.SphereInFrustum(coords.x, coords.y + scale * 3, coords.z, scale * 8) && distsq(&viewer, &coords) < viewdistance * viewdistance) || skeleton.free == 3) {
-        if (onterrain && (isIdle() || isCrouch() || wasIdle() || wasCrouch()) && !skeleton.free) {
-            calcrot = 1;
-        }
+    if (!((frustum.SphereInFrustum(coords.x, coords.y + scale * 3, coords.z, scale * 8) && distsq(&viewer, &coords) < viewdistance * viewdistance) || skeleton.free == 3)) {
+        skinPending = false;
+        return false;
+    }
 
-        if (headless) {
-            headmorphness = 0;
-            headmorphstart = 6;
-            headmorphend = 6;
+    if (onterrain && (isIdle() || isCrouch() || wasIdle() || wasCrouch()) && !skeleton.free) {
+        calcrot = 1;
+    }
+
+    if (headless) {
+        headmorphness = 0;
+        headmorphstart = 6;
+        headmorphend = 6;
+    }
+
+    if (!isnormal(yaw)) {
+        yaw = 0;
+    }
+    if (!isnormal(tilt)) {
+        tilt = 0;
+    }
+    if (!isnormal(tilt2)) {
+        tilt2 = 0;
+    }
+    // A frozen pose keeps the model it was skinned on
+    const int oldplayerdetail = playerdetail;
+    if (lodTier != lod_frozen) {
+        playerdetail = (lodTier == lod_low) ? 0 : 1;
+    }
+    if (playerdetail != oldplayerdetail) {
+        updatedelay = 0;
+        normalsupdatedelay = 0;
+    }
+    if (calcrot) {
+        skeleton.FindForwards();
+        if (howactive == typesittingwall) {
+            skeleton.specialforward[1] = 0;
+            skeleton.specialforward[1].z = 1;
         }
+    }
 
-        glAlphaFunc(GL_GREATER, 0.0001);
-        XYZ terrainlight;
-        float terrainheight;
-        float distance;
-        if (!isnormal(yaw)) {
-            yaw = 0;
+    skinPending = (dead != 2 || skeleton.free != 2) && updatedelay <= 0 && lodTier != lod_frozen;
+    if (skinPending) {
+        if (!isSleeping() && !isSitting()) {
+            // TODO: give these meaningful names
+            const bool cond1 = (isIdle() || isCrouch() || isLanding() || isLandhard() || animTarget == drawrightanim || animTarget == drawleftanim || animTarget == crouchdrawrightanim);
+            const bool cond2 = (wasIdle() || wasCrouch() || wasLanding() || wasLandhard() || animCurrent == drawrightanim || animCurrent == drawleftanim || animCurrent == crouchdrawrightanim);
+
+            if (onterrain && (cond1 && cond2) && !skeleton.free) {
+                IKHelper(this, 1);
+                if (creature == wolftype) {
+                    IKHelper(this, 1);
+                }
+            }
+
+            if (onterrain && (cond1 && !cond2) && !skeleton.free) {
+                IKHelper(this, target);
+                if (creature == wolftype) {
+                    IKHelper(this, target);
+                }
+            }
+
+            if (onterrain && (!cond1 && cond2) && !skeleton.free) {
+                IKHelper(this, 1 - target);
+                if (creature == wolftype) {
+                    IKHelper(this, 1 - target);
+                }
+            }
         }
-        if (!isnormal(tilt)) {
-            tilt = 0;
+
+        if (!skeleton.free && (!Animation::animations[animTarget].attack && animTarget != getupfrombackanim && ((animTarget != rollanim && !isFlip()) || targetFrame().label == 6) && animTarget != getupfromfrontanim && animTarget != wolfrunninganim && animTarget != rabbitrunninganim && animTarget != backhandspringanim && animTarget != walljumpfrontanim && animTarget != hurtidleanim && !isLandhard() && !isSleeping())) {
+            DoHead();
+        } else {
+            targetheadyaw = -targetyaw;
+            targetheadpitch = 0;
+            if (Animation::animations[animTarget].attack == 3) {
+                targetheadyaw += 180;
+            }
         }
-        if (!isnormal(tilt2)) {
-            tilt2 = 0;
+
+        // The GPU path poses drawmodel in a vertex program, the CPU only hands it muscle matrices
+        if (gpuskinning && (playerdetail || skeleton.free == 3)) {
+            if (!skeleton.skinnedMesh.isBuilt()) {
+                skeleton.skinnedMesh.build(skeleton.base->model[0], skeleton.drawmodel, skeleton.muscles.size());
+            }
+        } else if (!gpuskinning) {
+            skeleton.skinnedMesh.release();
         }
-        oldplayerdetail = playerdetail;
-        playerdetail = 0;
-        if (distsq(&viewer, &coords) < viewdistance * viewdistance / 32 && detail == 2) {
-            playerdetail = 1;
+        for (unsigned int i = 0; i < skeleton.muscles.size(); i++) {
+            updatedelay = 1 + (float)(Random() % 100) / 1000;
         }
-        if (distsq(&viewer, &coords) < viewdistance * viewdistance / 128 && detail == 1) {
-            playerdetail = 1;
+    }
+
+    // Skinning sets updatedelay between 1 and 1.1, every tier runs it out in real time
+    float updatedelaychange = 0;
+    if (lodTier == lod_full) {
+        // About 60 times a second, and every frame for the player and edited ragdolls
+        updatedelaychange = -realmultiplier * 66;
+        if ((id == 0 || skeleton.free == 3) && updatedelaychange > -1.1) {
+            updatedelaychange = -1.1;
         }
-        if (distsq(&viewer, &coords) < viewdistance * viewdistance / 256 && (detail != 1 && detail != 2)) {
-            playerdetail = 1;
+    } else if (lodTier == lod_half) {
+        updatedelaychange = -realmultiplier * 33;
+    } else if (lodTier == lod_low) {
+        const float framemult = .01;
+        updatedelaychange = -framemult * 4 * (45 - findDistance(&viewer, &coords) * 1);
+        if (updatedelaychange > -realmultiplier * 30) {
+            updatedelaychange = -realmultiplier * 30;
         }
-        if (id == 0) {
-            playerdetail = 1;
+        if (updatedelaychange > -framemult * 4) {
+            updatedelaychange = -framemult * 4;
         }
-        if (playerdetail != oldplayerdetail) {
-            updatedelay = 0;
-            normalsupdatedelay = 0;
+        if (skeleton.free == 1) {
+            updatedelaychange *= 6;
         }
-        static float updatedelaychange;
-        static float morphness;
-        static float framemult;
-        if (calcrot) {
-            skeleton.FindForwards();
-            if (howactive == typesittingwall) {
-                skeleton.specialforward[1] = 0;
-                skeleton.specialforward[1].z = 1;
-            }
-        }
-        static XYZ mid;
-        static float M[16];
-        static int k;
-        static int weaponattachmuscle;
-        static int weaponrotatemuscle;
-        static XYZ weaponpoint;
-        static int start, endthing;
-        if ((dead != 2 || skeleton.free != 2) && updatedelay <= 0) {
-            if (!isSleeping() && !isSitting()) {
-                // TODO: give these meaningful names
-                const bool cond1 = (isIdle() || isCrouch() || isLanding() || isLandhard() || animTarget == drawrightanim || animTarget == drawleftanim || animTarget == crouchdrawrightanim);
-                const bool cond2 = (wasIdle() || wasCrouch() || wasLanding() || wasLandhard() || animCurrent == drawrightanim || animCurrent == drawleftanim || animCurrent == crouchdrawrightanim);
-
-                if (onterrain && (cond1 && cond2) && !skeleton.free) {
-                    IKHelper(this, 1);
-                    if (creature == wolftype) {
-                        IKHelper(this, 1);
-                    }
-                }
+    }
+    updatedelay += updatedelaychange;
 
-                if (onterrain && (cond1 && !cond2) && !skeleton.free) {
-                    IKHelper(this, target);
-                    if (creature == wolftype) {
-                        IKHelper(this, target);
-                    }
-                }
+    return true;
+}
 
-                if (onterrain && (!cond1 && cond2) && !skeleton.free) {
-                    IKHelper(this, 1 - target);
-                    if (creature == wolftype) {
-                        IKHelper(this, 1 - target);
-                    }
-                }
+void Person::skinSkeleton()
+{
+    if (!skinPending) {
+        return;
+    }
+    skinPending = false;
+
+    const bool gpuSkinned = gpuskinning && (playerdetail || skeleton.free == 3) && skeleton.skinnedMesh.isBuilt();
+    // Normals are rotated along with their muscle, only the seams between muscles get rebuilt from faces
+    const bool updateNormals = skeleton.free != 2 && (skeleton.free == 1 || skeleton.free == 3 || id == 0 || (normalsupdatedelay <= 0) || animTarget == getupfromfrontanim || animTarget == getupfrombackanim || animCurrent == getupfromfrontanim || animCurrent == getupfrombackanim);
+    for (int i = 0; i < skeleton.drawmodel.vertexNum && !gpuSkinned; i++) {
+        skeleton.drawmodel.vertex[i] = 0;
+        skeleton.drawmodel.vertex[i].y = 999;
+    }
+    for (int i = 0; i < skeleton.drawmodellow.vertexNum; i++) {
+        skeleton.drawmodellow.vertex[i] = 0;
+        skeleton.drawmodellow.vertex[i].y = 999;
+    }
+    for (int i = 0; i < skeleton.drawmodelclothes.vertexNum; i++) {
+        skeleton.drawmodelclothes.vertex[i] = 0;
+        skeleton.drawmodelclothes.vertex[i].y = 999;
+    }
+    for (unsigned int i = 0; i < skeleton.muscles.size(); i++) {
+        // convenience renames
+        const int p1 = skeleton.muscles[i].parent1->label;
+        const int p2 = skeleton.muscles[i].parent2->label;
+
+        const bool skinned = (skeleton.base->muscles[i].vertices.size() > 0 && playerdetail) || (skeleton.base->muscles[i].verticeslow.size() > 0 && !playerdetail);
+        const bool clothed = skeleton.clothes && skeleton.base->muscles[i].verticesclothes.size() > 0;
+        if (skinned || clothed) {
+            if (skinned && calcrot) {
+                skeleton.FindRotationMuscle(i, animTarget);
             }
 
-            if (!skeleton.free && (!Animation::animations[animTarget].attack && animTarget != getupfrombackanim && ((animTarget != rollanim && !isFlip()) || targetFrame().label == 6) && animTarget != getupfromfrontanim && animTarget != wolfrunninganim && animTarget != rabbitrunninganim && animTarget != backhandspringanim && animTarget != walljumpfrontanim && animTarget != hurtidleanim && !isLandhard() && !isSleeping())) {
-                DoHead();
-            } else {
-                targetheadyaw = -targetyaw;
-                targetheadpitch = 0;
-                if (Animation::animations[animTarget].attack == 3) {
-                    targetheadyaw += 180;
-                }
+            const XYZ mid = (skeleton.muscles[i].parent1->position + skeleton.muscles[i].parent2->position) / 2;
+            Matrix4 muscleMatrix;
+            if (!skeleton.free) {
+                muscleMatrix.rotate(tilt2, 1, 0, 0);
+                muscleMatrix.rotate(tilt, 0, 0, 1);
             }
-            for (int i = 0; i < skeleton.drawmodel.vertexNum; i++) {
-                skeleton.drawmodel.vertex[i] = 0;
-                skeleton.drawmodel.vertex[i].y = 999;
+            muscleMatrix.translate(mid);
+
+            skeleton.muscles[i].lastrotate1 = skeleton.muscles[i].rotate1;
+            muscleMatrix.rotate(-skeleton.muscles[i].lastrotate1 + 90, 0, 1, 0);
+
+            skeleton.muscles[i].lastrotate2 = skeleton.muscles[i].rotate2;
+            muscleMatrix.rotate(-skeleton.muscles[i].lastrotate2 + 90, 0, 0, 1);
+
+            skeleton.muscles[i].lastrotate3 = skeleton.muscles[i].rotate3;
+            muscleMatrix.rotate(-skeleton.muscles[i].lastrotate3, 0, 1, 0);
+
+            // Vertices used to be offset once per matching body part, so proportions add up
+            XYZ proportion;
+            if (p1 == abdomen || p2 == abdomen) {
+                proportion += getProportionXYZ(1);
             }
-            for (int i = 0; i < skeleton.drawmodellow.vertexNum; i++) {
-                skeleton.drawmodellow.vertex[i] = 0;
-                skeleton.drawmodellow.vertex[i].y = 999;
+            if (p1 == lefthand || p1 == righthand || p1 == leftwrist || p1 == rightwrist || p1 == leftelbow || p1 == rightelbow || p2 == leftelbow || p2 == rightelbow) {
+                proportion += getProportionXYZ(2);
             }
-            for (int i = 0; i < skeleton.drawmodelclothes.vertexNum; i++) {
-                skeleton.drawmodelclothes.vertex[i] = 0;
-                skeleton.drawmodelclothes.vertex[i].y = 999;
+            if (p1 == leftfoot || p1 == rightfoot || p1 == leftankle || p1 == rightankle || p1 == leftknee || p1 == rightknee || p2 == leftknee || p2 == rightknee) {
+                proportion += getProportionXYZ(3);
             }
-            for (unsigned int i = 0; i < skeleton.muscles.size(); i++) {
-                // convenience renames
-                const int p1 = skeleton.muscles[i].parent1->label;
-                const int p2 = skeleton.muscles[i].parent2->label;
+            if (p1 == head || p2 == head) {
+                proportion += getProportionXYZ(0);
+            }
+            const SkinMatrix skin(muscleMatrix, proportion, scale);
+            const SkinMatrix normalSkin = SkinMatrix::forNormals(muscleMatrix, proportion);
 
-                if ((skeleton.muscles[i].vertices.size() > 0 && playerdetail) || (skeleton.muscles[i].verticeslow.size() > 0 && !playerdetail)) {
-                    morphness = 0;
-                    start = 0;
-                    endthing = 0;
+            if (skinned) {
+                float morphness = 0;
+                int start = 0;
+                int endthing = 0;
 
-                    if (p1 == righthand || p2 == righthand) {
-                        morphness = righthandmorphness;
-                        start = righthandmorphstart;
-                        endthing = righthandmorphend;
-                    }
-                    if (p1 == lefthand || p2 == lefthand) {
-                        morphness = lefthandmorphness;
-                        start = lefthandmorphstart;
-                        endthing = lefthandmorphend;
-                    }
-                    if (p1 == head || p2 == head) {
-                        morphness = headmorphness;
-                        start = headmorphstart;
-                        endthing = headmorphend;
-                    }
-                    if ((p1 == neck && p2 == abdomen) || (p2 == neck && p1 == abdomen)) {
-                        morphness = chestmorphness;
-                        start = chestmorphstart;
-                        endthing = chestmorphend;
-                    }
-                    if ((p1 == groin && p2 == abdomen) || (p2 == groin && p1 == abdomen)) {
-                        morphness = tailmorphness;
-                        start = tailmorphstart;
-                        endthing = tailmorphend;
-                    }
-                    if (calcrot) {
-                        skeleton.FindRotationMuscle(i, animTarget);
-                    }
-                    mid = (skeleton.muscles[i].parent1->position + skeleton.muscles[i].parent2->position) / 2;
-                    glMatrixMode(GL_MODELVIEW);
-                    glPushMatrix();
-                    glLoadIdentity();
-                    if (!skeleton.free) {
-                        glRotatef(tilt2, 1, 0, 0);
-                    }
-                    if (!skeleton.free) {
-                        glRotatef(tilt, 0, 0, 1);
-                    }
-
-                    glTranslatef(mid.x, mid.y, mid.z);
-
-                    skeleton.muscles[i].lastrotate1 = skeleton.muscles[i].rotate1;
-                    glRotatef(-skeleton.muscles[i].lastrotate1 + 90, 0, 1, 0);
-
-                    skeleton.muscles[i].lastrotate2 = skeleton.muscles[i].rotate2;
-                    glRotatef(-skeleton.muscles[i].lastrotate2 + 90, 0, 0, 1);
-
-                    skeleton.muscles[i].lastrotate3 = skeleton.muscles[i].rotate3;
-                    glRotatef(-skeleton.muscles[i].lastrotate3, 0, 1, 0);
-
-                    if (playerdetail || skeleton.free == 3) {
-                        for (unsigned j = 0; j < skeleton.muscles[i].vertices.size(); j++) {
-                            XYZ& v0 = skeleton.model[start].vertex[skeleton.muscles[i].vertices[j]];
-                            XYZ& v1 = skeleton.model[endthing].vertex[skeleton.muscles[i].vertices[j]];
-                            glMatrixMode(GL_MODELVIEW);
-                            glPushMatrix();
-                            if (p1 == abdomen || p2 == abdomen) {
-                                glTranslatef((v0.x * (1 - morphness) + v1.x * morphness) * getProportionXYZ(1).x,
-                                             (v0.y * (1 - morphness) + v1.y * morphness) * getProportionXYZ(1).y,
-                                             (v0.z * (1 - morphness) + v1.z * morphness) * getProportionXYZ(1).z);
-                            }
-                            if (p1 == lefthand || p1 == righthand || p1 == leftwrist || p1 == rightwrist || p1 == leftelbow || p1 == rightelbow || p2 == leftelbow || p2 == rightelbow) {
-                                glTranslatef((v0.x * (1 - morphness) + v1.x * morphness) * getProportionXYZ(2).x,
-                                             (v0.y * (1 - morphness) + v1.y * morphness) * getProportionXYZ(2).y,
-                                             (v0.z * (1 - morphness) + v1.z * morphness) * getProportionXYZ(2).z);
-                            }
-                            if (p1 == leftfoot || p1 == rightfoot || p1 == leftankle || p1 == rightankle || p1 == leftknee || p1 == rightknee || p2 == leftknee || p2 == rightknee) {
-                                glTranslatef((v0.x * (1 - morphness) + v1.x * morphness) * getProportionXYZ(3).x,
-                                             (v0.y * (1 - morphness) + v1.y * morphness) * getProportionXYZ(3).y,
-                                             (v0.z * (1 - morphness) + v1.z * morphness) * getProportionXYZ(3).z);
-                            }
-                            if (p1 == head || p2 == head) {
-                                glTranslatef((v0.x * (1 - morphness) + v1.x * morphness) * getProportionXYZ(0).x,
-                                             (v0.y * (1 - morphness) + v1.y * morphness) * getProportionXYZ(0).y,
-                                             (v0.z * (1 - morphness) + v1.z * morphness) * getProportionXYZ(0).z);
-                            }
-                            glGetFloatv(GL_MODELVIEW_MATRIX, M);
-                            skeleton.drawmodel.vertex[skeleton.muscles[i].vertices[j]].x = M[12] * scale;
-                            skeleton.drawmodel.vertex[skeleton.muscles[i].vertices[j]].y = M[13] * scale;
-                            skeleton.drawmodel.vertex[skeleton.muscles[i].vertices[j]].z = M[14] * scale;
-                            glPopMatrix();
-                        }
-                    }
-                    if (!playerdetail || skeleton.free == 3) {
-                        for (unsigned j = 0; j < skeleton.muscles[i].verticeslow.size(); j++) {
-                            XYZ& v0 = skeleton.modellow.vertex[skeleton.muscles[i].verticeslow[j]];
-                            glMatrixMode(GL_MODELVIEW);
-                            glPushMatrix();
-                            if (p1 == abdomen || p2 == abdomen) {
-                                glTranslatef(v0.x * getProportionXYZ(1).x,
-                                             v0.y * getProportionXYZ(1).y,
-                                             v0.z * getProportionXYZ(1).z);
-                            }
-                            if (p1 == lefthand || p1 == righthand || p1 == leftwrist || p1 == rightwrist || p1 == leftelbow || p1 == rightelbow || p2 == leftelbow || p2 == rightelbow) {
-                                glTranslatef(v0.x * getProportionXYZ(2).x,
-                                             v0.y * getProportionXYZ(2).y,
-                                             v0.z * getProportionXYZ(2).z);
-                            }
-                            if (p1 == leftfoot || p1 == rightfoot || p1 == leftankle || p1 == rightankle || p1 == leftknee || p1 == rightknee || p2 == leftknee || p2 == rightknee) {
-                                glTranslatef(v0.x * getProportionXYZ(3).x,
-                                             v0.y * getProportionXYZ(3).y,
-                                             v0.z * getProportionXYZ(3).z);
-                            }
-                            if (p1 == head || p2 == head) {
-                                glTranslatef(v0.x * getProportionXYZ(0).x,
-                                             v0.y * getProportionXYZ(0).y,
-                                             v0.z * getProportionXYZ(0).z);
-                            }
-
-                            glGetFloatv(GL_MODELVIEW_MATRIX, M);
-                            skeleton.drawmodellow.vertex[skeleton.muscles[i].verticeslow[j]].x = M[12] * scale;
-                            skeleton.drawmodellow.vertex[skeleton.muscles[i].verticeslow[j]].y = M[13] * scale;
-                            skeleton.drawmodellow.vertex[skeleton.muscles[i].verticeslow[j]].z = M[14] * scale;
-                            glPopMatrix();
-                        }
-                    }
-                    glPopMatrix();
+                if (p1 == righthand || p2 == righthand) {
+                    morphness = righthandmorphness;
+                    start = righthandmorphstart;
+                    endthing = righthandmorphend;
                 }
-                if (skeleton.clothes && skeleton.muscles[i].verticesclothes.size() > 0) {
-                    mid = (skeleton.muscles[i].parent1->position + skeleton.muscles[i].parent2->position) / 2;
-
-                    glMatrixMode(GL_MODELVIEW);
-                    glPushMatrix();
-                    glLoadIdentity();
-                    if (!skeleton.free) {
-                        glRotatef(tilt2, 1, 0, 0);
-                    }
-                    if (!skeleton.free) {
-                        glRotatef(tilt, 0, 0, 1);
-                    }
-                    glTranslatef(mid.x, mid.y, mid.z);
-                    skeleton.muscles[i].lastrotate1 = skeleton.muscles[i].rotate1;
-                    glRotatef(-skeleton.muscles[i].lastrotate1 + 90, 0, 1, 0);
-
-                    skeleton.muscles[i].lastrotate2 = skeleton.muscles[i].rotate2;
-                    glRotatef(-skeleton.muscles[i].lastrotate2 + 90, 0, 0, 1);
-
-                    skeleton.muscles[i].lastrotate3 = skeleton.muscles[i].rotate3;
-                    glRotatef(-skeleton.muscles[i].lastrotate3, 0, 1, 0);
-
-                    for (unsigned j = 0; j < skeleton.muscles[i].verticesclothes.size(); j++) {
-                        XYZ& v0 = skeleton.modelclothes.vertex[skeleton.muscles[i].verticesclothes[j]];
-                        glMatrixMode(GL_MODELVIEW);
-                        glPushMatrix();
-                        if (p1 == abdomen || p2 == abdomen) {
-                            glTranslatef(v0.x * getProportionXYZ(1).x,
-                                         v0.y * getProportionXYZ(1).y,
-                                         v0.z * getProportionXYZ(1).z);
-                        }
-                        if (p1 == lefthand || p1 == righthand || p1 == leftwrist || p1 == rightwrist || p1 == leftelbow || p1 == rightelbow || p2 == leftelbow || p2 == rightelbow) {
-                            glTranslatef(v0.x * getProportionXYZ(2).x,
-                                         v0.y * getProportionXYZ(2).y,
-                                         v0.z * getProportionXYZ(2).z);
-                        }
-                        if (p1 == leftfoot || p1 == rightfoot || p1 == leftankle || p1 == rightankle || p1 == leftknee || p1 == rightknee || p2 == leftknee || p2 == rightknee) {
-                            glTranslatef(v0.x * getProportionXYZ(3).x,
-                                         v0.y * getProportionXYZ(3).y,
-                                         v0.z * getProportionXYZ(3).z);
-                        }
-                        if (p1 == head || p2 == head) {
-                            glTranslatef(v0.x * getProportionXYZ(0).x,
-                                         v0.y * getProportionXYZ(0).y,
-                                         v0.z * getProportionXYZ(0).z);
-                        }
-                        glGetFloatv(GL_MODELVIEW_MATRIX, M);
-                        skeleton.drawmodelclothes.vertex[skeleton.muscles[i].verticesclothes[j]].x = M[12] * scale;
-                        skeleton.drawmodelclothes.vertex[skeleton.muscles[i].verticesclothes[j]].y = M[13] * scale;
-                        skeleton.drawmodelclothes.vertex[skeleton.muscles[i].verticesclothes[j]].z = M[14] * scale;
-                        glPopMatrix();
-                    }
-                    glPopMatrix();
+                if (p1 == lefthand || p2 == lefthand) {
+                    morphness = lefthandmorphness;
+                    start = lefthandmorphstart;
+                    endthing = lefthandmorphend;
                 }
-                updatedelay = 1 + (float)(Random() % 100) / 1000;
-            }
-            if (skeleton.free != 2 && (skeleton.free == 1 || skeleton.free == 3 || id == 0 || (normalsupdatedelay <= 0) || animTarget == getupfromfrontanim || animTarget == getupfrombackanim || animCurrent == getupfromfrontanim || animCurrent == getupfrombackanim)) {
-                normalsupdatedelay = 1;
-                if (playerdetail || skeleton.free == 3) {
-                    skeleton.drawmodel.CalculateNormals(0);
+                if (p1 == head || p2 == head) {
+                    morphness = headmorphness;
+                    start = headmorphstart;
+                    endthing = headmorphend;
                 }
-                if (!playerdetail || skeleton.free == 3) {
-                    skeleton.drawmodellow.CalculateNormals(0);
+                if ((p1 == neck && p2 == abdomen) || (p2 == neck && p1 == abdomen)) {
+                    morphness = chestmorphness;
+                    start = chestmorphstart;
+                    endthing = chestmorphend;
                 }
-                if (skeleton.clothes) {
-                    skeleton.drawmodelclothes.CalculateNormals(0);
+                if ((p1 == groin && p2 == abdomen) || (p2 == groin && p1 == abdomen)) {
+                    morphness = tailmorphness;
+                    start = tailmorphstart;
+                    endthing = tailmorphend;
                 }
-            } else {
+
                 if (playerdetail || skeleton.free == 3) {
-                    skeleton.drawmodel.UpdateVertexArrayNoTexNoNorm();
+                    const std::vector<int>& vertices = skeleton.base->muscles[i].vertices;
+                    if (gpuSkinned) {
+                        skeleton.skinnedMesh.setMuscle(i, skin);
+                        skeleton.skinnedMesh.morph(i, skeleton.base->model[start].vertex, skeleton.base->model[endthing].vertex, morphness, vertices);
+                    } else if (morphness == 0 || start == endthing) {
+                        Skinning::transform(skin, skeleton.base->model[start].vertex, vertices.data(), vertices.size(), skeleton.drawmodel.vertex);
+                        if (updateNormals) {
+                            Skinning::transformNormals(normalSkin, skeleton.base->model[start].normals, vertices.data(), vertices.size(), skeleton.drawmodel.normals);
+                        }
+                    } else {
+                        Skinning::transform(skin, skeleton.base->model[start].vertex, skeleton.base->model[endthing].vertex, morphness, vertices.data(), vertices.size(), skeleton.drawmodel.vertex);
+                        if (updateNormals) {
+                            Skinning::transformNormals(normalSkin, skeleton.base->model[start].normals, skeleton.base->model[endthing].normals, morphness, vertices.data(), vertices.size(), skeleton.drawmodel.normals);
+                        }
+                    }
                 }
                 if (!playerdetail || skeleton.free == 3) {
-                    skeleton.drawmodellow.UpdateVertexArrayNoTexNoNorm();
+                    const std::vector<int>& vertices = skeleton.base->muscles[i].verticeslow;
+                    Skinning::transform(skin, skeleton.base->modellow.vertex, vertices.data(), vertices.size(), skeleton.drawmodellow.vertex);
+                    if (updateNormals) {
+                        Skinning::transformNormals(normalSkin, skeleton.base->modellow.normals, vertices.data(), vertices.size(), skeleton.drawmodellow.normals);
+                    }
                 }
-                if (skeleton.clothes) {
-                    skeleton.drawmodelclothes.UpdateVertexArrayNoTexNoNorm();
+            }
+            if (clothed) {
+                const std::vector<int>& vertices = skeleton.base->muscles[i].verticesclothes;
+                Skinning::transform(skin, skeleton.base->modelclothes.vertex, vertices.data(), vertices.size(), skeleton.drawmodelclothes.vertex);
+                if (updateNormals) {
+                    Skinning::transformNormals(normalSkin, skeleton.base->modelclothes.normals, vertices.data(), vertices.size(), skeleton.drawmodelclothes.normals);
                 }
             }
         }
-        framemult = .01;
-        updatedelaychange = -framemult * 4 * (45 - findDistance(&viewer, &coords) * 1);
-        if (updatedelaychange > -realmultiplier * 30) {
-            updatedelaychange = -realmultiplier * 30;
+    }
+    if (updateNormals) {
+        normalsupdatedelay = 1;
+        if ((playerdetail || skeleton.free == 3) && !gpuSkinned) {
+            skeleton.base->seams.apply(skeleton.drawmodel);
+            skeleton.drawmodel.UpdateVertexArrayNoTex();
+            skeleton.faceNormalsStale = true;
         }
-        if (updatedelaychange > -framemult * 4) {
-            updatedelaychange = -framemult * 4;
+        if (!playerdetail || skeleton.free == 3) {
+            skeleton.base->seamslow.apply(skeleton.drawmodellow);
+            skeleton.drawmodellow.UpdateVertexArrayNoTex();
         }
-        if (skeleton.free == 1) {
-            updatedelaychange *= 6;
+        if (skeleton.clothes) {
+            skeleton.base->seamsclothes.apply(skeleton.drawmodelclothes);
+            skeleton.drawmodelclothes.UpdateVertexArrayNoTex();
         }
-        if (id == 0) {
-            updatedelaychange *= 8;
+    } else {
+        if ((playerdetail || skeleton.free == 3) && !gpuSkinned) {
+            skeleton.drawmodel.UpdateVertexArrayNoTexNoNorm();
+        }
+        if (!playerdetail || skeleton.free == 3) {
+            skeleton.drawmodellow.UpdateVertexArrayNoTexNoNorm();
+        }
+        if (skeleton.clothes) {
+            skeleton.drawmodelclothes.UpdateVertexArrayNoTexNoNorm();
+        }
+    }
+}
+
+/* Poses the skeletons serially, since IK and head tracking go through
+ * function statics and Random(), then skins them on the worker pool.
+ * DrawSkeleton() afterwards only submits the results to GL.
+ */
+void Person::prepareSkeletons(const std::vector<Person*>& persons)
+{
+    LodScheduler::schedule(persons);
+
+    std::vector<Person*> pending;
+    for (Person* person : persons) {
+        person->skeletonPrepared = true;
+        person->skeletonVisible = person->poseSkeleton();
+        if (person->skinPending) {
+            pending.push_back(person);
+        }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    WorkerPool::run(pending.size(), [&pending](size_t i) {
+        pending[i]->skinSkeleton();
+    });
+    LodScheduler::measure(pending, std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count());
+}
+
+int Person::DrawSkeleton()
+{
+    bool visible;
+    if (skeletonPrepared) {
+        skeletonPrepared = false;
+        visible = skeletonVisible;
+    } else {
+        // A tier left over from the last batch may be frozen, or a forced full skin may be due
+        LodScheduler::schedule(*this);
+        visible = poseSkeleton();
+        skinSkeleton();
+    }
+
+    if (visible) {
+        // Blood painted since the last draw goes up in one go, only the tiles it landed on
+        if (skeleton.skin.isDirty()) {
+            skeleton.skin.flush(skeleton.drawmodel.textureptr);
         }
-        updatedelay += updatedelaychange;
+
+        glAlphaFunc(GL_GREATER, 0.0001);
+        XYZ terrainlight;
+        float terrainheight;
+        float distance;
+        int k;
+        int weaponattachmuscle = 0;
+        int weaponrotatemuscle = 0;
+        XYZ weaponpoint;
 
         glMatrixMode(GL_MODELVIEW);
         glPushMatrix();
@@ -6697,6 +6720,7 @@ int Person::DrawSkeleton()
             glColor4f(.4, 1, .4, 1);
             glDisable(GL_LIGHTING);
             glDisable(GL_TEXTURE_2D);
+            skeleton.syncDrawModel();
             glBegin(GL_POINTS);
             if (playerdetail) {
                 for (int i = 0; i < skeleton.drawmodel.vertexNum; i++) {
@@ -6768,7 +6792,10 @@ int Person::DrawSkeleton()
             }
             if (playerdetail) {
                 if (!showpoints) {
-                    if (Tutorial::active && (id != 0)) {
+                    if (skeleton.skinnedMesh.isBuilt()) {
+                        const bool tutorialGhost = Tutorial::active && (id != 0);
+                        skeleton.skinnedMesh.draw(tutorialGhost ? Sprite::cloudimpacttexture : skeleton.drawmodel.textureptr, tutorialGhost);
+                    } else if (Tutorial::active && (id != 0)) {
                         skeleton.drawmodel.drawdifftex(Sprite::cloudimpacttexture);
                     } else {
                         skeleton.drawmodel.draw();
@@ -6804,7 +6831,10 @@ int Person::DrawSkeleton()
                     glTranslatef(smoketex * .6, 0, 0);
                     if (playerdetail) {
                         if (!showpoints) {
-                            if (Tutorial::active && (id != 0)) {
+                            if (skeleton.skinnedMesh.isBuilt()) {
+                                const bool tutorialGhost = Tutorial::active && (id != 0);
+                                skeleton.skinnedMesh.draw(tutorialGhost ? Sprite::cloudimpacttexture : skeleton.drawmodel.textureptr, tutorialGhost);
+                            } else if (Tutorial::active && (id != 0)) {
                                 skeleton.drawmodel.drawdifftex(Sprite::cloudimpacttexture);
                             } else {
                                 skeleton.drawmodel.draw();
@@ -6846,12 +6876,12 @@ int Person::DrawSkeleton()
                 if (weaponactive == k) {
                     if (weapons[i].getType() != staff) {
                         for (unsigned j = 0; j < skeleton.muscles.size(); j++) {
-                            if ((skeleton.muscles[j].parent1->label == righthand || skeleton.muscles[j].parent2->label == righthand) && skeleton.muscles[j].vertices.size() > 0) {
+                            if ((skeleton.muscles[j].parent1->label == righthand || skeleton.muscles[j].parent2->label == righthand) && skeleton.base->muscles[j].vertices.size() > 0) {
                                 weaponattachmuscle = j;
                             }
                         }
                         for (unsigned j = 0; j < skeleton.muscles.size(); j++) {
-                            if ((skeleton.muscles[j].parent1->label == rightwrist || skeleton.muscles[j].parent2->label == rightwrist) && (skeleton.muscles[j].parent1->label != righthand && skeleton.muscles[j].parent2->label != righthand) && skeleton.muscles[j].vertices.size() > 0) {
+                            if ((skeleton.muscles[j].parent1->label == rightwrist || skeleton.muscles[j].parent2->label == rightwrist) && (skeleton.muscles[j].parent1->label != righthand && skeleton.muscles[j].parent2->label != righthand) && skeleton.base->muscles[j].vertices.size() > 0) {
                                 weaponrotatemuscle = j;
                             }
                         }
@@ -6862,12 +6892,12 @@ int Person::DrawSkeleton()
                     }
                     if (weapons[i].getType() == staff) {
                         for (unsigned j = 0; j < skeleton.muscles.size(); j++) {
-                            if ((skeleton.muscles[j].parent1->label == righthand || skeleton.muscles[j].parent2->label == righthand) && skeleton.muscles[j].vertices.size() > 0) {
+                            if ((skeleton.muscles[j].parent1->label == righthand || skeleton.muscles[j].parent2->label == righthand) && skeleton.base->muscles[j].vertices.size() > 0) {
                                 weaponattachmuscle = j;
                             }
                         }
                         for (unsigned j = 0; j < skeleton.muscles.size(); j++) {
-                            if ((skeleton.muscles[j].parent1->label == rightelbow || skeleton.muscles[j].parent2->label == rightelbow) && (skeleton.muscles[j].parent1->label != rightshoulder && skeleton.muscles[j].parent2->label != rightshoulder) && skeleton.muscles[j].vertices.size() > 0) {
+                            if ((skeleton.muscles[j].parent1->label == rightelbow || skeleton.muscles[j].parent2->label == rightelbow) && (skeleton.muscles[j].parent1->label != rightshoulder && skeleton.muscles[j].parent2->label != rightshoulder) && skeleton.base->muscles[j].vertices.size() > 0) {
                                 weaponrotatemuscle = j;
                             }
                         }
@@ -6895,7 +6925,7 @@ int Person::DrawSkeleton()
                         weaponpoint = jointPos(abdomen) + (jointPos(lefthip) - jointPos(righthip)) * .09 + (jointPos(leftshoulder) - jointPos(rightshoulder)) * .33;
                     }
                     for (unsigned j = 0; j < skeleton.muscles.size(); j++) {
-                        if ((skeleton.muscles[j].parent1->label == abdomen || skeleton.muscles[j].parent2->label == abdomen) && (skeleton.muscles[j].parent1->label == neck || skeleton.muscles[j].parent2->label == neck) && skeleton.muscles[j].vertices.size() > 0) {
+                        if ((skeleton.muscles[j].parent1->label == abdomen || skeleton.muscles[j].parent2->label == abdomen) && (skeleton.muscles[j].parent1->label == neck || skeleton.muscles[j].parent2->label == neck) && skeleton.base->muscles[j].vertices.size() > 0) {
                             weaponrotatemuscle = j;
                         }
                     }
@@ -6907,7 +6937,7 @@ int Person::DrawSkeleton()
                         weaponpoint = jointPos(abdomen) * .5 + jointPos(neck) * .5 + skeleton.forward * .8;
                     }
                     for (unsigned j = 0; j < skeleton.muscles.size(); j++) {
-                        if ((skeleton.muscles[j].parent1->label == abdomen || skeleton.muscles[j].parent2->label == abdomen) && (skeleton.muscles[j].parent1->label == neck || skeleton.muscles[j].parent2->label == neck) && skeleton.muscles[j].vertices.size() > 0) {
+                        if ((skeleton.muscles[j].parent1->label == abdomen || skeleton.muscles[j].parent2->label == abdomen) && (skeleton.muscles[j].parent1->label == neck || skeleton.muscles[j].parent2->label == neck) && skeleton.base->muscles[j].vertices.size() > 0) {
                             weaponrotatemuscle = j;
                         }
                     }
@@ -6941,7 +6971,7 @@ int Person::DrawSkeleton()
                             float distance;
 
                             temppoint1 = jointPos(righthand);
-                            temppoint2 = currentFrame().weapontarget * (1 - target) + targetFrame().weapontarget * (target);
+                            temppoint2 = getPose().getWeaponTarget();
                             distance = findDistance(&temppoint1, &temppoint2);
                             weapons[i].rotation2 = asin((temppoint1.y - temppoint2.y) / distance);
                             weapons[i].rotation2 *= 360 / 6.28;
@@ -6961,7 +6991,7 @@ int Person::DrawSkeleton()
                             float distance;
 
                             temppoint1 = jointPos(righthand);
-                            temppoint2 = currentFrame().weapontarget * (1 - target) + targetFrame().weapontarget * (target);
+                            temppoint2 = getPose().getWeaponTarget();
                             distance = findDistance(&temppoint1, &temppoint2);
                             weapons[i].rotation2 = asin((temppoint1.y - temppoint2.y) / distance);
                             weapons[i].rotation2 *= 360 / 6.28;
@@ -7005,8 +7035,8 @@ int Person::DrawSkeleton()
                             XYZ temppoint1, temppoint2;
                             float distance;
 
-                            temppoint1 = currentFrame().joints[skeleton.jointlabels[righthand]].position * (1 - target) + targetFrame().joints[skeleton.jointlabels[righthand]].position * (target); //jointPos(righthand);
-                            temppoint2 = currentFrame().weapontarget * (1 - target) + targetFrame().weapontarget * (target);
+                            temppoint1 = getPose().getPosition(skeleton.jointlabels[righthand]); //jointPos(righthand);
+                            temppoint2 = getPose().getWeaponTarget();
                             distance = findDistance(&temppoint1, &temppoint2);
                             weapons[i].rotation2 = asin((temppoint1.y - temppoint2.y) / distance);
                             weapons[i].rotation2 *= 360 / 6.28;
@@ -7029,8 +7059,8 @@ int Person::DrawSkeleton()
                             XYZ temppoint1, temppoint2;
                             float distance;
 
-                            temppoint1 = currentFrame().joints[skeleton.jointlabels[righthand]].position * (1 - target) + targetFrame().joints[skeleton.jointlabels[righthand]].position * (target); //jointPos(righthand);
-                            temppoint2 = currentFrame().weapontarget * (1 - target) + targetFrame().weapontarget * (target);
+                            temppoint1 = getPose().getPosition(skeleton.jointlabels[righthand]); //jointPos(righthand);
+                            temppoint2 = getPose().getWeaponTarget();
                             distance = findDistance(&temppoint1, &temppoint2);
                             weapons[i].rotation2 = asin((temppoint1.y - temppoint2.y) / distance);
                             weapons[i].rotation2 *= 360 / 6.28;
@@ -7318,13 +7348,11 @@ bool Person::addClothes(const int& clothesId)
     LOGFUNC;
     const std::string fileName = clothes[clothesId];
 
-    GLubyte* array = &skeleton.skinText[0];
-
-    //Load Image
+    //Load Image, staged by PrefetchLevel for upcoming campaign levels
     ImageRec texture;
-    bool opened = load_image(Folders::getResourcePath(fileName).c_str(), texture);
+    const std::string path = Folders::getResourcePath(fileName);
+    bool opened = TextureLoader::copy(path, texture) || load_image(path.c_str(), texture);
 
-    float alphanum;
     //Is it valid?
     if (opened) {
         float tintr = clothestintr[clothesId];
@@ -7351,30 +7379,7 @@ bool Person::addClothes(const int& clothesId)
             tintb = 0;
         }
 
-        int bytesPerPixel = texture.bpp / 8;
-
-        int tempnum = 0;
-        alphanum = 255;
-        for (int i = 0; i < (int)(texture.sizeY * texture.sizeX * bytesPerPixel); i++) {
-            if (bytesPerPixel == 3) {
-                alphanum = 255;
-            } else if ((i + 1) % 4 == 0) {
-                alphanum = texture.data[i];
-            }
-            if ((i + 1) % 4 || bytesPerPixel == 3) {
-                if ((i % 4) == 0) {
-                    texture.data[i] *= tintr;
-                }
-                if ((i % 4) == 1) {
-                    texture.data[i] *= tintg;
-                }
-                if ((i % 4) == 2) {
-                    texture.data[i] *= tintb;
-                }
-                array[tempnum] = (float)array[tempnum] * (1 - alphanum / 255) + (float)texture.data[i] * (alphanum / 255);
-                tempnum++;
-            }
-        }
+        skeleton.skin.addClothes(path, texture, tintr, tintg, tintb);
         return 1;
     } else {
         return 0;
@@ -22,17 +22,22 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #define _PERSON_HPP_
 
 #include "Animation/Animation.hpp"
+#include "Animation/Pose.hpp"
 #include "Animation/Skeleton.hpp"
 #include "Environment/Terrain.hpp"
 #include "Graphic/Models.hpp"
 #include "Graphic/Sprite.hpp"
 #include "Graphic/gamegl.hpp"
 #include "Math/XYZ.hpp"
+#include "Objects/LodScheduler.hpp"
 #include "Objects/PersonType.hpp"
 #include "Objects/Weapons.hpp"
 
 #include <cmath>
 #include <memory>
+#include <vector>
+
+class BinaryReader;
 
 #define passivetype 0
 #define guardtype 1
@@ -162,6 +167,14 @@ public:
     float updatedelay;
     float normalsupdatedelay;
 
+    /* Set by poseSkeleton() when the draw models need skinning this frame */
+    bool skinPending;
+    /* Set by prepareSkeletons() so DrawSkeleton() only submits */
+    bool skeletonPrepared;
+    bool skeletonVisible;
+    /* How often and with which model poseSkeleton() skins, see LodScheduler */
+    lod_tier lodTier;
+
     bool jumpstart;
 
     bool forwardkeydown;
@@ -232,6 +245,8 @@ public:
     unsigned id;
 
     Skeleton skeleton;
+    /* Blend of the current and target frames, see getPose() */
+    Pose pose;
 
     float speed;
     float scale;
@@ -317,39 +332,40 @@ public:
     bool jumpclimb;
 
     Person();
-    Person(FILE*, int, unsigned);
+    Person(BinaryReader&, int, unsigned);
 
-    void skeletonLoad(bool clothes = false);
+    /* Without skin the caller provides the skin texture and pixels itself */
+    void skeletonLoad(bool clothes = false, bool skin = true);
 
     // convenience functions
     inline Joint& joint(int bodypart) { return skeleton.joints[skeleton.jointlabels[bodypart]]; }
     inline XYZ& jointPos(int bodypart) { return joint(bodypart).position; }
     inline XYZ& jointVel(int bodypart) { return joint(bodypart).velocity; }
-    AnimationFrame& currentFrame() {
-        /* FIXME - try/catch is a temporary fix to avoid crashes but game logic should be fixed instead */
-        try {
-            return Animation::animations.at(animCurrent).frames.at(frameCurrent);
-        } catch (const std::exception& error) {
+    AnimationFrame currentFrame() {
+        const AnimationFrames& frames = Animation::animations.at(animCurrent).frames;
+        /* FIXME - clamping is a temporary fix to avoid crashes but game logic should be fixed instead */
+        if ((unsigned)frameCurrent >= frames.size()) {
             /* Most likely frameCurrent is too big, work around */
-            if ((unsigned)frameCurrent >=
-Animation::animations.at(animCurrent).frames.size()) {
-                frameCurrent = Animation::animations.at(animCurrent).frames.size() - 1;
-            }
-            return Animation::animations.at(animCurrent).frames.back();
+            frameCurrent = frames.size() - 1;
         }
+        return frames[frameCurrent];
     }
-    AnimationFrame& targetFrame() {
-        /* FIXME - try/catch is a temporary fix to avoid crashes but game logic should be fixed instead */
-        try {
-            return Animation::animations.at(animTarget).frames.at(frameTarget);
-        } catch (const std::exception& error) {
+    AnimationFrame targetFrame() {
+        const AnimationFrames& frames = Animation::animations.at(animTarget).frames;
+        /* FIXME - clamping is a temporary fix to avoid crashes but game logic should be fixed instead */
+        if ((unsigned)frameTarget >= frames.size()) {
             /* Most likely frameTarget is too big, work around */
-            if ((unsigned)frameTarget >=
-Animation::animations.at(animTarget).frames.size()) {
-                frameTarget = Animation::animations.at(animTarget).frames.size() - 1;
-            }
-            return Animation::animations.at(animTarget).frames.back();
+            frameTarget = frames.size() - 1;
         }
+        return frames[frameTarget];
+    }
+    /* Current and target frames blended by target, only evaluated again once one of them changed */
+    const Pose& getPose() {
+        // Clamps the frames first
+        currentFrame();
+        targetFrame();
+        pose.evaluate(Animation::animations[animCurrent].frames, frameCurrent, Animation::animations[animTarget].frames, frameTarget, target);
+        return pose;
     }
 
     void setProportions(float head, float body, float arms, float legs);
@@ -403,12 +419,28 @@ Animation::animations.at(animTarget).frames.size()) {
     void DoHead();
     void DoMipmaps()
     {
-        skeleton.drawmodel.textureptr.bind();
-        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, skeleton.skinsize, skeleton.skinsize, 0, GL_RGB, GL_UNSIGNED_BYTE, &skeleton.skinText[0]);
+        skeleton.skin.upload(skeleton.drawmodel.textureptr);
+    }
+    void loadSkin(const std::string& fileName)
+    {
+        // A texture of its own, the shared one from the registry must not get blood on it
+        skeleton.drawmodel.textureptr = Texture();
+        skeleton.skin.load(fileName);
+        DoMipmaps();
     }
 
     int SphereCheck(XYZ* p1, float radius, XYZ* p, XYZ* move, float* rotate, Model* model);
+    void setLodTier(lod_tier tier)
+    {
+        // A pose frozen for a while is stale, skin it as soon as it thaws
+        if (lodTier == lod_frozen && tier != lod_frozen) {
+            updatedelay = 0;
+        }
+        lodTier = tier;
+    }
+    bool poseSkeleton();
+    void skinSkeleton();
+    static void prepareSkeletons(const std::vector<Person*>& persons);
     int DrawSkeleton();
     void Puff(int whichlabel);
     void FootLand(bodypart whichfoot, float opacity);
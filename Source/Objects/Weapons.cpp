@@ -102,14 +102,15 @@ void Weapon::Load()
 {
     LOG("Loading weapon data... ");
 
-    knifetextureptr.load("Textures/Knife.png", 0);
-    bloodknifetextureptr.load("Textures/BloodKnife.png", 0);
-    lightbloodknifetextureptr.load("Textures/BloodKnifeLight.png", 0);
-    swordtextureptr.load("Textures/Sword.jpg", 1);
-    bloodswordtextureptr.load("Textures/SwordBlood.jpg", 1);
-    lightbloodswordtextureptr.load("Textures/SwordBloodLight.jpg", 1);
-    stafftextureptr.load("Textures/Staff.jpg", 1);
-
+    knifetextureptr.loadAsync("Textures/Knife.png", 0);
+    bloodknifetextureptr.loadAsync("Textures/BloodKnife.png", 0);
+    lightbloodknifetextureptr.loadAsync("Textures/BloodKnifeLight.png", 0);
+    swordtextureptr.loadAsync("Textures/Sword.jpg", 1);
+    bloodswordtextureptr.loadAsync("Textures/SwordBlood.jpg", 1);
+    lightbloodswordtextureptr.loadAsync("Textures/SwordBloodLight.jpg", 1);
+    stafftextureptr.loadAsync("Textures/Staff.jpg", 1);
+
+    Game::LoadingScreen();
     throwingknifemodel.load("Models/ThrowingKnife.solid");
     throwingknifemodel.Scale(.001, .001, .001);
     throwingknifemodel.Rotate(90, 0, 0);
@@ -117,6 +118,7 @@ void Weapon::Load()
     throwingknifemodel.flat = 0;
     throwingknifemodel.CalculateNormals(1);
 
+    Game::LoadingScreen();
     swordmodel.load("Models/Sword.solid");
     swordmodel.Scale(.001, .001, .001);
     swordmodel.Rotate(90, 0, 0);
@@ -125,6 +127,7 @@ void Weapon::Load()
     swordmodel.flat = 1;
     swordmodel.CalculateNormals(1);
 
+    Game::LoadingScreen();
     staffmodel.load("Models/Staff.solid");
     staffmodel.Scale(.005, .005, .005);
     staffmodel.Rotate(90, 0, 0);
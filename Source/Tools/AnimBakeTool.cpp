@@ -0,0 +1,55 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Bakes the animations of a pack directory into its animation database:
+ *
+ *   lugaru-animbake Data/Lugaru [Data/Lugaru/Animations/Animations.lad]
+ *
+ * The game views animations straight out of the database, those edited
+ * since it was baked keep being loaded from their own file.
+ */
+
+#include "Animation/AnimationDatabase.hpp"
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <pack directory> [output database]" << std::endl;
+        return 1;
+    }
+
+    std::string packDir = argv[1];
+    while (packDir.size() > 1 && (packDir.back() == '/' || packDir.back() == '\\')) {
+        packDir.pop_back();
+    }
+    std::string output = (argc == 3) ? argv[2] : packDir + "/" + AnimationDatabase::kFileName;
+
+    int count = AnimationDatabase::build(packDir + "/Animations", output);
+    if (count < 0) {
+        std::cerr << "Baking animations of " << packDir << " failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Baked " << count << " animations from " << packDir << " into " << output << std::endl;
+    return 0;
+}
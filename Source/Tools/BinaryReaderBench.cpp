@@ -0,0 +1,145 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Compares funpackf with BinaryReader on big-endian vertex and index data:
+ *
+ *   lugaru-bench-binio [vertex count]
+ *
+ * The data is written with fpackf, then decoded the way loaders used to
+ * (one funpackf call per vertex) and the way they do now.
+ */
+
+#include "Utils/BinaryReader.hpp"
+#include "Utils/binio.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+static const int repeats = 5;
+
+/* Best wall time of a few runs, in milliseconds */
+static double bestOf(const std::function<void()>& run)
+{
+    double best = 0;
+    for (int i = 0; i < repeats; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static void report(const char* name, double ms, double reference)
+{
+    std::cout << "  " << name << ": " << ms << " ms (" << reference / ms << "x)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const int vertexNum = (argc > 1) ? atoi(argv[1]) : 200000;
+    if (vertexNum <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [vertex count]" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> coords(vertexNum * 3);
+    std::vector<short> indices(vertexNum * 3);
+    for (size_t i = 0; i < coords.size(); i++) {
+        coords[i] = (float)rand() / RAND_MAX * 200.0f - 100.0f;
+        indices[i] = (short)(rand() % vertexNum);
+    }
+
+    FILE* tfile = tmpfile();
+    if (tfile == NULL) {
+        std::cerr << "Unable to create a temporary file" << std::endl;
+        return 1;
+    }
+    for (int i = 0; i < vertexNum; i++) {
+        fpackf(tfile, "Bf Bf Bf", coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2]);
+    }
+    for (size_t i = 0; i < indices.size(); i++) {
+        fpackf(tfile, "Bs", indices[i]);
+    }
+    fflush(tfile);
+
+    std::vector<unsigned char> bytes(ftell(tfile));
+    rewind(tfile);
+    if (fread(bytes.data(), 1, bytes.size(), tfile) != bytes.size()) {
+        std::cerr << "Unable to read back the temporary file" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> funpackfCoords(coords.size()), readCoords(coords.size()), arrayCoords(coords.size());
+    std::vector<short> funpackfIndices(indices.size()), readIndices(indices.size()), arrayIndices(indices.size());
+
+    double funpackfTime = bestOf([&]() {
+        rewind(tfile);
+        for (int i = 0; i < vertexNum; i++) {
+            funpackf(tfile, "Bf Bf Bf", &funpackfCoords[i * 3], &funpackfCoords[i * 3 + 1], &funpackfCoords[i * 3 + 2]);
+        }
+        for (size_t i = 0; i < indices.size(); i++) {
+            funpackf(tfile, "Bs", &funpackfIndices[i]);
+        }
+    });
+
+    double readTime = bestOf([&]() {
+        BinaryReader reader(bytes.data(), bytes.size());
+        for (size_t i = 0; i < coords.size(); i++) {
+            readCoords[i] = reader.read<float_be>();
+        }
+        for (size_t i = 0; i < indices.size(); i++) {
+            readIndices[i] = reader.read<int16_be>();
+        }
+    });
+
+    double arrayTime = bestOf([&]() {
+        BinaryReader reader(bytes.data(), bytes.size());
+        reader.read_array<float_be>(arrayCoords.data(), arrayCoords.size());
+        reader.read_array<int16_be>(arrayIndices.data(), arrayIndices.size());
+    });
+
+    fclose(tfile);
+
+    bool identical = true;
+    for (const std::vector<float>* decoded : { &funpackfCoords, &readCoords, &arrayCoords }) {
+        identical = identical && memcmp(decoded->data(), coords.data(), coords.size() * sizeof(float)) == 0;
+    }
+    for (const std::vector<short>* decoded : { &funpackfIndices, &readIndices, &arrayIndices }) {
+        identical = identical && memcmp(decoded->data(), indices.data(), indices.size() * sizeof(short)) == 0;
+    }
+
+    std::cout << "Decoding " << vertexNum << " vertices and " << indices.size() << " indices (" << bytes.size() << " bytes), best of " << repeats << ":" << std::endl;
+    report("funpackf          ", funpackfTime, funpackfTime);
+    report("read<T>           ", readTime, funpackfTime);
+    report("read_array<T>     ", arrayTime, funpackfTime);
+
+    if (!identical) {
+        std::cerr << "Decoded values differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,413 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Checks GL code paths against the ones they stand in for, offscreen:
+ *
+ *   lugaru-check-gl
+ *
+ * Runs on a surfaceless EGL display, so without a window or X server. On
+ * Mesa that is the llvmpipe software rasterizer, which makes the pixels the
+ * same from one machine to the next. Returns non-zero if any check fails.
+ *
+ * skinning: the same posed and morphed meshes drawn lit by SkinnedMesh and
+ * by Skinning on the CPU through Model::drawdifftex, pixel for pixel.
+ *
+ * skin flush, bleeding trail: every level of a skin with blood painted in a
+ * few tiles, as SkinTexture::flush() left it, against a full
+ * SkinTexture::upload() of the same painting, byte for byte. Needs Data/ in the current directory, like
+ * the game.
+ */
+
+#include "Animation/Skinning.hpp"
+#include "Graphic/Models.hpp"
+#include "Graphic/SkinTexture.hpp"
+#include "Graphic/SkinnedMesh.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Game state the linked sources expect
+float multiplier = .01;
+bool trilinear = true;
+bool decalstoggle = true;
+int kContextWidth = 256;
+int kContextHeight = 256;
+
+namespace Game {
+void LoadingScreen()
+{
+}
+}
+
+void LOG(const std::string&, ...)
+{
+}
+
+static const int viewSize = 256;
+
+#define FRAMEBUFFER_GL_FUNCTIONS(X)                                    \
+    X(PFNGLGENFRAMEBUFFERSPROC, GenFramebuffers)                       \
+    X(PFNGLBINDFRAMEBUFFERPROC, BindFramebuffer)                       \
+    X(PFNGLGENRENDERBUFFERSPROC, GenRenderbuffers)                     \
+    X(PFNGLBINDRENDERBUFFERPROC, BindRenderbuffer)                     \
+    X(PFNGLRENDERBUFFERSTORAGEPROC, RenderbufferStorage)               \
+    X(PFNGLFRAMEBUFFERRENDERBUFFERPROC, FramebufferRenderbuffer)       \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC, CheckFramebufferStatus)
+
+#define DECLARE_GL_FUNCTION(type, name) static type gl##name##Ptr = nullptr;
+FRAMEBUFFER_GL_FUNCTIONS(DECLARE_GL_FUNCTION)
+#undef DECLARE_GL_FUNCTION
+
+static void* getProcAddress(const char* name)
+{
+    return (void*)eglGetProcAddress(name);
+}
+
+/* Surfaceless context drawing into a viewSize square framebuffer with a depth buffer */
+static bool createContext()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay == nullptr) {
+        std::cerr << "EGL has no eglGetPlatformDisplayEXT" << std::endl;
+        return false;
+    }
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "No surfaceless EGL display with OpenGL" << std::endl;
+        return false;
+    }
+    EGLContext context = eglCreateContext(display, (EGLConfig)0, EGL_NO_CONTEXT, nullptr);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "Could not create an OpenGL context without a surface" << std::endl;
+        return false;
+    }
+
+    bool found = true;
+#define LOAD_GL_FUNCTION(type, name)                          \
+    gl##name##Ptr = (type)getProcAddress("gl" #name);         \
+    found = found && gl##name##Ptr != nullptr;
+    FRAMEBUFFER_GL_FUNCTIONS(LOAD_GL_FUNCTION)
+#undef LOAD_GL_FUNCTION
+    if (!found) {
+        std::cerr << "OpenGL has no framebuffer objects" << std::endl;
+        return false;
+    }
+
+    GLuint framebuffer, color, depth;
+    glGenFramebuffersPtr(1, &framebuffer);
+    glBindFramebufferPtr(GL_FRAMEBUFFER, framebuffer);
+    glGenRenderbuffersPtr(1, &color);
+    glBindRenderbufferPtr(GL_RENDERBUFFER, color);
+    glRenderbufferStoragePtr(GL_RENDERBUFFER, GL_RGBA8, viewSize, viewSize);
+    glFramebufferRenderbufferPtr(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glGenRenderbuffersPtr(1, &depth);
+    glBindRenderbufferPtr(GL_RENDERBUFFER, depth);
+    glRenderbufferStoragePtr(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, viewSize, viewSize);
+    glFramebufferRenderbufferPtr(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if (glCheckFramebufferStatusPtr(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+        return false;
+    }
+    glViewport(0, 0, viewSize, viewSize);
+
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    return true;
+}
+
+static std::vector<GLubyte> readPixels()
+{
+    std::vector<GLubyte> pixels(viewSize * viewSize * 4);
+    glReadPixels(0, 0, viewSize, viewSize, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+/* Pixels differing by more than tolerance in any channel, and the largest difference */
+static int countDifferences(const std::vector<GLubyte>& a, const std::vector<GLubyte>& b, int tolerance, int& maxDifference)
+{
+    int count = 0;
+    maxDifference = 0;
+    for (size_t i = 0; i < a.size(); i += 4) {
+        int difference = 0;
+        for (size_t c = 0; c < 3; c++) {
+            difference = std::max(difference, std::abs(a[i + c] - b[i + c]));
+        }
+        maxDifference = std::max(maxDifference, difference);
+        if (difference > tolerance) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/* One UV sphere per muscle in muscle space, owning all of its vertices */
+static void buildSpheres(int muscleNum, Model& model, std::vector<std::vector<int>>& muscleVertices)
+{
+    const int rings = 12;
+    const int segments = 16;
+    const int perSphere = (rings + 1) * (segments + 1);
+
+    model.type = normaltype;
+    model.vertexNum = muscleNum * perSphere;
+    model.owner = (int*)malloc(sizeof(int) * model.vertexNum);
+    model.vertex = (XYZ*)malloc(sizeof(XYZ) * model.vertexNum);
+    model.normals = (XYZ*)malloc(sizeof(XYZ) * model.vertexNum);
+    muscleVertices.assign(muscleNum, std::vector<int>());
+
+    for (int m = 0; m < muscleNum; m++) {
+        const int first = m * perSphere;
+        for (int r = 0; r <= rings; r++) {
+            const float pitch = M_PI * r / rings;
+            for (int s = 0; s <= segments; s++) {
+                const float yaw = 2 * M_PI * s / segments;
+                const int v = first + r * (segments + 1) + s;
+                model.normals[v].x = sin(pitch) * cos(yaw);
+                model.normals[v].y = cos(pitch);
+                model.normals[v].z = sin(pitch) * sin(yaw);
+                model.vertex[v] = model.normals[v];
+                model.owner[v] = m;
+                muscleVertices[m].push_back(v);
+            }
+        }
+        for (int r = 0; r < rings; r++) {
+            for (int s = 0; s < segments; s++) {
+                const int v = first + r * (segments + 1) + s;
+                const int quad[2][3] = { { v, v + segments + 1, v + 1 }, { v + 1, v + segments + 1, v + segments + 2 } };
+                for (const int* corners : quad) {
+                    TexturedTriangle triangle;
+                    for (int k = 0; k < 3; k++) {
+                        triangle.vertex[k] = corners[k];
+                        triangle.gx[k] = 0;
+                        triangle.gy[k] = 0;
+                    }
+                    model.Triangles.push_back(triangle);
+                }
+            }
+        }
+    }
+    model.vArray = (GLfloat*)malloc(sizeof(GLfloat) * model.Triangles.size() * 24);
+    model.UpdateVertexArray();
+}
+
+/* Lighting like the game's: GL_LIGHT0 as a directional light tinting glColor */
+static void setupScene()
+{
+    glClearColor(0, 0, 0, 1);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(-4, 4, -4, 4, -10, 10);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glRotatef(20, 1, 0, 0);
+
+    const GLfloat position[4] = { .3, .8, .5, 0 };
+    const GLfloat ambient[4] = { .2, .2, .25, 1 };
+    const GLfloat diffuse[4] = { .9, .85, .8, 1 };
+    glLightfv(GL_LIGHT0, GL_POSITION, position);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, ambient);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_COLOR_MATERIAL);
+    glColor4f(.8, .7, .6, 1);
+}
+
+static bool checkSkinning()
+{
+    const int muscleNum = 4;
+    Model bind;
+    std::vector<std::vector<int>> muscleVertices;
+    buildSpheres(muscleNum, bind, muscleVertices);
+    Model draw(bind);
+
+    // The first sphere morphs towards a squashed copy, normals staying as they are
+    std::vector<XYZ> morphTarget(bind.vertex, bind.vertex + bind.vertexNum);
+    for (int v : muscleVertices[0]) {
+        morphTarget[v].y *= .5;
+    }
+    const float morphness = .6;
+
+    // Far from uniform proportions, which is what bends the normals
+    std::vector<Matrix4> muscles(muscleNum);
+    std::vector<XYZ> proportions(muscleNum);
+    for (int m = 0; m < muscleNum; m++) {
+        muscles[m].translate((m % 2) ? 1.8 : -1.8, (m / 2) ? 1.8 : -1.8, 0);
+        muscles[m].rotate(25 + 40 * m, 0, 1, 0);
+        muscles[m].rotate(30 - 15 * m, 1, 0, 1);
+        proportions[m].x = 1.5 - .2 * m;
+        proportions[m].y = .6 + .25 * m;
+        proportions[m].z = 1;
+    }
+    const float scale = .9;
+
+    SkinnedMesh mesh;
+    if (!SkinnedMesh::init(getProcAddress) || !mesh.build(bind, draw, muscleNum)) {
+        std::cerr << "skinning: SkinnedMesh doesn't run on this driver" << std::endl;
+        return false;
+    }
+
+    for (int m = 0; m < muscleNum; m++) {
+        const SkinMatrix skin(muscles[m], proportions[m], scale);
+        const SkinMatrix normalSkin = SkinMatrix::forNormals(muscles[m], proportions[m]);
+        const std::vector<int>& vertices = muscleVertices[m];
+        if (m == 0) {
+            Skinning::transform(skin, bind.vertex, morphTarget.data(), morphness, vertices.data(), vertices.size(), draw.vertex);
+            mesh.morph(m, bind.vertex, morphTarget.data(), morphness, vertices);
+        } else {
+            Skinning::transform(skin, bind.vertex, vertices.data(), vertices.size(), draw.vertex);
+        }
+        Skinning::transformNormals(normalSkin, bind.normals, vertices.data(), vertices.size(), draw.normals);
+        mesh.setMuscle(m, skin);
+    }
+    draw.UpdateVertexArrayNoTex();
+
+    setupScene();
+    draw.drawdifftex(Texture());
+    const std::vector<GLubyte> cpu = readPixels();
+
+    setupScene();
+    mesh.draw(Texture(), false);
+    const std::vector<GLubyte> gpu = readPixels();
+
+    int covered = 0;
+    for (size_t i = 0; i < cpu.size(); i += 4) {
+        if (cpu[i] || cpu[i + 1] || cpu[i + 2]) {
+            covered++;
+        }
+    }
+    // Float rounding moves a few edge pixels and shading by a level
+    int maxDifference;
+    const int differing = countDifferences(cpu, gpu, 2, maxDifference);
+    std::cout << "skinning: " << covered << " pixels covered, " << differing << " differ by more than 2 levels, largest difference " << maxDifference << std::endl;
+    if (covered < viewSize * viewSize / 10 || differing > covered / 200) {
+        std::cerr << "skinning: SkinnedMesh and CPU skinning draw different pixels" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* Every level of the bound texture as RGB, level 0 first */
+static std::vector<std::vector<GLubyte>> readLevels(int size)
+{
+    std::vector<std::vector<GLubyte>> levels;
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int level = 0; (size >> level) > 0; level++) {
+        const int width = size >> level;
+        levels.push_back(std::vector<GLubyte>(width * width * 3));
+        glGetTexImage(GL_TEXTURE_2D, level, GL_RGB, GL_UNSIGNED_BYTE, levels.back().data());
+    }
+    return levels;
+}
+
+/* Blood drop of the given radius in pixels, darker towards its middle */
+static void paintDrop(SkinTexture& skin, int row, int column, int radius)
+{
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            if (x * x + y * y > radius * radius) {
+                continue;
+            }
+            GLubyte* texel = skin.paint(row + y, column + x);
+            if (texel != nullptr) {
+                texel[0] = 80 + 4 * (x * x + y * y);
+                texel[1] = 0;
+                texel[2] = 0;
+            }
+        }
+    }
+}
+
+/* Paints with paint, flushing whenever it returns true, and compares every level
+ * with a full upload of the same painting */
+static bool checkFlush(const std::string& name, const std::function<bool(SkinTexture&, int)>& paint, int steps)
+{
+    SkinTexture flushed, uploaded;
+    if (!flushed.load("Textures/FurBrown.jpg") || !uploaded.load("Textures/FurBrown.jpg")) {
+        std::cerr << name << ": no skin to paint on, run from the directory holding Data" << std::endl;
+        return false;
+    }
+    Texture flushedTexture, uploadedTexture;
+    flushed.upload(flushedTexture);
+    int flushes = 0;
+    for (int step = 0; step < steps; step++) {
+        paint(uploaded, step);
+        if (paint(flushed, step)) {
+            flushed.flush(flushedTexture);
+            flushes++;
+        }
+    }
+    flushed.flush(flushedTexture);
+    uploaded.upload(uploadedTexture);
+
+    flushedTexture.bind();
+    const std::vector<std::vector<GLubyte>> flushedLevels = readLevels(flushed.getSize());
+    uploadedTexture.bind();
+    const std::vector<std::vector<GLubyte>> uploadedLevels = readLevels(uploaded.getSize());
+
+    int differing = 0;
+    for (size_t level = 0; level < flushedLevels.size(); level++) {
+        for (size_t i = 0; i < flushedLevels[level].size(); i++) {
+            if (flushedLevels[level][i] != uploadedLevels[level][i]) {
+                differing++;
+            }
+        }
+    }
+    std::cout << name << ": " << flushedLevels.size() << " levels after " << flushes + 1 << " flushes, " << differing << " bytes differ from a full upload" << std::endl;
+    if (differing > 0) {
+        std::cerr << name << ": SkinTexture::flush() and upload() leave different levels" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    if (!createContext()) {
+        return 1;
+    }
+
+    bool ok = true;
+    ok = checkSkinning() && ok;
+
+    // Drops scattered over several tiles, one of them painted twice, then a single flush
+    ok = checkFlush("skin flush", [](SkinTexture& skin, int step) {
+        const int drops[5][3] = { { 40, 40, 6 }, { 31, 200, 4 }, { 300, 95, 9 }, { 40, 44, 3 }, { 480, 470, 12 } };
+        paintDrop(skin, drops[step][0], drops[step][1], drops[step][2]);
+        return false;
+    }, 5) && ok;
+
+    // A bleeding trail like DoStuff paints, a small drop a frame wandering over
+    // tiles already flushed, with a flush after every frame
+    ok = checkFlush("bleeding trail", [](SkinTexture& skin, int step) {
+        paintDrop(skin, 100 + step * 3 + (step % 7), 20 + step * 5 - (step % 4) * 3, 2);
+        return true;
+    }, 60) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Packs the asset folders of a pack directory into a single archive:
+ *
+ *   lugaru-pack Data/Lugaru [Data/Lugaru.lpk]
+ *
+ * The game picks up Data/<Pack>.lpk automatically, loose files in the
+ * pack folder keep overriding archived ones.
+ */
+
+#include "Utils/PackArchive.hpp"
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <pack directory> [output" << PackArchive::kExtension << "]" << std::endl;
+        return 1;
+    }
+
+    std::string packDir = argv[1];
+    while (packDir.size() > 1 && (packDir.back() == '/' || packDir.back() == '\\')) {
+        packDir.pop_back();
+    }
+    std::string output = (argc == 3) ? argv[2] : packDir + PackArchive::kExtension;
+
+    int count = PackArchive::build(packDir, output);
+    if (count < 0) {
+        std::cerr << "Packing " << packDir << " failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Packed " << count << " files from " << packDir << " into " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,260 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Compares CPU skinning with the per-vertex matrix stack it replaced:
+ *
+ *   lugaru-bench-skinning [vertex count] [muscle count]
+ *
+ * The reference pushes a copy of each muscle matrix per vertex and reads
+ * back its translation, the way Person::DrawSkeleton used the GL stack.
+ *
+ * Before timing anything it also checks Matrix4 itself against the
+ * glRotatef/glTranslatef sequence Skeleton::buildTemplate used to bake the
+ * rest pose, computed in double precision from the OpenGL 2.1 definitions.
+ */
+
+#include "Animation/Skinning.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+static const int repeats = 5;
+
+/* Best wall time of a few runs, in milliseconds */
+static double bestOf(const std::function<void()>& run)
+{
+    double best = 0;
+    for (int i = 0; i < repeats; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static float randomFloat(float range)
+{
+    return (float)rand() / RAND_MAX * range * 2 - range;
+}
+
+static void report(const char* name, double ms, double reference, int vertexNum)
+{
+    std::cout << "  " << name << ": " << ms << " ms, " << vertexNum / ms / 1000 << " Mvertices/s (" << reference / ms << "x)" << std::endl;
+}
+
+/* Double precision model of the fixed-function modelview matrix, column-major */
+class GLStackReference
+{
+public:
+    double m[16];
+
+    GLStackReference()
+    {
+        for (int i = 0; i < 16; i++) {
+            m[i] = (i % 5 == 0) ? 1 : 0;
+        }
+    }
+
+    /* glRotatef: current matrix times R, R as given by the specification */
+    void glRotate(double angle, double x, double y, double z)
+    {
+        double length = std::sqrt(x * x + y * y + z * z);
+        x /= length;
+        y /= length;
+        z /= length;
+        double c = std::cos(angle * M_PI / 180);
+        double s = std::sin(angle * M_PI / 180);
+        double r[16] = {
+            x * x * (1 - c) + c, y * x * (1 - c) + z * s, x * z * (1 - c) - y * s, 0,
+            x * y * (1 - c) - z * s, y * y * (1 - c) + c, y * z * (1 - c) + x * s, 0,
+            x * z * (1 - c) + y * s, y * z * (1 - c) - x * s, z * z * (1 - c) + c, 0,
+            0, 0, 0, 1
+        };
+        multiply(r);
+    }
+
+    /* glTranslatef: current matrix times T */
+    void glTranslate(double x, double y, double z)
+    {
+        double t[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1 };
+        multiply(t);
+    }
+
+private:
+    void multiply(const double* other)
+    {
+        double result[16];
+        for (int col = 0; col < 4; col++) {
+            for (int row = 0; row < 4; row++) {
+                result[col * 4 + row] = 0;
+                for (int k = 0; k < 4; k++) {
+                    result[col * 4 + row] += m[k * 4 + row] * other[col * 4 + k];
+                }
+            }
+        }
+        for (int i = 0; i < 16; i++) {
+            m[i] = result[i];
+        }
+    }
+};
+
+/* Largest difference between Matrix4 and the GL sequence the rest pose bake replaced:
+ * load identity, rotate by rotate3, rotate2 - 90 and rotate1 - 90, translate by the
+ * vertex and read back the translation column */
+static double restPoseError(int count)
+{
+    double maxError = 0;
+    for (int i = 0; i < count; i++) {
+        const float rotate1 = randomFloat(180) + 180;
+        const float rotate2 = randomFloat(90);
+        const float rotate3 = randomFloat(180) + 180;
+        XYZ vertex;
+        vertex.x = randomFloat(1);
+        vertex.y = randomFloat(1);
+        vertex.z = randomFloat(1);
+
+        Matrix4 rotation;
+        rotation.rotate(rotate3, 0, 1, 0);
+        rotation.rotate(rotate2 - 90, 0, 0, 1);
+        rotation.rotate(rotate1 - 90, 0, 1, 0);
+        const XYZ baked = rotation.transformPoint(vertex);
+
+        GLStackReference stack;
+        stack.glRotate(rotate3, 0, 1, 0);
+        stack.glRotate(rotate2 - 90, 0, 0, 1);
+        stack.glRotate(rotate1 - 90, 0, 1, 0);
+        stack.glTranslate(vertex.x, vertex.y, vertex.z);
+
+        maxError = std::max(maxError, std::fabs(stack.m[12] - baked.x));
+        maxError = std::max(maxError, std::fabs(stack.m[13] - baked.y));
+        maxError = std::max(maxError, std::fabs(stack.m[14] - baked.z));
+    }
+    return maxError;
+}
+
+int main(int argc, char** argv)
+{
+    const int vertexNum = (argc > 1) ? atoi(argv[1]) : 200000;
+    const int muscleNum = (argc > 2) ? atoi(argv[2]) : 20;
+    if (vertexNum <= 0 || muscleNum <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [vertex count] [muscle count]" << std::endl;
+        return 1;
+    }
+
+    const double restError = restPoseError(100000);
+    std::cout << "Rest pose bake against the glRotatef/glTranslatef sequence, max error: " << restError << std::endl;
+    if (restError > 1e-5) {
+        std::cerr << "Matrix4 differs from the GL matrix stack" << std::endl;
+        return 1;
+    }
+
+    std::vector<XYZ> rest(vertexNum), morphTarget(vertexNum);
+    for (int i = 0; i < vertexNum; i++) {
+        rest[i].x = randomFloat(1);
+        rest[i].y = randomFloat(1);
+        rest[i].z = randomFloat(1);
+        morphTarget[i] = rest[i];
+        morphTarget[i].y += randomFloat(0.1);
+    }
+
+    // Muscles own interleaved vertices like the loaded models do
+    std::vector<std::vector<int>> muscles(muscleNum);
+    for (int i = 0; i < vertexNum; i++) {
+        muscles[rand() % muscleNum].push_back(i);
+    }
+
+    std::vector<Matrix4> muscleMatrices(muscleNum);
+    std::vector<XYZ> proportions(muscleNum);
+    for (int i = 0; i < muscleNum; i++) {
+        muscleMatrices[i].rotate(randomFloat(10), 1, 0, 0);
+        muscleMatrices[i].translate(randomFloat(5), randomFloat(5), randomFloat(5));
+        muscleMatrices[i].rotate(randomFloat(180), 0, 1, 0);
+        muscleMatrices[i].rotate(randomFloat(180), 0, 0, 1);
+        proportions[i].x = 1 + randomFloat(0.2);
+        proportions[i].y = 1 + randomFloat(0.2);
+        proportions[i].z = 1 + randomFloat(0.2);
+    }
+    const float scale = 0.2;
+    const float morphness = 0.3;
+
+    std::vector<XYZ> stackOutput(vertexNum), skinOutput(vertexNum), morphStackOutput(vertexNum), morphSkinOutput(vertexNum);
+
+    auto stack = [&](bool morph, std::vector<XYZ>& out) {
+        for (int i = 0; i < muscleNum; i++) {
+            for (int index : muscles[i]) {
+                XYZ v = rest[index];
+                if (morph) {
+                    v = rest[index] * (1 - morphness) + morphTarget[index] * morphness;
+                }
+                Matrix4 pushed = muscleMatrices[i];
+                pushed.translate(v * proportions[i]);
+                out[index].x = pushed.m[12] * scale;
+                out[index].y = pushed.m[13] * scale;
+                out[index].z = pushed.m[14] * scale;
+            }
+        }
+    };
+
+    double stackTime = bestOf([&]() { stack(false, stackOutput); });
+    double skinTime = bestOf([&]() {
+        for (int i = 0; i < muscleNum; i++) {
+            SkinMatrix skin(muscleMatrices[i], proportions[i], scale);
+            Skinning::transform(skin, rest.data(), muscles[i].data(), muscles[i].size(), skinOutput.data());
+        }
+    });
+    double morphStackTime = bestOf([&]() { stack(true, morphStackOutput); });
+    double morphSkinTime = bestOf([&]() {
+        for (int i = 0; i < muscleNum; i++) {
+            SkinMatrix skin(muscleMatrices[i], proportions[i], scale);
+            Skinning::transform(skin, rest.data(), morphTarget.data(), morphness, muscles[i].data(), muscles[i].size(), morphSkinOutput.data());
+        }
+    });
+
+    float maxError = 0;
+    for (int i = 0; i < vertexNum; i++) {
+        maxError = std::max(maxError, std::fabs(stackOutput[i].x - skinOutput[i].x));
+        maxError = std::max(maxError, std::fabs(stackOutput[i].y - skinOutput[i].y));
+        maxError = std::max(maxError, std::fabs(stackOutput[i].z - skinOutput[i].z));
+        maxError = std::max(maxError, std::fabs(morphStackOutput[i].x - morphSkinOutput[i].x));
+        maxError = std::max(maxError, std::fabs(morphStackOutput[i].y - morphSkinOutput[i].y));
+        maxError = std::max(maxError, std::fabs(morphStackOutput[i].z - morphSkinOutput[i].z));
+    }
+
+    std::cout << "Skinning " << vertexNum << " vertices on " << muscleNum << " muscles, best of " << repeats << ":" << std::endl;
+    report("matrix stack      ", stackTime, stackTime, vertexNum);
+    report("Skinning          ", skinTime, stackTime, vertexNum);
+    report("matrix stack morph", morphStackTime, morphStackTime, vertexNum);
+    report("Skinning morph    ", morphSkinTime, morphStackTime, vertexNum);
+    std::cout << "  max error: " << maxError << std::endl;
+
+    if (maxError > 1e-4) {
+        std::cerr << "Skinned vertices differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
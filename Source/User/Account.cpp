@@ -21,6 +21,8 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "User/Account.hpp"
 
 #include "Platform/Platform.hpp"
+#include "Utils/BinaryReader.hpp"
+#include "Utils/Folders.hpp"
 #include "Utils/binio.h"
 
 #include <fstream>
@@ -48,34 +50,33 @@ Account::Account(const string& name)
     setCurrentCampaign("Lugaru");
 }
 
-Account::Account(FILE* tfile)
+/* Read a string stored as its length followed by its characters */
+static string readString(BinaryReader& reader)
+{
+    int length = reader.read<int32_be>();
+    if (length <= 0) {
+        return string();
+    }
+    vector<unsigned char> chars = reader.read_array<uint8_be>(length);
+    return string(chars.begin(), chars.end());
+}
+
+Account::Account(BinaryReader& reader)
     : Account("")
 {
-    funpackf(tfile, "Bi", &difficulty);
-    funpackf(tfile, "Bi", &progress);
-    int nbCampaigns;
-    funpackf(tfile, "Bi", &nbCampaigns);
+    difficulty = reader.read<int32_be>();
+    progress = reader.read<int32_be>();
+    int nbCampaigns = reader.read<int32_be>();
 
     for (int k = 0; k < nbCampaigns; ++k) {
-        string campaignName = "";
-        int t;
-        char c;
-        funpackf(tfile, "Bi", &t);
-        for (int j = 0; j < t; j++) {
-            funpackf(tfile, "Bb", &c);
-            campaignName.append(1, c);
-        }
-        float fscore, fhighscore;
-        funpackf(tfile, "Bf", &(campaignProgress[campaignName].time));
-        funpackf(tfile, "Bf", &(fscore));
-        funpackf(tfile, "Bf", &(campaignProgress[campaignName].fasttime));
-        funpackf(tfile, "Bf", &(fhighscore));
-        campaignProgress[campaignName].score = fscore;
-        campaignProgress[campaignName].highscore = fhighscore;
-        int campaignchoicesmade, campaignchoice;
-        funpackf(tfile, "Bi", &campaignchoicesmade);
+        string campaignName = readString(reader);
+        campaignProgress[campaignName].time = reader.read<float_be>();
+        campaignProgress[campaignName].score = reader.read<float_be>();
+        campaignProgress[campaignName].fasttime = reader.read<float_be>();
+        campaignProgress[campaignName].highscore = reader.read<float_be>();
+        int campaignchoicesmade = reader.read<int32_be>();
         for (int j = 0; j < campaignchoicesmade; j++) {
-            funpackf(tfile, "Bi", &campaignchoice);
+            int campaignchoice = reader.read<int32_be>();
             if (campaignchoice >= 10) { // what is that for?
                 campaignchoice = 0;
             }
@@ -83,32 +84,17 @@ Account::Account(FILE* tfile)
         }
     }
 
-    currentCampaign = "";
-    int t;
-    char c;
-    funpackf(tfile, "Bi", &t);
-    for (int i = 0; i < t; i++) {
-        funpackf(tfile, "Bb", &c);
-        currentCampaign.append(1, c);
-    }
+    currentCampaign = readString(reader);
 
-    funpackf(tfile, "Bf", &points);
+    points = reader.read<float_be>();
     for (int i = 0; i < 50; i++) {
-        float fscore;
-        funpackf(tfile, "Bf", &(fscore));
-        funpackf(tfile, "Bf", &(fasttime[i]));
-        highscore[i] = fscore;
+        highscore[i] = reader.read<float_be>();
+        fasttime[i] = reader.read<float_be>();
     }
     for (int i = 0; i < 60; i++) {
-        funpackf(tfile, "Bb", &(unlocked[i]));
-    }
-    int temp;
-    char ctemp;
-    funpackf(tfile, "Bi", &temp);
-    for (int i = 0; i < temp; i++) {
-        funpackf(tfile, "Bb", &ctemp);
-        name.append(1, ctemp);
+        unlocked[i] = reader.read<uint8_be>();
     }
+    name = readString(reader);
     if (name.empty()) {
         name = "Lugaru Player"; // no empty player name security.
     }
@@ -241,23 +227,20 @@ void Account::winLevel(int level, int score, float time) {
 
 void Account::loadFile(string filename)
 {
-    FILE* tfile;
+    BinaryReader reader;
     int numaccounts;
     int iactive;
     errno = 0;
 
-    tfile = fopen(filename.c_str(), "rb");
-
-    if (tfile) {
-        funpackf(tfile, "Bi", &numaccounts);
-        funpackf(tfile, "Bi", &iactive);
+    if (Folders::openReader(filename, reader)) {
+        numaccounts = reader.read<int32_be>();
+        iactive = reader.read<int32_be>();
         printf("Loading %d accounts\n", numaccounts);
         for (int i = 0; i < numaccounts; i++) {
             printf("Loading account %d/%d\n", i, numaccounts);
-            accounts.emplace_back(tfile);
+            accounts.emplace_back(reader);
         }
 
-        fclose(tfile);
         setActive(iactive);
     } else {
         perror(("Couldn't load users from " + filename).c_str());
@@ -26,6 +26,8 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <vector>
 
+class BinaryReader;
+
 struct CampaignProgress
 {
     int highscore;
@@ -57,7 +59,7 @@ public:
     static Account& active();
 
     Account(const std::string& name = "");
-    Account(FILE* tfile);
+    Account(BinaryReader& reader);
 
     void endGame();
     void winCampaignLevel(int choice, int score, float time);
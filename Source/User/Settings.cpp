@@ -37,6 +37,7 @@ void DefaultSettings()
     floatjump = 0;
     autoslomo = 1;
     decalstoggle = true;
+    gpuskinning = 0;
     invertmouse = 0;
     bloodtoggle = 0;
     foliage = 1;
@@ -143,6 +144,8 @@ void SaveSettings()
     opstream << immediate;
     opstream << "\nVelocity blur:\n";
     opstream << velocityblur;
+    opstream << "\nGPU skinning:\n";
+    opstream << gpuskinning;
     opstream << "\nVolume:\n";
     opstream << volume;
     opstream << "\nForward key:\n";
@@ -258,6 +261,8 @@ bool LoadSettings()
             ipstream >> immediate;
         } else if (!strncmp(setting, "Velocity blur", 13)) {
             ipstream >> velocityblur;
+        } else if (!strncmp(setting, "GPU skinning", 12)) {
+            ipstream >> gpuskinning;
         } else if (!strncmp(setting, "Volume", 6)) {
             ipstream >> volume;
         } else if (!strncmp(setting, "Forward key", 11)) {
@@ -34,6 +34,7 @@ extern bool foliage;
 extern bool musictoggle;
 extern bool trilinear;
 extern bool decalstoggle;
+extern bool gpuskinning;
 extern bool invertmouse;
 extern float gamespeed;
 extern float oldgamespeed;
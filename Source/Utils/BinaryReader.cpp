@@ -0,0 +1,142 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/BinaryReader.hpp"
+
+#include <utility>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+BinaryReader::BinaryReader()
+    : data(nullptr)
+    , size(0)
+    , position(0)
+    , truncated(false)
+{
+}
+
+BinaryReader::BinaryReader(const unsigned char* _data, size_t _size)
+    : data(_data)
+    , size(_size)
+    , position(0)
+    , truncated(false)
+{
+}
+
+void BinaryReader::reset(const unsigned char* _data, size_t _size)
+{
+    buffer.clear();
+    data = _data;
+    size = _size;
+    position = 0;
+    truncated = false;
+}
+
+void BinaryReader::reset(std::vector<unsigned char>&& bytes)
+{
+    buffer = std::move(bytes);
+    data = buffer.data();
+    size = buffer.size();
+    position = 0;
+    truncated = false;
+}
+
+void BinaryReader::rewind()
+{
+    position = 0;
+    truncated = false;
+}
+
+void BinaryReader::swap(BinaryReader& other)
+{
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    std::swap(position, other.position);
+    std::swap(truncated, other.truncated);
+    buffer.swap(other.buffer);
+}
+
+void BinaryReader::skip(size_t bytes)
+{
+    if (size - position < bytes) {
+        position = size;
+        truncated = true;
+    } else {
+        position += bytes;
+    }
+}
+
+void BinaryReader::convert16(void* destination, const unsigned char* source, size_t count)
+{
+    unsigned char* out = (unsigned char*)destination;
+    size_t i = 0;
+
+#if defined(__SSSE3__)
+    const __m128i order = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(source + i * 2));
+        _mm_storeu_si128((__m128i*)(out + i * 2), _mm_shuffle_epi8(values, order));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(source + i * 2));
+        values = _mm_or_si128(_mm_slli_epi16(values, 8), _mm_srli_epi16(values, 8));
+        _mm_storeu_si128((__m128i*)(out + i * 2), values);
+    }
+#endif
+
+    for (; i < count; i++) {
+        const unsigned char* p = source + i * 2;
+        const uint16_t bits = (uint16_t(p[0]) << 8) | uint16_t(p[1]);
+        memcpy(out + i * 2, &bits, 2);
+    }
+}
+
+void BinaryReader::convert32(void* destination, const unsigned char* source, size_t count)
+{
+    unsigned char* out = (unsigned char*)destination;
+    size_t i = 0;
+
+#if defined(__SSSE3__)
+    const __m128i order = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(source + i * 4));
+        _mm_storeu_si128((__m128i*)(out + i * 4), _mm_shuffle_epi8(values, order));
+    }
+#elif defined(__SSE2__)
+    // Swap the bytes of each 16 bit half, then the halves
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(source + i * 4));
+        values = _mm_or_si128(_mm_slli_epi16(values, 8), _mm_srli_epi16(values, 8));
+        values = _mm_shufflehi_epi16(_mm_shufflelo_epi16(values, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*)(out + i * 4), values);
+    }
+#endif
+
+    for (; i < count; i++) {
+        const unsigned char* p = source + i * 4;
+        const uint32_t bits = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+        memcpy(out + i * 4, &bits, 4);
+    }
+}
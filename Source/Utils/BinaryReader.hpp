@@ -0,0 +1,156 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _BINARY_READER_HPP_
+#define _BINARY_READER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/* How values are stored in a file, the counterpart of funpackf's "Bb", "Bs", "Bi" and "Bf" */
+struct uint8_be
+{
+    typedef unsigned char value_type;
+    static const size_t size = 1;
+};
+
+struct int16_be
+{
+    typedef short value_type;
+    static const size_t size = 2;
+};
+
+struct int32_be
+{
+    typedef int value_type;
+    static const size_t size = 4;
+};
+
+struct float_be
+{
+    typedef float value_type;
+    static const size_t size = 4;
+};
+
+/* Sequential reads over a whole file held in memory, replacing funpackf on load paths.
+ *
+ * The layout comes from the types used in the code instead of a format string
+ * parsed at runtime, and arrays get converted to host order in bulk. Reading
+ * past the end yields zeros and marks the reader as truncated.
+ */
+class BinaryReader
+{
+public:
+    BinaryReader();
+    /* View size bytes owned by the caller */
+    BinaryReader(const unsigned char* data, size_t size);
+
+    /* Start over on other bytes, viewed or owned */
+    void reset(const unsigned char* data, size_t size);
+    void reset(std::vector<unsigned char>&& bytes);
+    /* Read the same bytes again from the start */
+    void rewind();
+    /* Exchange bytes and position with another reader, owned bytes don't move */
+    void swap(BinaryReader& other);
+
+    template <typename T>
+    typename T::value_type read()
+    {
+        typename T::value_type value;
+        if (size - position < T::size) {
+            position = size;
+            truncated = true;
+            return typename T::value_type();
+        }
+        const unsigned char* p = data + position;
+        position += T::size;
+        // Shifts build host order values whatever the host is, compilers turn them into one swap
+        if (T::size == 1) {
+            memcpy((void*)&value, p, 1);
+        } else if (T::size == 2) {
+            const uint16_t bits = (uint16_t(p[0]) << 8) | uint16_t(p[1]);
+            memcpy((void*)&value, &bits, 2);
+        } else {
+            const uint32_t bits = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+            memcpy((void*)&value, &bits, 4);
+        }
+        return value;
+    }
+
+    template <typename T>
+    void read_array(typename T::value_type* values, size_t count)
+    {
+        const size_t available = std::min(count, (size - position) / T::size);
+        decode<T>(values, data + position, available);
+        position += available * T::size;
+        if (available < count) {
+            memset((void*)(values + available), 0, (count - available) * sizeof(typename T::value_type));
+            position = size;
+            truncated = true;
+        }
+    }
+
+    template <typename T>
+    std::vector<typename T::value_type> read_array(size_t count)
+    {
+        std::vector<typename T::value_type> values(count);
+        read_array<T>(values.data(), count);
+        return values;
+    }
+
+    void skip(size_t bytes);
+    size_t tell() const { return position; }
+    size_t getSize() const { return size; }
+    bool isTruncated() const { return truncated; }
+    bool atEnd() const { return position >= size; }
+
+    /* Byte swapped copies of count big-endian values, vectorized where the CPU allows */
+    static void convert16(void* destination, const unsigned char* source, size_t count);
+    static void convert32(void* destination, const unsigned char* source, size_t count);
+
+    /* Make sure BinaryReader never gets copied, data may point into its own buffer */
+    BinaryReader(BinaryReader const& other) = delete;
+    BinaryReader& operator=(BinaryReader const& other) = delete;
+
+private:
+    const unsigned char* data;
+    size_t size;
+    size_t position;
+    bool truncated;
+    std::vector<unsigned char> buffer;
+
+    template <typename T>
+    static void decode(typename T::value_type* values, const unsigned char* source, size_t count)
+    {
+        static_assert(sizeof(typename T::value_type) == T::size, "stored and host sizes must match");
+        if (T::size == 1) {
+            memcpy((void*)values, source, count);
+        } else if (T::size == 2) {
+            convert16(values, source, count);
+        } else {
+            convert32(values, source, count);
+        }
+    }
+};
+
+#endif
@@ -1,9 +1,13 @@
 #include "Folders.hpp"
+#include "Utils/BinaryReader.hpp"
+#include "Utils/PackArchive.hpp"
 #include <cerrno>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <unistd.h>
 #include <map>
+#include <mutex>
 #include <string>
 #include <sstream>
 #include <fstream>
@@ -13,6 +17,7 @@
 #include <unordered_set>
 #include <algorithm> // Needed for std::sort
 #include <nlohmann/json.hpp> // Include JSON library
+#include <zlib.h>
 
 #if PLATFORM_UNIX
 #include <pwd.h>
@@ -26,6 +31,14 @@
 #endif
 
 const std::string Folders::dataDir = DATA_DIR;
+std::unordered_map<std::string, std::string> Folders::resourceIndex;
+std::atomic<bool> Folders::resourceIndexDirty(true);
+std::atomic<unsigned> Folders::resourceGeneration(0);
+std::map<std::string, std::unique_ptr<PackArchive>> Folders::archives;
+std::shared_mutex Folders::resourceMutex;
+
+// Separates the archive file from the entry name in resolved paths, e.g. "Data/Lugaru.lpk!/Models/Body.solid"
+static const std::string archiveSeparator = "!/";
 
 // Function to read ModInfo from JSON (not needed anymore but kept as reference)
 ModInfo ModInfo::fromJson(const std::string& jsonFilePath) {
@@ -129,6 +142,7 @@ void Folders::createPackListFile() {
     // Write the updated PackList.json
     std::ofstream packListFile(packListPath);
     packListFile << packListJson.dump(4);  // Pretty print
+    invalidateResourceIndex();
 }
 
 void Folders::updatePackList() {
@@ -228,86 +242,294 @@ void Folders::updatePackList() {
         std::ofstream outFile(packListPath);
         outFile << packListJson.dump(4); // Pretty print with 4 spaces
         std::cout << "PackList.json updated successfully." << std::endl;
+        invalidateResourceIndex();
     }
 }
 
-std::string Folders::getResourcePath(const std::string& relativePath) {
-    std::string packListPath = dataDir + "/PackList.json";
+void Folders::invalidateResourceIndex() {
+    resourceIndexDirty = true;
+    resourceGeneration++;
+}
 
-    // Read PackList.json to get the list of mods and texture packs
-    nlohmann::json packListJson;
-    std::ifstream packListFile(packListPath);
-    if (!packListFile.is_open()) {
-        std::cerr << "Unable to open PackList.json." << std::endl;
-        return "";
+// Strip leading separators and any "Data/" prefix left over from an already resolved path
+std::string Folders::normalizeResourcePath(const std::string& relativePath) {
+    std::string path = relativePath;
+    std::replace(path.begin(), path.end(), '\\', '/');
+
+    const std::string dataPrefix = dataDir + "/";
+    bool stripped = true;
+    while (stripped) {
+        stripped = false;
+        // Checked before the slashes so resolved paths below an absolute data dir map back to their key
+        if (path.compare(0, dataPrefix.size(), dataPrefix) == 0) {
+            path.erase(0, dataPrefix.size());
+            stripped = true;
+        }
+        while (!path.empty() && path[0] == '/') {
+            path.erase(0, 1);
+            stripped = true;
+        }
+        if (path.compare(0, 2, "./") == 0) {
+            path.erase(0, 2);
+            stripped = true;
+        }
     }
-    packListFile >> packListJson;
-    packListFile.close();
 
-    // Check texture packs first
-    const auto& texturePacks = packListJson["Packs"]["TexturePacks"];
-    for (const auto& texturePack : texturePacks) {
-        if (texturePack["Status"] == "Enabled") {
-            std::string packName = texturePack["ModName"];
-            std::string texturePackPath = dataDir + "/" + packName + "/" + relativePath;
+    size_t doubleSlash;
+    while ((doubleSlash = path.find("//")) != std::string::npos) {
+        path.erase(doubleSlash, 1);
+    }
+
+    return toLower(path);
+}
 
-            std::string foundFile = findFileCaseInsensitive(texturePackPath);
-            if (!foundFile.empty()) {
-                return foundFile;  // Return the path if a texture pack contains the file
+// Add every regular file below root to the index, unless a higher priority layer already claimed it
+void Folders::indexDirectory(const std::string& root, const std::string& keyPrefix) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) {
+        return;
+    }
+
+    for (auto it = std::filesystem::recursive_directory_iterator(root, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        std::string relative = it->path().lexically_relative(root).generic_string();
+        std::string fullPath = root + "/" + relative;
+        resourceIndex.emplace(toLower(keyPrefix + relative), fullPath);
+    }
+}
+
+// Loose files take precedence over the pack archive so mods can still override single assets
+void Folders::indexPack(const std::string& packDir, const std::string& keyPrefix) {
+    indexDirectory(packDir, keyPrefix);
+    indexArchive(packDir + PackArchive::kExtension, keyPrefix);
+}
+
+void Folders::indexArchive(const std::string& archivePath, const std::string& keyPrefix) {
+    auto found = archives.find(archivePath);
+    if (found == archives.end()) {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(archivePath, ec)) {
+            return;
+        }
+        std::unique_ptr<PackArchive> archive(new PackArchive());
+        if (!archive->open(archivePath)) {
+            std::cerr << "Unable to open pack archive " << archivePath << std::endl;
+            return;
+        }
+        found = archives.emplace(archivePath, std::move(archive)).first;
+    }
+
+    for (const PackArchive::Entry& entry : found->second->getEntries()) {
+        resourceIndex.emplace(toLower(keyPrefix) + entry.key, archivePath + archiveSeparator + entry.name);
+    }
+}
+
+bool Folders::splitArchivePath(const std::string& path, std::string& archivePath, std::string& entryName) {
+    size_t separator = path.find(archiveSeparator);
+    if (separator == std::string::npos) {
+        return false;
+    }
+    archivePath = path.substr(0, separator);
+    entryName = path.substr(separator + archiveSeparator.size());
+    return archives.find(archivePath) != archives.end();
+}
+
+bool Folders::getArchivedResource(const std::string& filepath, const unsigned char** data, size_t* size) {
+    std::shared_lock<std::shared_mutex> lock(resourceMutex);
+    std::string archivePath, entryName;
+    if (!splitArchivePath(filepath, archivePath, entryName)) {
+        return false;
+    }
+    const PackArchive& archive = *archives.find(archivePath)->second;
+    const PackArchive::Entry* entry = archive.find(entryName);
+    if (entry == nullptr) {
+        return false;
+    }
+    *data = archive.data(*entry);
+    *size = entry->size;
+    return true;
+}
+
+bool Folders::getResourceStamp(const std::string& filepath, uint64_t* size, int64_t* mtime) {
+    std::string archivePath, entryName;
+    std::string stampedFile = filepath;
+    {
+        std::shared_lock<std::shared_mutex> lock(resourceMutex);
+        if (splitArchivePath(filepath, archivePath, entryName)) {
+            const PackArchive::Entry* entry = archives.find(archivePath)->second->find(entryName);
+            if (entry == nullptr) {
+                return false;
             }
+            *size = entry->size;
+            stampedFile = archivePath;
+        }
+    }
+
+    std::error_code ec;
+    auto time = std::filesystem::last_write_time(stampedFile, ec);
+    if (ec) {
+        return false;
+    }
+    if (stampedFile == filepath) {
+        *size = std::filesystem::file_size(filepath, ec);
+        if (ec) {
+            return false;
+        }
+    }
+    *mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    return true;
+}
+
+bool Folders::getResourceHash(const std::string& filepath, uint64_t* key) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    uint64_t size = 0;
+
+    const unsigned char* archived;
+    size_t archivedSize;
+    if (getArchivedResource(filepath, &archived, &archivedSize)) {
+        for (size_t offset = 0; offset < archivedSize;) {
+            const uInt chunk = std::min<size_t>(archivedSize - offset, 1 << 20);
+            crc = crc32(crc, archived + offset, chunk);
+            offset += chunk;
+        }
+        size = archivedSize;
+    } else {
+        FILE* tfile = fopen(filepath.c_str(), "rb");
+        if (tfile == NULL) {
+            return false;
+        }
+        unsigned char buffer[65536];
+        size_t count;
+        while ((count = fread(buffer, 1, sizeof(buffer), tfile)) > 0) {
+            crc = crc32(crc, buffer, count);
+            size += count;
+        }
+        const bool failed = ferror(tfile);
+        fclose(tfile);
+        if (failed) {
+            return false;
+        }
+    }
+
+    *key = (size << 32) ^ crc;
+    return true;
+}
+
+std::string Folders::getCachePath(const std::string& filepath, const std::string& suffix) {
+    std::string archivePath, entryName;
+    bool archived;
+    {
+        std::shared_lock<std::shared_mutex> lock(resourceMutex);
+        archived = splitArchivePath(filepath, archivePath, entryName);
+    }
+    if (!archived) {
+        std::string directory = std::filesystem::path(filepath).parent_path().string();
+        if (access(directory.empty() ? "." : directory.c_str(), W_OK) == 0) {
+            return filepath + suffix;
+        }
+    }
+
+    std::string flattened = filepath;
+    std::replace(flattened.begin(), flattened.end(), '/', '_');
+    std::replace(flattened.begin(), flattened.end(), '\\', '_');
+    std::replace(flattened.begin(), flattened.end(), '!', '_');
+    std::replace(flattened.begin(), flattened.end(), ':', '_');
+
+    std::string cacheDir = getUserDataPath() + "/Cache";
+    makeDirectory(cacheDir);
+    return cacheDir + "/" + flattened + suffix;
+}
+
+void Folders::updateResourceIndex() {
+    if (!resourceIndexDirty) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(resourceMutex);
+    if (resourceIndexDirty) {
+        rebuildResourceIndex();
+    }
+}
+
+// Callers hold resourceMutex exclusively
+void Folders::rebuildResourceIndex() {
+    resourceIndex.clear();
+    resourceIndexDirty = false;
+
+    nlohmann::json packListJson;
+    std::ifstream packListFile(dataDir + "/PackList.json");
+    if (packListFile.is_open()) {
+        try {
+            packListFile >> packListJson;
+        } catch (const std::exception& e) {
+            std::cerr << "Unable to parse PackList.json: " << e.what() << std::endl;
+            packListJson = nlohmann::json::object();
         }
+        packListFile.close();
+    } else {
+        std::cerr << "Unable to open PackList.json." << std::endl;
     }
 
-    // Check mods if not found in texture packs
-    const auto& mods = packListJson["Packs"]["Mods"];
+    const nlohmann::json emptyList = nlohmann::json::array();
+    const auto& packs = packListJson.value("Packs", nlohmann::json::object());
+    const auto& texturePacks = packs.contains("TexturePacks") ? packs["TexturePacks"] : emptyList;
+    const auto& mods = packs.contains("Mods") ? packs["Mods"] : emptyList;
+
+    // Texture packs override everything
+    for (const auto& texturePack : texturePacks) {
+        if (texturePack.value("Status", "") == "Enabled") {
+            std::string packName = texturePack.value("ModName", "");
+            indexPack(dataDir + "/" + packName, "");
+        }
+    }
 
-     // Check if relativePath starts with a pack name
+    // Paths explicitly naming a pack ("Lugaru/Campaign.json") go straight to that pack folder
     for (const auto& mod : mods) {
-        std::string modName = mod["ModName"];
-
-        // If relativePath starts with modName, search directly in that mod
-        if (relativePath.find(modName + "/") == 0) {
-            std::string specificModPath = dataDir + "/" + relativePath;
-
-            // Check if the file exists using case-insensitive search
-            std::string foundFile = findFileCaseInsensitive(specificModPath);
-            if (!foundFile.empty()) {
-                return foundFile; // Return if found directly in the specific mod path
-            } else {
-                std::cerr << "File not found in specified mod: " << modName << std::endl;
-                return ""; // Return empty if the file is not found in the specified mod
-            }
+        std::string modName = mod.value("ModName", "");
+        if (!modName.empty()) {
+            indexPack(dataDir + "/" + modName, modName + "/");
         }
     }
 
+    // Then enabled mods, in PackList.json order
     for (const auto& mod : mods) {
-        if (mod["Status"] == "Enabled") {
-            std::string modName = mod["ModName"];
-            std::string modFolderPath = dataDir + "/" + modName + "/" + relativePath;
+        if (mod.value("Status", "") == "Enabled") {
+            std::string modName = mod.value("ModName", "");
+            indexPack(dataDir + "/" + modName, "");
+        }
+    }
 
-            std::string foundFile = findFileCaseInsensitive(modFolderPath);
-            if (!foundFile.empty()) {
-                return foundFile;
-            }
+    // Finally the base game folders in Data, including archives of packs missing from the list
+    indexDirectory(dataDir, "");
+    std::error_code ec;
+    for (auto it = std::filesystem::directory_iterator(dataDir, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        if (it->path().extension() == PackArchive::kExtension) {
+            indexArchive(dataDir + "/" + it->path().filename().string(), it->path().stem().string() + "/");
         }
     }
 
-    // Check base game folders in Data
-    std::string baseGamePath = dataDir + "/" + relativePath;
-    if (baseGamePath.find("Data/Data/") != std::string::npos) {
-        baseGamePath.replace(baseGamePath.find("Data/Data/"), 10, "Data/");
+    std::cout << "Resource index built with " << resourceIndex.size() << " entries." << std::endl;
+}
+
+std::string Folders::getResourcePath(const std::string& relativePath) {
+    updateResourceIndex();
+
+    std::shared_lock<std::shared_mutex> lock(resourceMutex);
+    std::string archivePath, entryName;
+    if (splitArchivePath(relativePath, archivePath, entryName)) {
+        return relativePath; // Already resolved into an archive
     }
 
-    std::string foundFile = findFileCaseInsensitive(baseGamePath);
-    if (!foundFile.empty()) {
-        return foundFile;
+    auto found = resourceIndex.find(normalizeResourcePath(relativePath));
+    if (found != resourceIndex.end()) {
+        return found->second;
     }
 
-    std::cerr << "Resource not found in any path." << std::endl;
+    std::cerr << "Resource not found in any path: " << relativePath << std::endl;
     return "";
 }
 
-
 bool Folders::makeDirectory(const std::string& path) {
 #ifdef _WIN32
     int status = CreateDirectory(path.c_str(), NULL);
@@ -319,15 +541,87 @@ bool Folders::makeDirectory(const std::string& path) {
 #endif
 }
 
+FILE* Folders::openFile(const std::string& filename, const char* mode) {
+    std::string archivePath, entryName;
+    bool archived;
+    {
+        std::shared_lock<std::shared_mutex> lock(resourceMutex);
+        archived = splitArchivePath(filename, archivePath, entryName);
+    }
+    if (!archived) {
+        return fopen(filename.c_str(), mode);
+    }
+
+    const unsigned char* data;
+    size_t size;
+    if (strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+') || !getArchivedResource(filename, &data, &size)) {
+        errno = ENOENT;
+        return NULL;
+    }
+#if PLATFORM_UNIX
+    // Reads are served straight from the mapping
+    if (size > 0) {
+        return fmemopen((void*)data, size, "rb");
+    }
+    return tmpfile();
+#else
+    FILE* tfile = tmpfile();
+    if (tfile != NULL) {
+        fwrite(data, 1, size, tfile);
+        rewind(tfile);
+    }
+    return tfile;
+#endif
+}
+
 FILE* Folders::openMandatoryFile(const std::string& filename, const char* mode) {
-    FILE* tfile = fopen(filename.c_str(), mode);
+    FILE* tfile = openFile(filename, mode);
     if (tfile == NULL) {
         throw FileNotFoundException(filename);
     }
     return tfile;
 }
 
+bool Folders::openReader(const std::string& filename, BinaryReader& reader) {
+    const unsigned char* data;
+    size_t size;
+    if (getArchivedResource(filename, &data, &size)) {
+        reader.reset(data, size);
+        return true;
+    }
+
+    FILE* tfile = fopen(filename.c_str(), "rb");
+    if (tfile == NULL) {
+        return false;
+    }
+    std::vector<unsigned char> bytes;
+    fseek(tfile, 0, SEEK_END);
+    long length = ftell(tfile);
+    fseek(tfile, 0, SEEK_SET);
+    bool ok = length >= 0;
+    if (ok && length > 0) {
+        bytes.resize(length);
+        ok = fread(bytes.data(), 1, length, tfile) == (size_t)length;
+    }
+    fclose(tfile);
+    if (ok) {
+        reader.reset(std::move(bytes));
+    }
+    return ok;
+}
+
+void Folders::openMandatoryReader(const std::string& filename, BinaryReader& reader) {
+    if (!openReader(filename, reader)) {
+        throw FileNotFoundException(filename);
+    }
+}
+
 bool Folders::file_exists(const std::string& filepath) {
+    const unsigned char* data;
+    size_t size;
+    if (getArchivedResource(filepath, &data, &size)) {
+        return true;
+    }
     FILE* file = fopen(filepath.c_str(), "rb");
     if (file == NULL) {
         return false;
@@ -1,6 +1,8 @@
 #ifndef _FOLDERS_HPP_
 #define _FOLDERS_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <algorithm> // Needed for std::transform
@@ -8,8 +10,15 @@
 #include <exception>
 #include <nlohmann/json.hpp>
 #include <filesystem>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
 #include <unordered_set>
 
+class BinaryReader;
+class PackArchive;
+
 #ifndef DATA_DIR
 #define DATA_DIR "Data"
 #endif
@@ -49,9 +58,33 @@ public:
     // Update existing PackList.json by adding new packs and optionally removing old ones
     static void updatePackList();
 
+    // Mark the resource index stale so the next lookup rebuilds it from PackList.json
+    static void invalidateResourceIndex();
+    // Bumped whenever packs or mods change, state derived from resources compares it
+    static unsigned getResourceGeneration() { return resourceGeneration; }
+
+    // Both accept paths inside pack archives as returned by getResourcePath
+    static FILE* openFile(const std::string& filename, const char* mode);
     static FILE* openMandatoryFile(const std::string& filename, const char* mode);
+    // Whole file in memory for BinaryReader, archived resources are viewed in place
+    static bool openReader(const std::string& filename, BinaryReader& reader);
+    static void openMandatoryReader(const std::string& filename, BinaryReader& reader);
     static bool file_exists(const std::string& filepath);
 
+    // Direct view of a resource stored in a pack archive, false for loose files
+    static bool getArchivedResource(const std::string& filepath, const unsigned char** data, size_t* size);
+
+    // Size and modification time of a resolved resource, used to invalidate baked caches
+    static bool getResourceStamp(const std::string& filepath, uint64_t* size, int64_t* mtime);
+
+    // Size and CRC-32 of a resolved resource, so caches never serve edited or replaced
+    // files while identical files shared by several packs or mods use the same entry
+    static bool getResourceHash(const std::string& filepath, uint64_t* key);
+
+    // Where to store a cache derived from a resolved resource: next to it when
+    // possible, in the user cache folder for archived or read-only resources
+    static std::string getCachePath(const std::string& filepath, const std::string& suffix);
+
         static inline std::string getUserSavePath()
     {
         return getUserDataPath() + "/users";
@@ -61,6 +94,29 @@ public:
     static std::string findFileCaseInsensitive(const std::string& path);
 
 private:
+    // Overlay of texture packs, then mods, then base Data, keyed by lowercased relative path
+    static std::unordered_map<std::string, std::string> resourceIndex;
+    static std::atomic<bool> resourceIndexDirty;
+    static std::atomic<unsigned> resourceGeneration;
+
+    // Mapped Data/<Pack>.lpk archives, only ever added to so views handed out by
+    // getArchivedResource stay valid across index rebuilds until exit
+    static std::map<std::string, std::unique_ptr<PackArchive>> archives;
+
+    // Guards resourceIndex and archives, loader and sound workers resolve resources
+    // while the main thread may rebuild the index after the packs changed
+    static std::shared_mutex resourceMutex;
+
+    static void updateResourceIndex();
+
+    static void rebuildResourceIndex();
+    static void indexPack(const std::string& packDir, const std::string& keyPrefix);
+    static void indexDirectory(const std::string& root, const std::string& keyPrefix);
+    static void indexArchive(const std::string& archivePath, const std::string& keyPrefix);
+    // Callers hold resourceMutex
+    static bool splitArchivePath(const std::string& path, std::string& archivePath, std::string& entryName);
+    static std::string normalizeResourcePath(const std::string& relativePath);
+
     static std::string toLower(const std::string& str);
     static std::string getGenericDirectory(const char* ENVVAR, const std::string& fallback);
 #if PLATFORM_UNIX
@@ -38,25 +38,64 @@ static bool load_jpg(const char* fname, ImageRec& tex);
 static bool save_screenshot_png(const char* fname);
 
 ImageRec::ImageRec()
+    : data(NULL)
+    , bpp(0)
+    , sizeX(0)
+    , sizeY(0)
+    , dropAlpha(false)
+    , destination(NULL)
+    , capacity(0)
+{
+}
+
+ImageRec::ImageRec(GLubyte* _destination, size_t _capacity)
+    : data(NULL)
+    , bpp(0)
+    , sizeX(0)
+    , sizeY(0)
+    , dropAlpha(false)
+    , destination(_destination)
+    , capacity(_capacity)
 {
-    data = (GLubyte*)malloc(1024 * 1024 * 4);
 }
 
 ImageRec::~ImageRec()
 {
-    free(data);
+    if (data != destination) {
+        free(data);
+    }
     data = NULL;
 }
 
-bool load_image(const char* file_name, ImageRec& tex)
+bool ImageRec::allocate(GLuint width, GLuint height, GLuint _bpp)
 {
-    Game::LoadingScreen();
-
-    // Early return if no data is allocated for the image
-    if (tex.data == NULL) {
-        std::cerr << "Texture data is NULL for file: " << file_name << std::endl;
+    // Refuse sizes whose byte count would overflow, no real texture comes close
+    if (width == 0 || height == 0 || width > 16384 || height > 16384) {
         return false;
     }
+    size_t size = size_t(width) * height * (_bpp / 8);
+
+    if (destination != NULL) {
+        if (size > capacity) {
+            return false;
+        }
+        data = destination;
+    } else {
+        free(data);
+        data = (GLubyte*)malloc(size);
+        if (data == NULL) {
+            return false;
+        }
+    }
+    sizeX = width;
+    sizeY = height;
+    bpp = _bpp;
+    return true;
+}
+
+bool load_image(const char* file_name, ImageRec& tex)
+{
+    Game::LoadingScreen();
 
     // Use getResourcePath to find the correct path for the texture file
     std::string resource_path = Folders::getResourcePath(file_name);  // Directly pass file_name
@@ -67,13 +106,18 @@ bool load_image(const char* file_name, ImageRec& tex)
         return false;
     }
 
+    return decode_image(resource_path.c_str(), tex);
+}
+
+bool decode_image(const char* resource_path, ImageRec& tex)
+{
     // Check the file extension and load the image based on its type
-    const char* ptr = strrchr(resource_path.c_str(), '.');  // Get the file extension
+    const char* ptr = strrchr(resource_path, '.');  // Get the file extension
     if (ptr) {
         if (strcasecmp(ptr + 1, "png") == 0) {
-            return load_png(resource_path.c_str(), tex);  // Load PNG file
+            return load_png(resource_path, tex);  // Load PNG file
         } else if (strcasecmp(ptr + 1, "jpg") == 0) {
-            return load_jpg(resource_path.c_str(), tex);  // Load JPG file
+            return load_jpg(resource_path, tex);  // Load JPG file
         }
     }
 
@@ -116,7 +160,7 @@ static bool load_jpg(const char* file_name, ImageRec& tex)
     JSAMPROW buffer[1]; /* Output row buffer */
     int row_stride;     /* physical row width in output buffer */
     errno = 0;
-    FILE* infile = fopen(file_name, "rb");
+    FILE* infile = Folders::openFile(file_name, "rb");
 
     if (infile == NULL) {
         perror((std::string("Couldn't open file ") + file_name).c_str());
@@ -141,9 +185,12 @@ static bool load_jpg(const char* file_name, ImageRec& tex)
     (void)jpeg_start_decompress(&cinfo);
 
     row_stride = cinfo.output_width * cinfo.output_components;
-    tex.sizeX = cinfo.output_width;
-    tex.sizeY = cinfo.output_height;
-    tex.bpp = 24;
+    if (!tex.allocate(cinfo.output_width, cinfo.output_height, 24)) {
+        cerr << "Unsupported image size for " << file_name << endl;
+        jpeg_destroy_decompress(&cinfo);
+        fclose(infile);
+        return false;
+    }
 
     while (cinfo.output_scanline < cinfo.output_height) {
         buffer[0] = (JSAMPROW)(char*)tex.data +
@@ -158,18 +205,16 @@ static bool load_jpg(const char* file_name, ImageRec& tex)
     return true;
 }
 
-/* stolen from public domain example.c code in libpng distribution. */
+/* Reads the header first so rows can be decoded straight into a buffer of the right size */
 static bool load_png(const char* file_name, ImageRec& tex)
 {
-    bool hasalpha = false;
     png_structp png_ptr = NULL;
     png_infop info_ptr = NULL;
     png_uint_32 width, height;
     int bit_depth, color_type, interlace_type;
     bool retval = false;
-    png_byte** row_pointers = NULL;
     errno = 0;
-    FILE* fp = fopen(file_name, "rb");
+    FILE* fp = Folders::openFile(file_name, "rb");
 
     if (fp == NULL) {
         perror((std::string("Couldn't open file ") + file_name).c_str());
@@ -191,56 +236,49 @@ static bool load_png(const char* file_name, ImageRec& tex)
     }
 
     png_init_io(png_ptr, fp);
-    png_read_png(png_ptr, info_ptr,
-                 PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING,
-                 NULL);
+    png_read_info(png_ptr, info_ptr);
     png_get_IHDR(png_ptr, info_ptr, &width, &height,
                  &bit_depth, &color_type, &interlace_type, NULL, NULL);
 
-    if (bit_depth != 8) { // transform SHOULD handle this...
-        goto png_done;
+    // Let libpng bring every layout down to 8 bit RGB or RGBA while it decodes rows
+    png_set_strip_16(png_ptr);
+    png_set_packing(png_ptr);
+    if (color_type == PNG_COLOR_TYPE_PALETTE) {
+        png_set_palette_to_rgb(png_ptr);
     }
-
-    if (color_type & PNG_COLOR_MASK_PALETTE) { // !!! FIXME?
-        goto png_done;
+    if ((color_type & PNG_COLOR_MASK_COLOR) == 0) {
+        png_set_expand_gray_1_2_4_to_8(png_ptr);
+        png_set_gray_to_rgb(png_ptr);
+    }
+    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+        png_set_tRNS_to_alpha(png_ptr);
     }
+    if (tex.dropAlpha) {
+        png_set_strip_alpha(png_ptr);
+    } else {
+        png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+    }
+    png_set_interlace_handling(png_ptr);
+    png_read_update_info(png_ptr, info_ptr);
 
-    if ((color_type & PNG_COLOR_MASK_COLOR) == 0) { // !!! FIXME?
+    if (png_get_rowbytes(png_ptr, info_ptr) != width * (tex.dropAlpha ? 3 : 4)) {
         goto png_done;
     }
-
-    hasalpha = ((color_type & PNG_COLOR_MASK_ALPHA) != 0);
-    row_pointers = png_get_rows(png_ptr, info_ptr);
-    if (!row_pointers) {
+    if (!tex.allocate(width, height, tex.dropAlpha ? 24 : 32)) {
         goto png_done;
     }
 
-    if (!hasalpha) {
-        png_byte* dst = tex.data;
-        for (int i = height - 1; i >= 0; i--) {
-            png_byte* src = row_pointers[i];
-            for (unsigned j = 0; j < width; j++) {
-                dst[0] = src[0];
-                dst[1] = src[1];
-                dst[2] = src[2];
-                dst[3] = 0xFF;
-                src += 3;
-                dst += 4;
+    // Rows are stored bottom up, interlaced images just go over them once per pass
+    {
+        int passes = png_set_interlace_handling(png_ptr);
+        size_t pitch = width * (tex.bpp / 8);
+        for (int pass = 0; pass < passes; pass++) {
+            for (png_uint_32 row = 0; row < height; row++) {
+                png_read_row(png_ptr, tex.data + (height - 1 - row) * pitch, NULL);
             }
         }
     }
-
-    else {
-        png_byte* dst = tex.data;
-        int pitch = width * 4;
-        for (int i = height - 1; i >= 0; i--, dst += pitch) {
-            memcpy(dst, row_pointers[i], pitch);
-        }
-    }
-
-    tex.sizeX = width;
-    tex.sizeY = height;
-    tex.bpp = 32;
+    png_read_end(png_ptr, NULL);
     retval = true;
 
 png_done:
@@ -47,16 +47,28 @@ public:
     GLuint bpp;    // Image Color Depth In Bits Per Pixel.
     GLuint sizeX;
     GLuint sizeY;
+    bool dropAlpha; // Decode images with alpha to 24 bits as well
     ImageRec();
+    /* Decode into a caller owned buffer of capacity bytes instead of allocating one */
+    ImageRec(GLubyte* destination, size_t capacity);
     ~ImageRec();
 
+    /* Size data for a width x height image, fails if it doesn't fit the caller's buffer */
+    bool allocate(GLuint width, GLuint height, GLuint bpp);
+
 private:
+    GLubyte* destination;
+    size_t capacity;
+
     /* Make sure this class cannot be copied to avoid memory problems */
     ImageRec(ImageRec const&);
     ImageRec& operator=(ImageRec const&);
 };
 
 bool load_image(const char* fname, ImageRec& tex);
+/* Same as load_image for a path already resolved by Folders::getResourcePath,
+ * doesn't touch GL or the resource index so it can run on any thread */
+bool decode_image(const char* fname, ImageRec& tex);
 bool save_screenshot(const char* fname);
 
 #endif
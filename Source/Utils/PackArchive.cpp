@@ -0,0 +1,277 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/PackArchive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#if PLATFORM_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char PackArchive::kMagic[4] = { 'L', 'G', 'P', 'K' };
+const char* const PackArchive::kExtension = ".lpk";
+
+const std::vector<std::string> PackArchive::packedFolders = {
+    "Animations",
+    "Maps",
+    "Models",
+    "Skeleton",
+    "Sounds",
+    "Textures",
+};
+
+static const size_t headerSize = 16;
+static const size_t tocEntrySize = 24;
+
+static uint32_t readU32(const unsigned char* p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static uint64_t readU64(const unsigned char* p)
+{
+    return uint64_t(readU32(p)) | (uint64_t(readU32(p + 4)) << 32);
+}
+
+static void writeU32(std::ostream& out, uint32_t value)
+{
+    unsigned char bytes[4] = {
+        (unsigned char)(value),
+        (unsigned char)(value >> 8),
+        (unsigned char)(value >> 16),
+        (unsigned char)(value >> 24)
+    };
+    out.write((const char*)bytes, 4);
+}
+
+static void writeU64(std::ostream& out, uint64_t value)
+{
+    writeU32(out, (uint32_t)value);
+    writeU32(out, (uint32_t)(value >> 32));
+}
+
+static uint64_t alignUp(uint64_t value)
+{
+    return (value + PackArchive::kAlignment - 1) & ~uint64_t(PackArchive::kAlignment - 1);
+}
+
+std::string PackArchive::toLower(const std::string& str)
+{
+    std::string lowerStr = str;
+    std::transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(), ::tolower);
+    return lowerStr;
+}
+
+PackArchive::PackArchive()
+    : base(nullptr)
+    , length(0)
+{
+}
+
+PackArchive::~PackArchive()
+{
+    close();
+}
+
+bool PackArchive::open(const std::string& _path)
+{
+    close();
+    path = _path;
+
+#if PLATFORM_UNIX
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)headerSize) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    base = (const unsigned char*)mapping;
+    length = st.st_size;
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (buffer.size() < headerSize) {
+        buffer.clear();
+        return false;
+    }
+    base = buffer.data();
+    length = buffer.size();
+#endif
+
+    uint32_t count = readU32(base + 8);
+    uint32_t namesSize = readU32(base + 12);
+    uint64_t namesOffset = headerSize + uint64_t(count) * tocEntrySize;
+
+    if (memcmp(base, kMagic, 4) != 0 || readU32(base + 4) != kVersion || namesOffset + namesSize > length) {
+        std::cerr << "Invalid pack archive " << path << std::endl;
+        close();
+        return false;
+    }
+
+    const unsigned char* names = base + namesOffset;
+    entries.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const unsigned char* toc = base + headerSize + i * tocEntrySize;
+        Entry& entry = entries[i];
+        entry.offset = readU64(toc);
+        entry.size = readU64(toc + 8);
+        uint32_t nameOffset = readU32(toc + 16);
+        uint32_t nameLength = readU32(toc + 20);
+        if (entry.offset + entry.size > length || uint64_t(nameOffset) + nameLength > namesSize) {
+            std::cerr << "Corrupted entry in pack archive " << path << std::endl;
+            close();
+            return false;
+        }
+        entry.name.assign((const char*)names + nameOffset, nameLength);
+        entry.key = toLower(entry.name);
+    }
+
+    return true;
+}
+
+void PackArchive::close()
+{
+#if PLATFORM_UNIX
+    if (base != nullptr) {
+        munmap((void*)base, length);
+    }
+#else
+    buffer.clear();
+#endif
+    base = nullptr;
+    length = 0;
+    entries.clear();
+}
+
+const PackArchive::Entry* PackArchive::find(const std::string& name) const
+{
+    std::string key = toLower(name);
+    auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                               [](const Entry& entry, const std::string& k) { return entry.key < k; });
+    if (it != entries.end() && it->key == key) {
+        return &(*it);
+    }
+    return nullptr;
+}
+
+int PackArchive::build(const std::string& packDir, const std::string& outputPath)
+{
+    struct Source
+    {
+        std::string name;
+        std::string key;
+        std::filesystem::path file;
+        uint64_t size;
+    };
+    std::vector<Source> sources;
+
+    for (const std::string& folder : packedFolders) {
+        std::filesystem::path root = std::filesystem::path(packDir) / folder;
+        std::error_code ec;
+        if (!std::filesystem::is_directory(root, ec)) {
+            continue;
+        }
+        for (auto it = std::filesystem::recursive_directory_iterator(root, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            // Baked caches are machine specific and get rebuilt from the packed sources
+            if (!it->is_regular_file(ec) || it->path().extension() == ".bake" || it->path().extension() == ".tmp") {
+                continue;
+            }
+            Source source;
+            source.name = it->path().lexically_relative(packDir).generic_string();
+            source.key = toLower(source.name);
+            source.file = it->path();
+            source.size = it->file_size(ec);
+            sources.push_back(source);
+        }
+    }
+
+    std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.key < b.key; });
+    auto duplicate = std::adjacent_find(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.key == b.key; });
+    if (duplicate != sources.end()) {
+        std::cerr << "Files only differing by case can't be packed: " << duplicate->name << std::endl;
+        return -1;
+    }
+
+    uint32_t namesSize = 0;
+    for (const Source& source : sources) {
+        namesSize += source.name.size();
+    }
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Unable to open " << outputPath << " for writing" << std::endl;
+        return -1;
+    }
+
+    out.write(kMagic, 4);
+    writeU32(out, kVersion);
+    writeU32(out, sources.size());
+    writeU32(out, namesSize);
+
+    uint64_t offset = alignUp(headerSize + sources.size() * tocEntrySize + namesSize);
+    uint32_t nameOffset = 0;
+    for (const Source& source : sources) {
+        writeU64(out, offset);
+        writeU64(out, source.size);
+        writeU32(out, nameOffset);
+        writeU32(out, source.name.size());
+        offset = alignUp(offset + source.size);
+        nameOffset += source.name.size();
+    }
+    for (const Source& source : sources) {
+        out.write(source.name.data(), source.name.size());
+    }
+
+    const char padding[kAlignment] = {};
+    for (const Source& source : sources) {
+        uint64_t position = out.tellp();
+        out.write(padding, alignUp(position) - position);
+        if (source.size == 0) {
+            continue;
+        }
+        std::ifstream in(source.file, std::ios::binary);
+        if (!in.is_open() || !(out << in.rdbuf())) {
+            std::cerr << "Unable to pack " << source.file.string() << std::endl;
+            return -1;
+        }
+    }
+
+    return out.good() ? (int)sources.size() : -1;
+}
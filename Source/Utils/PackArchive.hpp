@@ -0,0 +1,94 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _PACK_ARCHIVE_HPP_
+#define _PACK_ARCHIVE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Single-file pack archive (Data/<Pack>.lpk)
+ *
+ * All integers are little-endian.
+ *
+ *   header   "LGPK", u32 version, u32 entry count, u32 names size
+ *   toc      entry count * { u64 data offset, u64 size, u32 name offset, u32 name length }
+ *   names    entry names relative to the pack folder, '/' separated
+ *   data     one blob per entry, each starting on a kAlignment boundary
+ *
+ * The table of contents is sorted by lowercased name so lookups can bisect it.
+ */
+class PackArchive
+{
+public:
+    static const char kMagic[4];
+    static const uint32_t kVersion = 1;
+    static const uint32_t kAlignment = 16;
+    static const char* const kExtension;
+
+    /* Asset folders that get packed, everything else stays loose */
+    static const std::vector<std::string> packedFolders;
+
+    struct Entry
+    {
+        std::string name;
+        std::string key;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    PackArchive();
+    ~PackArchive();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+
+    const std::string& getPath() const { return path; }
+    const std::vector<Entry>& getEntries() const { return entries; }
+
+    /* Case-insensitive lookup, returns nullptr when absent */
+    const Entry* find(const std::string& name) const;
+
+    /* Pointer into the mapping, valid as long as the archive stays open */
+    const unsigned char* data(const Entry& entry) const { return base + entry.offset; }
+
+    /* Write an archive of the packed folders found below packDir, returns the entry count or -1 */
+    static int build(const std::string& packDir, const std::string& outputPath);
+
+    static std::string toLower(const std::string& str);
+
+    /* Make sure PackArchive never gets copied, it owns the mapping */
+    PackArchive(PackArchive const& other) = delete;
+    PackArchive& operator=(PackArchive const& other) = delete;
+
+private:
+    std::string path;
+    std::vector<Entry> entries;
+    const unsigned char* base;
+    size_t length;
+#if !PLATFORM_UNIX
+    std::vector<unsigned char> buffer;
+#endif
+};
+
+#endif
@@ -0,0 +1,149 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Utils/WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+class Pool
+{
+public:
+    Pool()
+        : job(nullptr)
+        , count(0)
+        , next(0)
+        , generation(0)
+        , remaining(0)
+        , stopping(false)
+    {
+        unsigned cores = std::thread::hardware_concurrency();
+        cores = std::max(1u, std::min(8u, cores));
+        for (unsigned i = 1; i < cores; i++) {
+            threads.emplace_back(&Pool::loop, this);
+        }
+    }
+
+    ~Pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void run(size_t jobCount, const std::function<void(size_t)>& jobFunction)
+    {
+        if (jobCount <= 1 || threads.empty()) {
+            for (size_t i = 0; i < jobCount; i++) {
+                jobFunction(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &jobFunction;
+            count = jobCount;
+            next = 0;
+            remaining = threads.size();
+            generation++;
+        }
+        wake.notify_all();
+        work();
+
+        // Every worker has to see this generation through before job goes out of scope
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return remaining == 0; });
+        job = nullptr;
+    }
+
+    unsigned getThreadCount() const
+    {
+        return threads.size() + 1;
+    }
+
+private:
+    void work()
+    {
+        for (size_t i = next++; i < count; i = next++) {
+            (*job)(i);
+        }
+    }
+
+    void loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        unsigned seen = generation;
+        while (true) {
+            wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            lock.unlock();
+            work();
+            lock.lock();
+            if (--remaining == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::vector<std::thread> threads;
+
+    const std::function<void(size_t)>* job;
+    size_t count;
+    std::atomic<size_t> next;
+    unsigned generation;
+    size_t remaining;
+    bool stopping;
+};
+
+Pool& pool()
+{
+    static Pool instance;
+    return instance;
+}
+
+} // namespace
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)>& job)
+{
+    pool().run(count, job);
+}
+
+unsigned WorkerPool::getThreadCount()
+{
+    return pool().getThreadCount();
+}
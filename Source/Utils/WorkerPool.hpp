@@ -0,0 +1,41 @@
+/*
+Copyright (C) 2003, 2010 - Wolfire Games
+Copyright (C) 2010-2017 - Lugaru contributors (see AUTHORS file)
+
+This file is part of Lugaru.
+
+Lugaru is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+Lugaru is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _WORKER_POOL_HPP_
+#define _WORKER_POOL_HPP_
+
+#include <cstddef>
+#include <functional>
+
+/* Worker threads kept around for short data parallel jobs run from the main
+ * thread every frame, where spawning threads each time would eat the gain.
+ */
+class WorkerPool
+{
+public:
+    /* Run job(0) to job(count - 1) spread over the workers and the calling
+     * thread, returns once all of them are done. Jobs must not touch GL. */
+    static void run(size_t count, const std::function<void(size_t)>& job);
+
+    /* Threads taking part in run(), the calling one included */
+    static unsigned getThreadCount();
+};
+
+#endif
@@ -27,7 +27,7 @@ const std::string VERSION_NUMBER = "1.2.1";
 /** Set to "" for stable (tagged) builds, "-dev" for dev builds */
 const std::string VERSION_SUFFIX = "-dev";
 /** Set to 7-char git commit hash if available, otherwise "" */
-const std::string VERSION_HASH = "50cd8f8";
+const std::string VERSION_HASH = "9c3c19d";
 /** Optional release string, e.g. for distro packages release number */
 const std::string VERSION_RELEASE = "";
 
@@ -40,7 +40,7 @@ const std::string VERSION_RELEASE = "";
  *      "1.2-dev (git ab12c34) [OSS Lugaru official]"
  *      "1.3.1 [Mageia 1.3.1-2.mga6]"
  */
-const std::string VERSION_STRING = "1.2.1-dev (git 50cd8f8)";
+const std::string VERSION_STRING = "1.2.1-dev (git 9c3c19d)";
 
 /** Build type (Release, Debug, RelWithDebInfo) to output to the terminal */
-const std::string VERSION_BUILD_TYPE = "";
+const std::string VERSION_BUILD_TYPE = "Release";
@@ -21,6 +21,8 @@ along with Lugaru.  If not, see <http://www.gnu.org/licenses/>.
 #include "Game.hpp"
 
 #include "Audio/openal_wrapper.hpp"
+#include "Graphic/SkinnedMesh.hpp"
+#include "Graphic/TextureLoader.hpp"
 #include "Graphic/gamegl.hpp"
 #include "Platform/Platform.hpp"
 #include "User/Settings.hpp"
@@ -122,6 +124,8 @@ void initGL()
         fprintf(stderr, "Failed to initialize stereo, disabling.\n");
         stereomode = stereoNone;
     }
+
+    SkinnedMesh::init();
 }
 
 void toggleFullscreen()
@@ -452,6 +456,9 @@ void DoUpdate()
 
     TickOnceAfter();
 
+    // Textures loaded asynchronously show up as soon as their image is decoded
+    TextureLoader::uploadPending(4);
+
     if (stereomode == stereoNone) {
         DrawGLScene(stereoCenter);
     } else {